@@ -0,0 +1,879 @@
+/**
+ * @file stm32c0xx_hal.h
+ * @brief Host mock of the STM32C0 HAL subset used by the firmware.
+ *
+ * This header stands in for the vendor HAL when the firmware is built for the
+ * host simulator (host/Makefile). It declares the same types, constants,
+ * macros and functions the firmware sources use, with the same names and
+ * calling conventions, so every file in src/ compiles unchanged.
+ *
+ * Definitions:
+ * - Peripheral register blocks hold only the registers the firmware touches.
+ *   `TIM1`, `GPIOA`, `DMA1_Channel1` and the others point at static mock
+ *   instances (mock_hal.c) instead of fixed addresses, so direct register
+ *   accesses behave like on the target.
+ * - Flag, interrupt and mode constants keep their register bit values where the
+ *   firmware combines or tests them (TIM SR/DIER/CR1, USART CR1/CR3/ISR); the
+ *   rest are arbitrary.
+ *
+ * Notes:
+ * - Interrupts are never asynchronous: the mock raises them only while the
+ *   firmware sleeps (`__WFI()`) or waits (`HAL_Delay()`), and runs them once
+ *   they are unmasked. See mock_hal.c for the timing model.
+ * - Only the behaviour the firmware relies on is modelled; anything else is a
+ *   no-op that returns `HAL_OK`.
+ */
+
+
+
+ #ifndef STM32C0XX_HAL_H
+ #define STM32C0XX_HAL_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+
+ #ifndef HSE_VALUE
+ #define HSE_VALUE  24000000U
+ #endif
+ #ifndef HSI_VALUE
+ #define HSI_VALUE  48000000U
+ #endif
+
+ typedef enum {
+     HAL_OK = 0x00U,
+     HAL_ERROR = 0x01U,
+     HAL_BUSY = 0x02U,
+     HAL_TIMEOUT = 0x03U
+ } HAL_StatusTypeDef;
+
+ typedef enum { RESET = 0U, SET = !RESET } FlagStatus;
+ typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+
+ #define HAL_MAX_DELAY  0xFFFFFFFFU
+ #define UNUSED(x)      ((void)(x))
+ #define __IO           volatile
+
+ // Cortex-M0+ core
+ typedef int IRQn_Type;
+
+ #define RTC_IRQn                     2
+ #define EXTI0_1_IRQn                 5
+ #define EXTI2_3_IRQn                 6
+ #define EXTI4_15_IRQn                7
+ #define DMA1_Channel1_IRQn           9
+ #define DMA1_Channel2_3_IRQn         10
+ #define ADC1_IRQn                    12
+ #define TIM1_BRK_UP_TRG_COM_IRQn     13
+ #define TIM1_CC_IRQn                 14
+ #define TIM3_IRQn                    16
+ #define TIM14_IRQn                   19
+ #define TIM16_IRQn                   21
+ #define TIM17_IRQn                   22
+ #define SPI1_IRQn                    25
+ #define USART1_IRQn                  27
+ #define USART2_IRQn                  28
+ #define MOCK_IRQ_COUNT               32
+
+ void __disable_irq(void);
+ void __enable_irq(void);
+ uint32_t __get_PRIMASK(void);
+ void __set_PRIMASK(uint32_t priMask);
+ void __WFI(void);
+ void __DMB(void);
+ void __DSB(void);
+ void __ISB(void);
+ void __NOP(void);
+
+ // SysTick: CTRL and LOAD are read by the mock at every step, VAL is not modelled
+ typedef struct {
+     __IO uint32_t CTRL;
+     __IO uint32_t LOAD;
+     __IO uint32_t VAL;
+     __IO uint32_t CALIB;
+ } SysTick_Type;
+
+ extern SysTick_Type MockSysTick;
+ #define SysTick  (&MockSysTick)
+
+ #define SysTick_IRQn                 (-1)
+ #define SysTick_CTRL_ENABLE_Msk      0x1U
+ #define SysTick_CTRL_TICKINT_Msk     0x2U
+ #define SysTick_CTRL_CLKSOURCE_Msk   0x4U
+ #define SysTick_LOAD_RELOAD_Msk      0xFFFFFFU
+
+ void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+ void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+ void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+ // HAL core
+ #define TICK_INT_PRIORITY  3U
+
+ typedef enum {
+     HAL_TICK_FREQ_1KHZ = 1U,
+     HAL_TICK_FREQ_DEFAULT = HAL_TICK_FREQ_1KHZ
+ } HAL_TickFreqTypeDef;
+
+ extern __IO uint32_t uwTick;
+ extern HAL_TickFreqTypeDef uwTickFreq;
+ extern uint32_t uwTickPrio;
+
+ HAL_StatusTypeDef HAL_Init(void);
+ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
+ uint32_t HAL_GetTick(void);
+ void HAL_IncTick(void);
+ void HAL_Delay(uint32_t Delay);
+ void HAL_SuspendTick(void);
+ void HAL_ResumeTick(void);
+
+ // GPIO
+ typedef struct {
+     __IO uint32_t MODER;
+     __IO uint32_t IDR;
+     __IO uint32_t ODR;
+     __IO uint32_t BSRR;
+     __IO uint32_t BRR;
+ } GPIO_TypeDef;
+
+ extern GPIO_TypeDef MockGPIOA, MockGPIOB, MockGPIOC;
+ #define GPIOA  (&MockGPIOA)
+ #define GPIOB  (&MockGPIOB)
+ #define GPIOC  (&MockGPIOC)
+
+ typedef enum { GPIO_PIN_RESET = 0U, GPIO_PIN_SET } GPIO_PinState;
+
+ typedef struct {
+     uint32_t Pin;
+     uint32_t Mode;
+     uint32_t Pull;
+     uint32_t Speed;
+     uint32_t Alternate;
+ } GPIO_InitTypeDef;
+
+ #define GPIO_PIN_0   ((uint16_t)0x0001)
+ #define GPIO_PIN_1   ((uint16_t)0x0002)
+ #define GPIO_PIN_2   ((uint16_t)0x0004)
+ #define GPIO_PIN_3   ((uint16_t)0x0008)
+ #define GPIO_PIN_4   ((uint16_t)0x0010)
+ #define GPIO_PIN_5   ((uint16_t)0x0020)
+ #define GPIO_PIN_6   ((uint16_t)0x0040)
+ #define GPIO_PIN_7   ((uint16_t)0x0080)
+ #define GPIO_PIN_8   ((uint16_t)0x0100)
+ #define GPIO_PIN_9   ((uint16_t)0x0200)
+ #define GPIO_PIN_10  ((uint16_t)0x0400)
+ #define GPIO_PIN_11  ((uint16_t)0x0800)
+ #define GPIO_PIN_12  ((uint16_t)0x1000)
+ #define GPIO_PIN_13  ((uint16_t)0x2000)
+ #define GPIO_PIN_14  ((uint16_t)0x4000)
+ #define GPIO_PIN_15  ((uint16_t)0x8000)
+
+ #define GPIO_MODE_INPUT              0x00U
+ #define GPIO_MODE_OUTPUT_PP          0x01U
+ #define GPIO_MODE_AF_PP              0x02U
+ #define GPIO_MODE_ANALOG             0x03U
+ #define GPIO_MODE_IT_RISING          0x11U
+ #define GPIO_MODE_IT_FALLING         0x21U
+ #define GPIO_MODE_IT_RISING_FALLING  0x31U
+
+ #define GPIO_NOPULL                  0x00U
+ #define GPIO_PULLUP                  0x01U
+ #define GPIO_PULLDOWN                0x02U
+
+ #define GPIO_SPEED_FREQ_LOW          0x00U
+ #define GPIO_SPEED_FREQ_MEDIUM       0x01U
+ #define GPIO_SPEED_FREQ_HIGH         0x02U
+ #define GPIO_SPEED_FREQ_VERY_HIGH    0x03U
+
+ #define GPIO_AF0_SPI1                0x00U
+ #define GPIO_AF1_TIM3                0x01U
+ #define GPIO_AF1_USART1              0x01U
+ #define GPIO_AF1_USART2              0x01U
+ #define GPIO_AF2_TIM1                0x02U
+
+ void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+ GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+ void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+ void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+ void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin);
+ void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin);
+ void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin);
+
+ // RCC
+ #define __HAL_RCC_GPIOA_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_GPIOB_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_GPIOC_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_ADC_CLK_ENABLE()      do { } while (0)
+ #define __HAL_RCC_DMA1_CLK_ENABLE()     do { } while (0)
+ #define __HAL_RCC_SPI1_CLK_ENABLE()     do { } while (0)
+ #define __HAL_RCC_TIM1_CLK_ENABLE()     do { } while (0)
+ #define __HAL_RCC_TIM3_CLK_ENABLE()     do { } while (0)
+ #define __HAL_RCC_TIM14_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_TIM16_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_TIM17_CLK_ENABLE()    do { } while (0)
+ #define __HAL_RCC_USART1_CLK_ENABLE()   do { } while (0)
+ #define __HAL_RCC_USART2_CLK_ENABLE()   do { } while (0)
+ #define __HAL_RCC_PWR_CLK_ENABLE()      do { } while (0)
+ #define __HAL_RCC_RTC_ENABLE()          do { } while (0)
+ #define __HAL_RCC_RTCAPB_CLK_ENABLE()   do { } while (0)
+ #define __HAL_RCC_LSI_ENABLE()          do { } while (0)
+
+ // The LSI is ready at once
+ #define RCC_FLAG_LSIRDY                 0x01U
+ #define __HAL_RCC_GET_FLAG(flag)        ((void)(flag), SET)
+
+ typedef struct {
+     uint32_t PLLState;
+ } RCC_PLLInitTypeDef;
+
+ typedef struct {
+     uint32_t OscillatorType;
+     uint32_t HSEState;
+     uint32_t LSEState;
+     uint32_t HSIState;
+     uint32_t HSIDiv;
+     uint32_t HSICalibrationValue;
+     uint32_t LSIState;
+     RCC_PLLInitTypeDef PLL;
+ } RCC_OscInitTypeDef;
+
+ typedef struct {
+     uint32_t ClockType;
+     uint32_t SYSCLKSource;
+     uint32_t SYSCLKDivider;
+     uint32_t AHBCLKDivider;
+     uint32_t APB1CLKDivider;
+ } RCC_ClkInitTypeDef;
+
+ typedef struct {
+     uint32_t PeriphClockSelection;
+     uint32_t RTCClockSelection;
+     uint32_t AdcClockSelection;
+     uint32_t Usart1ClockSelection;
+ } RCC_PeriphCLKInitTypeDef;
+
+ #define RCC_OSCILLATORTYPE_HSE   0x01U
+ #define RCC_OSCILLATORTYPE_HSI   0x02U
+ #define RCC_OSCILLATORTYPE_LSE   0x04U
+ #define RCC_OSCILLATORTYPE_LSI   0x08U
+ #define RCC_HSE_OFF              0x00U
+ #define RCC_HSE_ON               0x01U
+ #define RCC_HSI_OFF              0x00U
+ #define RCC_HSI_ON               0x01U
+ #define RCC_LSI_ON               0x01U
+ #define RCC_LSE_ON               0x01U
+ #define RCC_HSI_DIV1             0x00U
+ #define RCC_HSI_DIV2             0x01U
+ #define RCC_HSI_DIV4             0x02U
+ #define RCC_HSICALIBRATION_DEFAULT  64U
+ #define RCC_PLL_NONE             0x00U
+ #define RCC_CLOCKTYPE_SYSCLK     0x01U
+ #define RCC_CLOCKTYPE_HCLK       0x02U
+ #define RCC_CLOCKTYPE_PCLK1      0x04U
+ #define RCC_SYSCLKSOURCE_HSI     0x00U
+ #define RCC_SYSCLKSOURCE_HSE     0x01U
+ #define RCC_SYSCLK_DIV1          0x00U
+ #define RCC_HCLK_DIV1            0x00U
+ #define RCC_APB1_DIV1            0x00U  // APB dividers are log2 of the ratio in the mock
+ #define RCC_APB1_DIV2            0x01U
+ #define RCC_APB1_DIV4            0x02U
+ #define RCC_APB1_DIV8            0x03U
+ #define RCC_APB1_DIV16           0x04U
+ #define RCC_PERIPHCLK_RTC        0x01U
+ #define RCC_PERIPHCLK_USART1     0x02U
+ #define RCC_USART1CLKSOURCE_PCLK1   0x00U
+ #define RCC_USART1CLKSOURCE_HSIKER  0x02U
+ #define RCC_RTCCLKSOURCE_LSE     0x01U
+ #define RCC_RTCCLKSOURCE_LSI     0x02U
+
+ #define FLASH_LATENCY_0          0x00U
+ #define FLASH_LATENCY_1          0x01U
+
+ HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+ HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+ HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+ uint32_t HAL_RCC_GetSysClockFreq(void);
+ uint32_t HAL_RCC_GetHCLKFreq(void);
+ uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+ extern uint32_t SystemCoreClock;
+
+ // PWR
+ #define PWR_MAINREGULATOR_ON       0x0U
+ #define PWR_LOWPOWERREGULATOR_ON   0x1U
+ #define PWR_STOPENTRY_WFI          0x1U
+ #define PWR_STOPENTRY_WFE          0x2U
+
+ void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+ // FLASH: main memory is an array in the mock, erased (all ones) at HAL_Init()
+ #define FLASH_PAGE_SIZE              0x800U
+ #define FLASH_PAGE_NB                16U
+ #define FLASH_TYPEPROGRAM_DOUBLEWORD 0x01U
+ #define FLASH_TYPEERASE_PAGES        0x02U
+
+ extern uint8_t MockFlash[FLASH_PAGE_NB * FLASH_PAGE_SIZE];
+ #define FLASH_BASE                   ((uint32_t)(uintptr_t)MockFlash)
+
+ typedef struct {
+     uint32_t TypeErase;
+     uint32_t Page;
+     uint32_t NbPages;
+ } FLASH_EraseInitTypeDef;
+
+ HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+ HAL_StatusTypeDef HAL_FLASH_Lock(void);
+ HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+ HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+
+ // DMA
+ typedef struct {
+     __IO uint32_t CCR;
+     __IO uint32_t CNDTR;
+     __IO uint32_t CPAR;
+     __IO uint32_t CMAR;
+ } DMA_Channel_TypeDef;
+
+ // Three channels, as on the STM32C031 (the default target)
+ extern DMA_Channel_TypeDef MockDMA1_Channel[3];
+ #define DMA1_Channel1  (&MockDMA1_Channel[0])
+ #define DMA1_Channel2  (&MockDMA1_Channel[1])
+ #define DMA1_Channel3  (&MockDMA1_Channel[2])
+
+ typedef struct {
+     uint32_t Request;
+     uint32_t Direction;
+     uint32_t PeriphInc;
+     uint32_t MemInc;
+     uint32_t PeriphDataAlignment;
+     uint32_t MemDataAlignment;
+     uint32_t Mode;
+     uint32_t Priority;
+ } DMA_InitTypeDef;
+
+ typedef enum {
+     HAL_DMA_STATE_RESET = 0x00U,
+     HAL_DMA_STATE_READY = 0x01U,
+     HAL_DMA_STATE_BUSY = 0x02U
+ } HAL_DMA_StateTypeDef;
+
+ typedef struct __DMA_HandleTypeDef {
+     DMA_Channel_TypeDef *Instance;
+     DMA_InitTypeDef Init;
+     __IO HAL_DMA_StateTypeDef State;
+     void *Parent;
+     void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+     void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+     void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+     void (*XferAbortCallback)(struct __DMA_HandleTypeDef *hdma);
+     __IO uint32_t ErrorCode;
+ } DMA_HandleTypeDef;
+
+ #define DMA_REQUEST_ADC1          5U
+ #define DMA_REQUEST_SPI1_TX       17U
+ #define DMA_REQUEST_TIM3_UP       37U
+
+ #define DMA_PERIPH_TO_MEMORY      0x00U
+ #define DMA_MEMORY_TO_PERIPH      0x10U
+ #define DMA_PINC_DISABLE          0x00U
+ #define DMA_MINC_ENABLE           0x80U
+ #define DMA_PDATAALIGN_BYTE       0x000U
+ #define DMA_PDATAALIGN_HALFWORD   0x100U
+ #define DMA_PDATAALIGN_WORD       0x200U
+ #define DMA_MDATAALIGN_BYTE       0x000U
+ #define DMA_MDATAALIGN_HALFWORD   0x400U
+ #define DMA_MDATAALIGN_WORD       0x800U
+ #define DMA_NORMAL                0x00U
+ #define DMA_CIRCULAR              0x20U
+ #define DMA_PRIORITY_LOW          0x0000U
+ #define DMA_PRIORITY_MEDIUM       0x1000U
+ #define DMA_PRIORITY_HIGH         0x2000U
+
+ #define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+     do { \
+         (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); \
+         (__DMA_HANDLE__).Parent = (__HANDLE__); \
+     } while (0)
+ #define __HAL_DMA_GET_COUNTER(__HANDLE__)  ((__HANDLE__)->Instance->CNDTR)
+
+ HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+ HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+ HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+ HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma);
+ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+ // ADC
+ typedef struct {
+     __IO uint32_t ISR;
+     __IO uint32_t CR;
+     __IO uint32_t CFGR1;
+     __IO uint32_t DR;
+ } ADC_TypeDef;
+
+ extern ADC_TypeDef MockADC1;
+ #define ADC1  (&MockADC1)
+
+ typedef struct {
+     uint32_t Ratio;
+     uint32_t RightBitShift;
+     uint32_t TriggeredMode;
+ } ADC_OversamplingTypeDef;
+
+ typedef struct {
+     uint32_t ClockPrescaler;
+     uint32_t Resolution;
+     uint32_t DataAlign;
+     uint32_t ScanConvMode;
+     uint32_t EOCSelection;
+     FunctionalState LowPowerAutoWait;
+     FunctionalState LowPowerAutoPowerOff;
+     FunctionalState ContinuousConvMode;
+     uint32_t NbrOfConversion;
+     FunctionalState DiscontinuousConvMode;
+     uint32_t ExternalTrigConv;
+     uint32_t ExternalTrigConvEdge;
+     FunctionalState DMAContinuousRequests;
+     uint32_t Overrun;
+     uint32_t SamplingTimeCommon1;
+     uint32_t SamplingTimeCommon2;
+     FunctionalState OversamplingMode;
+     ADC_OversamplingTypeDef Oversampling;
+     uint32_t TriggerFrequencyMode;
+ } ADC_InitTypeDef;
+
+ typedef struct __ADC_HandleTypeDef {
+     ADC_TypeDef *Instance;
+     ADC_InitTypeDef Init;
+     DMA_HandleTypeDef *DMA_Handle;
+     __IO uint32_t State;
+     __IO uint32_t ErrorCode;
+ } ADC_HandleTypeDef;
+
+ typedef struct {
+     uint32_t Channel;
+     uint32_t Rank;
+     uint32_t SamplingTime;
+ } ADC_ChannelConfTypeDef;
+
+ #define ADC_CHANNEL_0                 0U
+ #define ADC_CHANNEL_1                 1U
+ #define ADC_CHANNEL_2                 2U
+ #define ADC_CHANNEL_3                 3U
+ #define ADC_CHANNEL_4                 4U
+ #define ADC_CHANNEL_5                 5U
+ #define ADC_CHANNEL_6                 6U
+ #define ADC_CHANNEL_7                 7U
+ #define ADC_CHANNEL_8                 8U
+ #define ADC_CHANNEL_VREFINT           13U
+ #define MOCK_ADC_CHANNEL_COUNT        16U
+
+ #define ADC_REGULAR_RANK_1            1U
+ #define ADC_REGULAR_RANK_2            2U
+ #define ADC_REGULAR_RANK_3            3U
+ #define ADC_REGULAR_RANK_4            4U
+ #define MOCK_ADC_RANK_COUNT           8U
+
+ #define ADC_CLOCK_SYNC_PCLK_DIV1      0x0U
+ #define ADC_CLOCK_SYNC_PCLK_DIV2      0x1U
+ #define ADC_CLOCK_SYNC_PCLK_DIV4      0x2U
+ #define ADC_RESOLUTION_12B            0x0U
+ #define ADC_DATAALIGN_RIGHT           0x0U
+ #define ADC_SCAN_DISABLE              0x0U
+ #define ADC_SCAN_ENABLE               0x1U
+ #define ADC_SCAN_SEQ_FIXED            0x2U
+ #define ADC_EOC_SINGLE_CONV           0x0U
+ #define ADC_EOC_SEQ_CONV              0x1U
+ #define ADC_SOFTWARE_START            0x0U
+ #define ADC_EXTERNALTRIGCONVEDGE_NONE 0x0U
+ #define ADC_OVR_DATA_OVERWRITTEN      0x1U
+ #define ADC_SAMPLETIME_39CYCLES_5     0x5U
+ #define ADC_SAMPLETIME_79CYCLES_5     0x6U
+ #define ADC_SAMPLETIME_160CYCLES_5    0x7U
+ #define ADC_SAMPLINGTIME_COMMON_1     0x0U
+ #define ADC_SAMPLINGTIME_COMMON_2     0x1U
+ #define ADC_OVERSAMPLING_RATIO_16     0x3U
+ #define ADC_RIGHTBITSHIFT_2           0x2U
+ #define ADC_TRIGGEREDMODE_SINGLE_TRIGGER 0x0U
+ #define ADC_TRIGGER_FREQ_HIGH         0x0U
+ #define ADC_TRIGGER_FREQ_LOW          0x1U
+
+ HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+ HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig);
+ HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc);
+ HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+ HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc);
+ HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc);
+ HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout);
+ uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc);
+ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+ void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+ void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc);
+
+ // SPI
+ typedef struct {
+     __IO uint32_t CR1;
+     __IO uint32_t SR;
+     __IO uint32_t DR;
+ } SPI_TypeDef;
+
+ extern SPI_TypeDef MockSPI1;
+ #define SPI1  (&MockSPI1)
+
+ typedef struct {
+     uint32_t Mode;
+     uint32_t Direction;
+     uint32_t DataSize;
+     uint32_t CLKPolarity;
+     uint32_t CLKPhase;
+     uint32_t NSS;
+     uint32_t BaudRatePrescaler;
+     uint32_t FirstBit;
+     uint32_t TIMode;
+     uint32_t CRCCalculation;
+     uint32_t CRCPolynomial;
+     uint32_t NSSPMode;
+ } SPI_InitTypeDef;
+
+ typedef struct __SPI_HandleTypeDef {
+     SPI_TypeDef *Instance;
+     SPI_InitTypeDef Init;
+     DMA_HandleTypeDef *hdmatx;
+     DMA_HandleTypeDef *hdmarx;
+     __IO uint32_t ErrorCode;
+ } SPI_HandleTypeDef;
+
+ #define SPI_MODE_MASTER              0x104U
+ #define SPI_DIRECTION_2LINES         0x0U
+ #define SPI_DIRECTION_1LINE          0x8000U
+ #define SPI_DATASIZE_8BIT            0x700U
+ #define SPI_POLARITY_LOW             0x0U
+ #define SPI_PHASE_1EDGE              0x0U
+ #define SPI_NSS_SOFT                 0x200U
+ #define SPI_BAUDRATEPRESCALER_2      0x00U
+ #define SPI_BAUDRATEPRESCALER_4      0x08U
+ #define SPI_BAUDRATEPRESCALER_8      0x10U
+ #define SPI_BAUDRATEPRESCALER_16     0x18U
+ #define SPI_FIRSTBIT_MSB             0x0U
+ #define SPI_TIMODE_DISABLE           0x0U
+ #define SPI_CRCCALCULATION_DISABLE   0x0U
+ #define SPI_NSS_PULSE_DISABLE        0x0U
+
+ HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+ HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+ HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size);
+ void HAL_SPI_IRQHandler(SPI_HandleTypeDef *hspi);
+ void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+ void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+ // UART (USART1: interrupt-driven transmit and receive to idle; USART2: blocking or interrupt-driven transmit)
+ typedef struct {
+     __IO uint32_t CR1;
+     __IO uint32_t CR3;
+     __IO uint32_t ISR;
+     __IO uint32_t RDR;
+     __IO uint32_t TDR;
+ } USART_TypeDef;
+
+ extern USART_TypeDef MockUSART1, MockUSART2;
+ #define USART1  (&MockUSART1)
+ #define USART2  (&MockUSART2)
+
+ typedef struct {
+     uint32_t BaudRate;
+     uint32_t WordLength;
+     uint32_t StopBits;
+     uint32_t Parity;
+     uint32_t Mode;
+     uint32_t HwFlowCtl;
+     uint32_t OverSampling;
+ } UART_InitTypeDef;
+
+ typedef struct {
+     uint32_t WakeUpEvent;
+     uint16_t AddressLength;
+     uint8_t Address;
+ } UART_WakeUpTypeDef;
+
+ typedef enum {
+     HAL_UART_STATE_RESET = 0x00U,
+     HAL_UART_STATE_READY = 0x20U,
+     HAL_UART_STATE_BUSY_TX = 0x21U,
+     HAL_UART_STATE_BUSY_RX = 0x22U
+ } HAL_UART_StateTypeDef;
+
+ typedef uint32_t HAL_UART_RxEventTypeTypeDef;
+
+ typedef struct __UART_HandleTypeDef {
+     USART_TypeDef *Instance;
+     UART_InitTypeDef Init;
+     const uint8_t *pTxBuffPtr;
+     uint16_t TxXferSize;
+     uint8_t *pRxBuffPtr;
+     uint16_t RxXferSize;
+     __IO uint16_t RxXferCount;
+     __IO HAL_UART_RxEventTypeTypeDef RxEventType;
+     DMA_HandleTypeDef *hdmatx;
+     DMA_HandleTypeDef *hdmarx;
+     __IO HAL_UART_StateTypeDef gState;
+     __IO HAL_UART_StateTypeDef RxState;
+     __IO uint32_t ErrorCode;
+ } UART_HandleTypeDef;
+
+ #define USART_CR1_UESM               (1U << 1)
+ #define USART_CR3_WUFIE              (1U << 22)
+ #define USART_ISR_BUSY               (1U << 16)
+ #define USART_ISR_WUF                (1U << 20)
+
+ #define UART_WORDLENGTH_8B           0x0000U
+ #define UART_WORDLENGTH_9B           0x1000U
+ #define UART_STOPBITS_1              0x0000U
+ #define UART_STOPBITS_2              0x2000U
+ #define UART_PARITY_NONE             0x000U
+ #define UART_PARITY_EVEN             0x400U
+ #define UART_PARITY_ODD              0x600U
+ #define UART_MODE_TX                 0x08U
+ #define UART_MODE_TX_RX              0x0CU
+ #define UART_HWCONTROL_NONE          0x0U
+ #define UART_OVERSAMPLING_16         0x0U
+ #define UART_DE_POLARITY_HIGH        0x0U
+ #define UART_WAKEUP_ON_STARTBIT      0x200000U
+ #define UART_IT_WUF                  USART_CR3_WUFIE
+ #define UART_FLAG_BUSY               USART_ISR_BUSY
+ #define UART_FLAG_WUF                USART_ISR_WUF
+ #define UART_CLEAR_WUF               USART_ISR_WUF
+ #define HAL_UART_RXEVENT_TC          0x0U
+ #define HAL_UART_RXEVENT_HT          0x1U
+ #define HAL_UART_RXEVENT_IDLE        0x2U
+ #define HAL_UART_ERROR_ORE           0x08U
+
+ // The mock only knows the wakeup interrupt, which lives in CR3 as on the target
+ #define __HAL_UART_ENABLE_IT(__HANDLE__, __IT__)     ((__HANDLE__)->Instance->CR3 |= (__IT__))
+ #define __HAL_UART_DISABLE_IT(__HANDLE__, __IT__)    ((__HANDLE__)->Instance->CR3 &= ~(__IT__))
+ #define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)    (((__HANDLE__)->Instance->ISR & (__FLAG__)) == (__FLAG__))
+ // ICR on the target (same bit positions); the mock clears ISR directly
+ #define __HAL_UART_CLEAR_FLAG(__HANDLE__, __FLAG__)  ((__HANDLE__)->Instance->ISR &= ~(__FLAG__))
+
+ HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+ HAL_StatusTypeDef HAL_RS485Ex_Init(UART_HandleTypeDef *huart, uint32_t Polarity, uint32_t AssertionTime, uint32_t DeassertionTime);
+ HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+ HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+ HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+ HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart);
+ HAL_StatusTypeDef HAL_UARTEx_StopModeWakeUpSourceConfig(UART_HandleTypeDef *huart, UART_WakeUpTypeDef WakeUpSelection);
+ HAL_StatusTypeDef HAL_UARTEx_EnableStopMode(UART_HandleTypeDef *huart);
+ void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+ void HAL_UARTEx_WakeupCallback(UART_HandleTypeDef *huart);
+
+ // TIM
+ typedef struct {
+     __IO uint32_t CR1;
+     __IO uint32_t DIER;
+     __IO uint32_t SR;
+     __IO uint32_t EGR;
+     __IO uint32_t CNT;
+     __IO uint32_t PSC;
+     __IO uint32_t ARR;
+     __IO uint32_t CCR1;
+     __IO uint32_t CCR2;
+     __IO uint32_t CCR3;
+     __IO uint32_t CCR4;
+ } TIM_TypeDef;
+
+ extern TIM_TypeDef MockTIM1, MockTIM3, MockTIM14, MockTIM16, MockTIM17;
+ #define TIM1   (&MockTIM1)
+ #define TIM3   (&MockTIM3)
+ #define TIM14  (&MockTIM14)
+ #define TIM16  (&MockTIM16)
+ #define TIM17  (&MockTIM17)
+
+ #define TIM_CR1_CEN     (1U << 0)
+ #define TIM_CR1_OPM     (1U << 3)
+ #define TIM_SR_UIF      (1U << 0)
+ #define TIM_SR_CC1IF    (1U << 1)
+ #define TIM_SR_CC2IF    (1U << 2)
+ #define TIM_SR_CC3IF    (1U << 3)
+ #define TIM_SR_CC4IF    (1U << 4)
+
+ #define TIM_FLAG_UPDATE  TIM_SR_UIF
+ #define TIM_FLAG_CC1     TIM_SR_CC1IF
+ #define TIM_FLAG_CC2     TIM_SR_CC2IF
+ #define TIM_FLAG_CC3     TIM_SR_CC3IF
+ #define TIM_FLAG_CC4     TIM_SR_CC4IF
+ #define TIM_IT_UPDATE    (1U << 0)
+ #define TIM_IT_CC1       (1U << 1)
+ #define TIM_IT_CC2       (1U << 2)
+ #define TIM_IT_CC3       (1U << 3)
+ #define TIM_IT_CC4       (1U << 4)
+ #define TIM_DMA_UPDATE   (1U << 8)
+
+ typedef struct {
+     uint32_t Prescaler;
+     uint32_t CounterMode;
+     uint32_t Period;
+     uint32_t ClockDivision;
+     uint32_t RepetitionCounter;
+     uint32_t AutoReloadPreload;
+ } TIM_Base_InitTypeDef;
+
+ typedef struct {
+     uint32_t OCMode;
+     uint32_t Pulse;
+     uint32_t OCPolarity;
+     uint32_t OCNPolarity;
+     uint32_t OCFastMode;
+     uint32_t OCIdleState;
+     uint32_t OCNIdleState;
+ } TIM_OC_InitTypeDef;
+
+ typedef struct {
+     uint32_t ICPolarity;
+     uint32_t ICSelection;
+     uint32_t ICPrescaler;
+     uint32_t ICFilter;
+ } TIM_IC_InitTypeDef;
+
+ typedef enum {
+     HAL_TIM_ACTIVE_CHANNEL_1 = 0x01U,
+     HAL_TIM_ACTIVE_CHANNEL_2 = 0x02U,
+     HAL_TIM_ACTIVE_CHANNEL_3 = 0x04U,
+     HAL_TIM_ACTIVE_CHANNEL_4 = 0x08U,
+     HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+ } HAL_TIM_ActiveChannel;
+
+ typedef struct __TIM_HandleTypeDef {
+     TIM_TypeDef *Instance;
+     TIM_Base_InitTypeDef Init;
+     HAL_TIM_ActiveChannel Channel;
+     DMA_HandleTypeDef *hdma[7];
+ } TIM_HandleTypeDef;
+
+ #define TIM_CHANNEL_1                 0x0U
+ #define TIM_CHANNEL_2                 0x4U
+ #define TIM_CHANNEL_3                 0x8U
+ #define TIM_CHANNEL_4                 0xCU
+ #define TIM_COUNTERMODE_UP            0x0U
+ #define TIM_CLOCKDIVISION_DIV1        0x0U
+ #define TIM_AUTORELOAD_PRELOAD_DISABLE 0x0U
+ #define TIM_AUTORELOAD_PRELOAD_ENABLE 0x80U
+ #define TIM_OCMODE_PWM1               0x60U
+ #define TIM_OCPOLARITY_HIGH           0x0U
+ #define TIM_OCFAST_DISABLE            0x0U
+ #define TIM_ICPOLARITY_RISING         0x0U
+ #define TIM_ICSELECTION_DIRECTTI      0x1U
+ #define TIM_ICPSC_DIV1                0x0U
+
+ #define __HAL_TIM_ENABLE(__HANDLE__)                 ((__HANDLE__)->Instance->CR1 |= TIM_CR1_CEN)
+ #define __HAL_TIM_DISABLE(__HANDLE__)                ((__HANDLE__)->Instance->CR1 &= ~TIM_CR1_CEN)
+ #define __HAL_TIM_ENABLE_IT(__HANDLE__, __IT__)      ((__HANDLE__)->Instance->DIER |= (__IT__))
+ #define __HAL_TIM_DISABLE_IT(__HANDLE__, __IT__)     ((__HANDLE__)->Instance->DIER &= ~(__IT__))
+ #define __HAL_TIM_ENABLE_DMA(__HANDLE__, __DMA__)    ((__HANDLE__)->Instance->DIER |= (__DMA__))
+ #define __HAL_TIM_DISABLE_DMA(__HANDLE__, __DMA__)   ((__HANDLE__)->Instance->DIER &= ~(__DMA__))
+ #define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__)     (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+ // SR bits are rc_w0 on the target (writing 1 leaves them alone); the mock SR is plain memory
+ #define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)   ((__HANDLE__)->Instance->SR &= ~(__FLAG__))
+ #define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) ((__HANDLE__)->Instance->CNT = (__COUNTER__))
+ #define __HAL_TIM_GET_COUNTER(__HANDLE__)            ((__HANDLE__)->Instance->CNT)
+ #define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) \
+     do { \
+         (__HANDLE__)->Instance->ARR = (__AUTORELOAD__); \
+         (__HANDLE__)->Init.Period = (__AUTORELOAD__); \
+     } while (0)
+
+ HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+ HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+ HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+ HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+ HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+ HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+ HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim);
+ HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel);
+ HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+ uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel);
+ void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+ void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+
+ // RTC
+ typedef struct {
+     __IO uint32_t TR;
+     __IO uint32_t DR;
+     __IO uint32_t ICSR;
+ } RTC_TypeDef;
+
+ extern RTC_TypeDef MockRTC;
+ #define RTC  (&MockRTC)
+
+ // TR: BCD time of day
+ #define RTC_TR_SU_Pos   0U
+ #define RTC_TR_SU       (0xFU << RTC_TR_SU_Pos)
+ #define RTC_TR_ST_Pos   4U
+ #define RTC_TR_ST       (0x7U << RTC_TR_ST_Pos)
+ #define RTC_TR_MNU_Pos  8U
+ #define RTC_TR_MNU      (0xFU << RTC_TR_MNU_Pos)
+ #define RTC_TR_MNT_Pos  12U
+ #define RTC_TR_MNT      (0x7U << RTC_TR_MNT_Pos)
+ #define RTC_TR_HU_Pos   16U
+ #define RTC_TR_HU       (0xFU << RTC_TR_HU_Pos)
+ #define RTC_TR_HT_Pos   20U
+ #define RTC_TR_HT       (0x3U << RTC_TR_HT_Pos)
+
+ typedef struct {
+     uint32_t HourFormat;
+     uint32_t AsynchPrediv;
+     uint32_t SynchPrediv;
+     uint32_t OutPut;
+     uint32_t OutPutRemap;
+     uint32_t OutPutPolarity;
+     uint32_t OutPutType;
+     uint32_t OutPutPullUp;
+ } RTC_InitTypeDef;
+
+ typedef struct {
+     RTC_TypeDef *Instance;
+     RTC_InitTypeDef Init;
+ } RTC_HandleTypeDef;
+
+ typedef struct {
+     uint8_t Hours;
+     uint8_t Minutes;
+     uint8_t Seconds;
+     uint8_t TimeFormat;
+     uint32_t SubSeconds;
+     uint32_t SecondFraction;
+     uint32_t DayLightSaving;
+     uint32_t StoreOperation;
+ } RTC_TimeTypeDef;
+
+ typedef struct {
+     uint8_t WeekDay;
+     uint8_t Month;
+     uint8_t Date;
+     uint8_t Year;
+ } RTC_DateTypeDef;
+
+ typedef struct {
+     RTC_TimeTypeDef AlarmTime;
+     uint32_t AlarmMask;
+     uint32_t AlarmSubSecondMask;
+     uint32_t AlarmDateWeekDaySel;
+     uint8_t AlarmDateWeekDay;
+     uint32_t Alarm;
+ } RTC_AlarmTypeDef;
+
+ #define RTC_FORMAT_BIN                0x0U
+ #define RTC_HOURFORMAT_24             0x0U
+ #define RTC_OUTPUT_DISABLE            0x0U
+ #define RTC_ALARMMASK_ALL             0x80808080U
+ #define RTC_ALARMSUBSECONDMASK_ALL    0x0U
+ #define RTC_ALARMDATEWEEKDAYSEL_DATE  0x0U
+ #define RTC_ALARM_A                   0x100U
+
+ HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc);
+ HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format);
+ HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format);
+ HAL_StatusTypeDef HAL_RTC_SetAlarm_IT(RTC_HandleTypeDef *hrtc, RTC_AlarmTypeDef *sAlarm, uint32_t Format);
+ void HAL_RTC_AlarmIRQHandler(RTC_HandleTypeDef *hrtc);
+ void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc);
+
+ #endif // STM32C0XX_HAL_H
@@ -0,0 +1,1733 @@
+/**
+ * @file mock_hal.c
+ * @brief Discrete-event model of the STM32C0 peripherals behind the mock HAL.
+ *
+ * This source file implements the functions declared in stm32c0xx_hal.h and
+ * mock_hal.h for the host simulator.
+ *
+ * Details:
+ * - Simulated time only moves while the firmware sleeps in `__WFI()` or waits
+ *   in `HAL_Delay()`. Each step jumps to the earliest of: the next SysTick, the
+ *   next update of a running timer with its interrupt or DMA request enabled,
+ *   the next ADC half buffer, the end of an SPI DMA transfer, the next USART1
+ *   character, idle line or end of transmission, the end of a USART2
+ *   transmission, the next RTC second and the simulator's own next poll time.
+ *   Code between two steps takes no simulated time.
+ * - Timers count timer clock cycles through PSC, so CR1 (CEN, OPM), DIER, SR, CNT
+ *   and ARR written directly by the firmware behave as on the target. They are
+ *   brought up to date at every step, never in between. The timer clock is
+ *   PCLK, doubled when the APB divider is not 1, as on the target.
+ * - Clocks: SYSCLK from HSI48 / HSIDIV or HSE, PCLK = SYSCLK / APB divider. A
+ *   clock change stretches or shortens the SysTick period, ADC scan and SPI
+ *   transfer in flight accordingly. SYSCLK above 24 MHz without a flash wait
+ *   state is a fault. The RCC calls `HAL_InitTick()` after a change like the HAL.
+ * - SysTick runs from `SysTick->LOAD` at SYSCLK while CTRL has ENABLE set, and
+ *   interrupts while TICKINT is set; the firmware may write both directly.
+ * - Stop mode (`HAL_PWR_EnterSTOPMode()`) freezes SysTick, every timer and the
+ *   ADC until an enabled EXTI, RTC or USART1 wakeup interrupt is pending; it
+ *   wakes on HSISYS.
+ * - RTC: the calendar counts simulated seconds from midnight at reset; `TR`
+ *   holds its time of day in BCD, up to date at every step. `Mock_SetRtcTime()`
+ *   sets it as a write through the HAL would. The alarm fires at every second.
+ * - Interrupts set a pending bit and run in priority order (lowest value first,
+ *   SysTick before IRQs of the same priority) once PRIMASK is clear. Handlers do
+ *   not nest. `__WFI()` returns as soon as any enabled interrupt is pending,
+ *   masked or not, as on the Cortex-M0+.
+ * - DMA: three channels, as on the C031. The ADC channel stores each
+ *   conversion once simulated time passes its end, so CNDTR and the buffer
+ *   read in an interrupt show the results up to that moment; SPI TX completes
+ *   after its bytes at the SPI clock, and the TIM3_UP channel moves one element
+ *   per TIM3 update.
+ * - USART1: bytes from the simulator (`Mock_UartReceive()`) arrive one
+ *   character time apart, with ISR.BUSY set from the first start bit to the
+ *   last stop bit, and the idle line is detected one character time after the
+ *   last. An interrupt-driven receive takes each byte in its own USART1
+ *   interrupt; a byte that arrives before the previous one was taken is an
+ *   overrun, which stops the reception and calls the error callback like the
+ *   HAL. An idle line with nothing received is not reported, also like the HAL.
+ *   An interrupt-driven transmit completes after its characters. With UESM set
+ *   and the kernel clock on HSIKER a start bit sets WUF, which wakes Stop mode
+ *   if WUFIE is set. A byte that completes while the core is stopped is lost,
+ *   as is one nobody receives. The baud rate is fixed at `HAL_RS485Ex_Init()`.
+ * - USART2: transmit only. An interrupt-driven transmit completes after its
+ *   characters at the baud rate given to `HAL_UART_Init()`.
+ * - RCC: `Mock_FailRcc()` makes the next oscillator or clock configuration calls
+ *   time out without changing anything, like an oscillator that never gets ready.
+ * - Flash: double-word programming into a blank slot and page erase, behind the
+ *   unlock sequence. Each operation stalls the core like a flash-resident
+ *   program on the target: simulated time advances by `MOCK_FLASH_PROGRAM_NS`
+ *   or `MOCK_FLASH_ERASE_NS` and interrupts raised meanwhile run afterwards.
+ *   An erase while TIM3 drives the motor or TIM14 times a step is a fault.
+ *   `HAL_Init()` erases the part unless `Mock_LoadFlash()` gave it the contents
+ *   an earlier run left; `Mock_TearLastFlashWrite()` leaves the last double word
+ *   half programmed, as a power cut between its two word writes would.
+ *
+ * Notes:
+ * - `HAL_DMA_Start_IT()` takes 32-bit addresses; the Makefile links without PIE
+ *   so the firmware's static buffers and the mock registers stay below 4 GB.
+ * - A missing interrupt handler, a sleep with nothing left to wake it and a
+ *   `HAL_Delay()` with interrupts masked are reported through `Sim_Fault()`;
+ *   on the target they would hang.
+ */
+
+
+
+ #include "mock_hal.h"
+ #include <string.h>
+
+ #define MOCK_NS_PER_S       1000000000ULL
+ #define MOCK_SYSTICK_IRQ    MOCK_IRQ_COUNT   // Dispatch slot after the IRQs
+ #define MOCK_DMA_CHANNELS   3
+ #define MOCK_TIMER_COUNT    5
+ #define MOCK_FLASH_PROGRAM_NS  85000ULL
+ #define MOCK_FLASH_ERASE_NS    22000000ULL
+ #define MOCK_UART_LINE      64U   // Bytes one Mock_UartReceive() can put on the wire
+
+ typedef struct {
+     TIM_TypeDef *regs;
+     IRQn_Type updateIrq;
+     IRQn_Type captureIrq;
+     uint32_t dmaRequest;    // Request raised by the update event, 0 if none
+     uint64_t syncedCycles;  // Timer clock cycle the counter is up to date with
+     uint32_t prescaler;     // Cycles into the current count
+ } MockTimer;
+
+ typedef struct {
+     DMA_HandleTypeDef *handle;
+     uint8_t active;
+     uint8_t halfPending;
+     uint8_t fullPending;
+     uintptr_t source;
+     uintptr_t destination;
+     uint32_t length;
+     uint32_t position;      // Elements moved in the current pass
+     uint64_t doneAt;        // End of a timed transfer (SPI), MOCK_NEVER otherwise
+ } MockDma;
+
+ // Register blocks
+ GPIO_TypeDef MockGPIOA, MockGPIOB, MockGPIOC;
+ DMA_Channel_TypeDef MockDMA1_Channel[MOCK_DMA_CHANNELS];
+ ADC_TypeDef MockADC1;
+ SPI_TypeDef MockSPI1;
+ USART_TypeDef MockUSART1, MockUSART2;
+ TIM_TypeDef MockTIM1, MockTIM3, MockTIM14, MockTIM16, MockTIM17;
+ RTC_TypeDef MockRTC;
+ SysTick_Type MockSysTick;
+ uint32_t SystemCoreClock = HSI_VALUE / 4U;
+ __IO uint32_t uwTick = 0;
+ HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+ uint32_t uwTickPrio = 4U;  // Invalid until HAL_InitTick()
+
+ // Firmware interrupt handlers; the ones a build leaves out stay NULL
+ extern void RTC_IRQHandler(void) __attribute__((weak));
+ extern void EXTI0_1_IRQHandler(void) __attribute__((weak));
+ extern void EXTI2_3_IRQHandler(void) __attribute__((weak));
+ extern void EXTI4_15_IRQHandler(void) __attribute__((weak));
+ extern void DMA1_Channel1_IRQHandler(void) __attribute__((weak));
+ extern void DMA1_Channel2_3_IRQHandler(void) __attribute__((weak));
+ extern void ADC1_IRQHandler(void) __attribute__((weak));
+ extern void TIM1_BRK_UP_TRG_COM_IRQHandler(void) __attribute__((weak));
+ extern void TIM1_CC_IRQHandler(void) __attribute__((weak));
+ extern void TIM3_IRQHandler(void) __attribute__((weak));
+ extern void TIM14_IRQHandler(void) __attribute__((weak));
+ extern void TIM16_IRQHandler(void) __attribute__((weak));
+ extern void TIM17_IRQHandler(void) __attribute__((weak));
+ extern void SPI1_IRQHandler(void) __attribute__((weak));
+ extern void USART1_IRQHandler(void) __attribute__((weak));
+ extern void USART2_IRQHandler(void) __attribute__((weak));
+
+ static void (*const vectors[MOCK_IRQ_COUNT])(void) = {
+     [RTC_IRQn]                   = RTC_IRQHandler,
+     [EXTI0_1_IRQn]               = EXTI0_1_IRQHandler,
+     [EXTI2_3_IRQn]               = EXTI2_3_IRQHandler,
+     [EXTI4_15_IRQn]              = EXTI4_15_IRQHandler,
+     [DMA1_Channel1_IRQn]         = DMA1_Channel1_IRQHandler,
+     [DMA1_Channel2_3_IRQn]       = DMA1_Channel2_3_IRQHandler,
+     [ADC1_IRQn]                  = ADC1_IRQHandler,
+     [TIM1_BRK_UP_TRG_COM_IRQn]   = TIM1_BRK_UP_TRG_COM_IRQHandler,
+     [TIM1_CC_IRQn]               = TIM1_CC_IRQHandler,
+     [TIM3_IRQn]                  = TIM3_IRQHandler,
+     [TIM14_IRQn]                 = TIM14_IRQHandler,
+     [TIM16_IRQn]                 = TIM16_IRQHandler,
+     [TIM17_IRQn]                 = TIM17_IRQHandler,
+     [SPI1_IRQn]                  = SPI1_IRQHandler,
+     [USART1_IRQn]                = USART1_IRQHandler,
+     [USART2_IRQn]                = USART2_IRQHandler,
+ };
+
+ static const IRQn_Type dmaIrq[MOCK_DMA_CHANNELS] = {
+     DMA1_Channel1_IRQn, DMA1_Channel2_3_IRQn, DMA1_Channel2_3_IRQn,
+ };
+
+ static MockTimer timers[MOCK_TIMER_COUNT] = {
+     {&MockTIM1,  TIM1_BRK_UP_TRG_COM_IRQn, TIM1_CC_IRQn, 0,                   0, 0},
+     {&MockTIM3,  TIM3_IRQn,                TIM3_IRQn,    DMA_REQUEST_TIM3_UP, 0, 0},
+     {&MockTIM14, TIM14_IRQn,               TIM14_IRQn,   0,                   0, 0},
+     {&MockTIM16, TIM16_IRQn,               TIM16_IRQn,   0,                   0, 0},
+     {&MockTIM17, TIM17_IRQn,               TIM17_IRQn,   0,                   0, 0},
+ };
+
+ static MockDma dma[MOCK_DMA_CHANNELS];
+
+ // Time and clock
+ static uint64_t nowNs = 0;
+ static uint64_t clockEpochNs = 0;      // Last clock change
+ static uint64_t clockEpochCycles = 0;  // Timer clock cycles at that change
+ static uint64_t coreEpochCycles = 0;   // Core clock cycles at that change
+ static uint32_t timerClockHz = HSI_VALUE / 4U;  // 0 in Stop mode
+ static uint64_t simPollAt = 0;
+ static uint64_t stallUntil = MOCK_NEVER;  // End of a flash operation the core waits for
+
+ // RCC and PWR
+ static uint32_t hseReady = 0;
+ static uint32_t hsiDivider = RCC_HSI_DIV4;
+ static uint32_t sysclkSource = RCC_SYSCLKSOURCE_HSI;
+ static uint32_t apbDivider = RCC_APB1_DIV1;
+ static uint32_t flashLatency = FLASH_LATENCY_0;
+ static uint32_t rccFailures = 0;  // RCC configuration calls still to refuse
+ static uint8_t stopped = 0;
+ static uint64_t stopNs = 0;
+
+ // FLASH
+ uint8_t MockFlash[FLASH_PAGE_NB * FLASH_PAGE_SIZE];
+ static uint8_t flashUnlocked = 0;
+ static uint32_t flashWrites = 0;
+ static uint32_t flashErases = 0;
+ static uint8_t flashLoaded = 0;     // Contents survived a power cut
+ static uint32_t flashLastOffset = UINT32_MAX;  // Last double word programmed
+
+ // Core
+ static uint32_t irqEnabled = 0;
+ static uint32_t irqPending = 0;
+ static uint8_t irqPriority[MOCK_IRQ_COUNT + 1];
+ static uint32_t primask = 0;
+ static uint8_t inHandler = 0;
+ static uint8_t sysTickPending = 0;
+ static uint64_t sysTickAt = MOCK_NEVER;  // Next wrap, MOCK_NEVER while disabled or stopped
+
+ // EXTI (lines are shared by all ports, by pin number)
+ static uint16_t extiRising = 0;
+ static uint16_t extiFalling = 0;
+ static uint16_t extiPendingRising = 0;
+ static uint16_t extiPendingFalling = 0;
+
+ // ADC scan over DMA
+ static uint32_t adcRankChannel[MOCK_ADC_RANK_COUNT];
+ static uint64_t adcConversionNs = 0;   // One oversampled conversion
+ static uint64_t adcElementAt = MOCK_NEVER;   // Next conversion result into the DMA buffer
+ static ADC_HandleTypeDef *adcHandle = NULL;
+ static uint32_t adcPolledRank = 0;     // Next rank of a software-started sequence
+
+ // SPI
+ static uint64_t spiByteNs = 0;
+ static uint32_t spiDivider = 0;  // PCLK divider, 0 before HAL_SPI_Init()
+
+ // RTC calendar and alarm, every second
+ static uint64_t rtcOffsetS = 0;  // Calendar ahead of simulated time, under a day
+ static uint8_t rtcAlarmEnabled = 0;
+ static uint8_t rtcAlarmFlag = 0;
+ static uint64_t rtcAlarmAt = MOCK_NEVER;
+
+ // USART1
+ static UART_HandleTypeDef *uartHandle = NULL;
+ static uint64_t uartCharNs = 0;
+ static uint8_t uartHsiker = 0;          // Kernel clock that keeps running in Stop mode
+ static uint8_t uartLine[MOCK_UART_LINE];
+ static uint16_t uartLineCount = 0;
+ static uint16_t uartLineNext = 0;
+ static uint64_t uartRxAt = MOCK_NEVER;      // Stop bit of the next byte on the wire
+ static uint64_t uartIdleAt = MOCK_NEVER;    // Idle line after the last one
+ static uint64_t uartTxDoneAt = MOCK_NEVER;  // Last stop bit of the transmission
+ static uint8_t uartRxPending = 0;     // RDR holds a byte the interrupt has not taken
+ static uint8_t uartOverrun = 0;
+ static uint8_t uartIdlePending = 0;
+ static uint8_t uartTxPending = 0;
+
+ // USART2
+ static UART_HandleTypeDef *uart2Handle = NULL;
+ static uint64_t uart2CharNs = 0;
+ static uint64_t uart2TxDoneAt = MOCK_NEVER;  // Last stop bit of the transmission
+ static uint8_t uart2TxPending = 0;
+
+ // Clock conversions
+ static uint32_t Mock_Pclk(void) {
+     return SystemCoreClock >> apbDivider;
+ }
+
+ // Timer clock cycles at time `ns`
+ static uint64_t Mock_Cycles(uint64_t ns) {
+     return clockEpochCycles +
+            (uint64_t)(((unsigned __int128)(ns - clockEpochNs) * timerClockHz) / MOCK_NS_PER_S);
+ }
+
+ // First time at which the timer cycle count reaches `cycles`, MOCK_NEVER while stopped
+ static uint64_t Mock_CyclesToNs(uint64_t cycles) {
+     unsigned __int128 scaled = (unsigned __int128)(cycles - clockEpochCycles) * MOCK_NS_PER_S;
+
+     if (timerClockHz == 0) {
+         return MOCK_NEVER;
+     }
+     return clockEpochNs + (uint64_t)((scaled + timerClockHz - 1U) / timerClockHz);
+ }
+
+ // Core clock cycles at time `ns`, none while stopped
+ static uint64_t Mock_CoreCyclesAt(uint64_t ns) {
+     return coreEpochCycles +
+            (stopped ? 0U : (uint64_t)(((unsigned __int128)(ns - clockEpochNs) * SystemCoreClock) / MOCK_NS_PER_S));
+ }
+
+ // Time left until `at` at a clock of `oldHz`, run at `newHz` from now on
+ static uint64_t Mock_Rescale(uint64_t at, uint32_t oldHz, uint32_t newHz) {
+     if (at == MOCK_NEVER || at <= nowNs || oldHz == newHz || newHz == 0) {
+         return at;
+     }
+     return nowNs + (uint64_t)(((unsigned __int128)(at - nowNs) * oldHz) / newHz);
+ }
+
+ static uint64_t Mock_SysTickPeriod(void) {
+     return (((uint64_t)(SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U) * MOCK_NS_PER_S) / SystemCoreClock;
+ }
+
+ // Keep VAL at the cycles left in the current period, as the firmware would read it
+ static void Mock_SysTickVal(void) {
+     if (sysTickAt == MOCK_NEVER || sysTickAt <= nowNs) {
+         SysTick->VAL = 0;
+     } else {
+         SysTick->VAL = (uint32_t)(((unsigned __int128)(sysTickAt - nowNs) * SystemCoreClock) / MOCK_NS_PER_S);
+     }
+ }
+
+ // Pick up CTRL writes made since the last step
+ static void Mock_SysTickSync(void) {
+     if (stopped) {
+         return;
+     }
+     if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) {
+         sysTickAt = MOCK_NEVER;
+     } else if (sysTickAt == MOCK_NEVER) {
+         sysTickAt = nowNs + Mock_SysTickPeriod();
+     }
+ }
+
+ static void Mock_Raise(IRQn_Type irq) {
+     irqPending |= 1U << irq;
+ }
+
+ static MockTimer *Mock_FindTimer(const TIM_TypeDef *regs) {
+     for (uint8_t i = 0; i < MOCK_TIMER_COUNT; i++) {
+         if (timers[i].regs == regs) {
+             return &timers[i];
+         }
+     }
+     Sim_Fault("unknown timer instance");
+     return NULL;
+ }
+
+ static MockDma *Mock_FindDma(const DMA_HandleTypeDef *hdma) {
+     ptrdiff_t index = hdma->Instance - MockDMA1_Channel;
+
+     if (hdma->Instance == NULL || index < 0 || index >= MOCK_DMA_CHANNELS) {
+         Sim_Fault("unknown DMA channel");
+     }
+     return &dma[index];
+ }
+
+ // Start a transfer on a channel; the caller sets the timing (doneAt, requests)
+ static HAL_StatusTypeDef Mock_DmaStart(DMA_HandleTypeDef *hdma, uintptr_t source, uintptr_t destination, uint32_t length) {
+     MockDma *channel = Mock_FindDma(hdma);
+
+     if (channel->active || hdma->State == HAL_DMA_STATE_BUSY) {
+         return HAL_BUSY;
+     }
+     if (length == 0) {
+         return HAL_ERROR;
+     }
+     channel->handle = hdma;
+     channel->active = 1;
+     channel->halfPending = 0;
+     channel->fullPending = 0;
+     channel->source = source;
+     channel->destination = destination;
+     channel->length = length;
+     channel->position = 0;
+     channel->doneAt = MOCK_NEVER;
+     hdma->Instance->CNDTR = length;
+     hdma->State = HAL_DMA_STATE_BUSY;
+     return HAL_OK;
+ }
+
+ // Count `elements` transferred and raise the half / full transfer interrupts
+ static void Mock_DmaAdvance(MockDma *channel, uint32_t elements) {
+     DMA_HandleTypeDef *hdma = channel->handle;
+     uint32_t half = channel->length / 2U;
+     uint32_t before = channel->position;
+
+     channel->position += elements;
+     if (before < half && channel->position >= half && hdma->XferHalfCpltCallback != NULL) {
+         channel->halfPending = 1;
+         Mock_Raise(dmaIrq[channel - dma]);
+     }
+     if (channel->position >= channel->length) {
+         channel->fullPending = 1;
+         channel->position = 0;
+         if (hdma->Init.Mode != DMA_CIRCULAR) {
+             channel->active = 0;
+             channel->doneAt = MOCK_NEVER;
+         }
+         Mock_Raise(dmaIrq[channel - dma]);
+     }
+     hdma->Instance->CNDTR = channel->active ? channel->length - channel->position : 0;
+ }
+
+ static uint8_t Mock_DmaSize(uint32_t alignment, uint32_t halfword, uint32_t word) {
+     return (alignment == word) ? 4U : (alignment == halfword) ? 2U : 1U;
+ }
+
+ // One peripheral request (TIM3 update): move one memory element to the register
+ static void Mock_DmaRequest(uint32_t request) {
+     for (uint8_t i = 0; i < MOCK_DMA_CHANNELS; i++) {
+         MockDma *channel = &dma[i];
+         DMA_InitTypeDef *init;
+         uintptr_t from;
+         uint32_t value;
+
+         if (!channel->active || channel->handle->Init.Request != request) {
+             continue;
+         }
+         init = &channel->handle->Init;
+         from = channel->source;
+         if (init->MemInc == DMA_MINC_ENABLE) {
+             from += channel->position * Mock_DmaSize(init->MemDataAlignment,
+                                                      DMA_MDATAALIGN_HALFWORD, DMA_MDATAALIGN_WORD);
+         }
+         switch (Mock_DmaSize(init->MemDataAlignment, DMA_MDATAALIGN_HALFWORD, DMA_MDATAALIGN_WORD)) {
+             case 4:
+                 value = *(const uint32_t *)from;
+                 break;
+             case 2:
+                 value = *(const uint16_t *)from;
+                 break;
+             default:
+                 value = *(const uint8_t *)from;
+                 break;
+         }
+         // Narrow writes to a timer register are zero-extended by the bus
+         *(__IO uint32_t *)channel->destination = value;
+         Mock_DmaAdvance(channel, 1);
+         return;
+     }
+ }
+
+ // Overflow: flag, interrupt, DMA request
+ static void Mock_TimerUpdate(MockTimer *timer) {
+     TIM_TypeDef *regs = timer->regs;
+
+     regs->SR |= TIM_SR_UIF;
+     if (regs->DIER & TIM_IT_UPDATE) {
+         Mock_Raise(timer->updateIrq);
+     }
+     if ((regs->DIER & TIM_DMA_UPDATE) && timer->dmaRequest != 0) {
+         Mock_DmaRequest(timer->dmaRequest);
+     }
+ }
+
+ // Bring a timer's counter up to the given cycle
+ static void Mock_TimerSync(MockTimer *timer, uint64_t cycles) {
+     TIM_TypeDef *regs = timer->regs;
+     uint64_t elapsed = cycles - timer->syncedCycles;
+     uint64_t period = (uint64_t)regs->PSC + 1U;
+     uint64_t ticks;
+
+     timer->syncedCycles = cycles;
+     if (!(regs->CR1 & TIM_CR1_CEN)) {
+         timer->prescaler = 0;
+         return;
+     }
+     ticks = (timer->prescaler + elapsed) / period;
+     timer->prescaler = (uint32_t)((timer->prescaler + elapsed) % period);
+
+     // Nothing to raise per update: just wrap
+     if (!(regs->DIER & (TIM_IT_UPDATE | TIM_DMA_UPDATE)) && !(regs->CR1 & TIM_CR1_OPM)) {
+         uint64_t total = (uint64_t)regs->CNT + ticks;
+
+         if (total > regs->ARR) {
+             regs->SR |= TIM_SR_UIF;
+         }
+         regs->CNT = (uint32_t)(total % ((uint64_t)regs->ARR + 1U));
+         return;
+     }
+     while (ticks > 0) {
+         uint64_t toUpdate = (regs->CNT <= regs->ARR) ? (uint64_t)regs->ARR - regs->CNT + 1U : 1U;
+
+         if (ticks < toUpdate) {
+             regs->CNT += (uint32_t)ticks;
+             break;
+         }
+         ticks -= toUpdate;
+         regs->CNT = 0;
+         Mock_TimerUpdate(timer);
+         if (regs->CR1 & TIM_CR1_OPM) {
+             regs->CR1 &= ~TIM_CR1_CEN;
+             timer->prescaler = 0;
+             break;
+         }
+     }
+ }
+
+ // Next update that raises something, MOCK_NEVER if none
+ static uint64_t Mock_TimerNext(const MockTimer *timer) {
+     const TIM_TypeDef *regs = timer->regs;
+     uint32_t raises = TIM_IT_UPDATE | (timer->dmaRequest != 0 ? TIM_DMA_UPDATE : 0U);
+     uint64_t counts;
+
+     if (!(regs->CR1 & TIM_CR1_CEN) || !(regs->DIER & raises)) {
+         return MOCK_NEVER;
+     }
+     counts = (regs->CNT <= regs->ARR) ? (uint64_t)regs->ARR - regs->CNT + 1U : 1U;
+     return Mock_CyclesToNs(timer->syncedCycles + counts * ((uint64_t)regs->PSC + 1U) - timer->prescaler);
+ }
+
+ static void Mock_SyncTimers(void) {
+     uint64_t cycles = Mock_Cycles(nowNs);
+
+     for (uint8_t i = 0; i < MOCK_TIMER_COUNT; i++) {
+         Mock_TimerSync(&timers[i], cycles);
+     }
+ }
+
+ // One conversion of a rank, oversampled and shifted like the hardware
+ static uint16_t Mock_AdcValue(uint32_t rank) {
+     uint32_t sample = Sim_AdcSample(adcRankChannel[rank % adcHandle->Init.NbrOfConversion]);
+     uint32_t ratio = 1U;
+     uint32_t shift = 0;
+
+     if (adcHandle->Init.OversamplingMode == ENABLE) {
+         ratio = 2U << adcHandle->Init.Oversampling.Ratio;
+         shift = adcHandle->Init.Oversampling.RightBitShift;
+     }
+     return (uint16_t)((sample * ratio) >> shift);
+ }
+
+ // One ADC conversion of the next rank into the DMA buffer
+ static void Mock_AdcConvert(void) {
+     MockDma *channel = Mock_FindDma(adcHandle->DMA_Handle);
+     uint16_t *buffer = (uint16_t *)channel->destination;
+
+     buffer[channel->position] = Mock_AdcValue(channel->position);
+     Mock_DmaAdvance(channel, 1);
+     adcElementAt += adcConversionNs;
+ }
+
+ // When the ADC DMA next reaches half or full transfer
+ static uint64_t Mock_AdcNext(void) {
+     MockDma *channel;
+     uint32_t half;
+     uint32_t boundary;
+
+     if (adcHandle == NULL || adcElementAt == MOCK_NEVER) {
+         return MOCK_NEVER;
+     }
+     channel = Mock_FindDma(adcHandle->DMA_Handle);
+     half = channel->length / 2U;
+     boundary = (channel->position < half) ? half : channel->length;
+     return adcElementAt + adcConversionNs * (boundary - channel->position - 1U);
+ }
+
+ // One byte off the wire into RDR, taken by the receive interrupt
+ static void Mock_UartByte(void) {
+     uint8_t byte = uartLine[uartLineNext++];
+
+     if (uartLineNext < uartLineCount) {
+         uartRxAt += uartCharNs;
+     } else {
+         uartIdleAt = uartRxAt + uartCharNs;
+         uartRxAt = MOCK_NEVER;
+         USART1->ISR &= ~USART_ISR_BUSY;
+     }
+     if (stopped || uartHandle->RxState != HAL_UART_STATE_BUSY_RX) {
+         return;
+     }
+     if (uartRxPending) {
+         uartOverrun = 1;
+     }
+     USART1->RDR = byte;
+     uartRxPending = 1;
+     Mock_Raise(USART1_IRQn);
+ }
+
+ // Calendar seconds since midnight on 1 January
+ static uint64_t Mock_RtcSeconds(void) {
+     return nowNs / MOCK_NS_PER_S + rtcOffsetS;
+ }
+
+ // TR from the calendar: hours, minutes and seconds as two BCD digits each
+ static void Mock_RtcCalendar(void) {
+     uint32_t timeOfDay = (uint32_t)(Mock_RtcSeconds() % 86400U);
+     uint32_t fields[3] = {timeOfDay / 3600U, (timeOfDay / 60U) % 60U, timeOfDay % 60U};
+     uint32_t tr = 0;
+
+     for (uint8_t i = 0; i < 3U; i++) {
+         tr = (tr << 8) | ((fields[i] / 10U) << 4) | (fields[i] % 10U);
+     }
+     RTC->TR = tr;
+ }
+
+ // Earliest pending event
+ static uint64_t Mock_NextEvent(void) {
+     uint64_t next = simPollAt;
+
+     if (stallUntil < next) {
+         next = stallUntil;
+     }
+     Mock_SysTickSync();
+     if (sysTickAt < next) {
+         next = sysTickAt;
+     }
+     for (uint8_t i = 0; i < MOCK_TIMER_COUNT; i++) {
+         uint64_t at = Mock_TimerNext(&timers[i]);
+
+         if (at < next) {
+             next = at;
+         }
+     }
+     for (uint8_t i = 0; i < MOCK_DMA_CHANNELS; i++) {
+         if (dma[i].active && dma[i].doneAt < next) {
+             next = dma[i].doneAt;
+         }
+     }
+     if (Mock_AdcNext() < next) {
+         next = Mock_AdcNext();
+     }
+     if (rtcAlarmEnabled && rtcAlarmAt < next) {
+         next = rtcAlarmAt;
+     }
+     if (uartRxAt < next) {
+         next = uartRxAt;
+     }
+     if (uartIdleAt < next) {
+         next = uartIdleAt;
+     }
+     if (uartTxDoneAt < next) {
+         next = uartTxDoneAt;
+     }
+     if (uart2TxDoneAt < next) {
+         next = uart2TxDoneAt;
+     }
+     return next;
+ }
+
+ // Advance simulated time to the next event and raise everything due by then
+ static void Mock_Step(void) {
+     uint64_t next = Mock_NextEvent();
+
+     if (next == MOCK_NEVER) {
+         Sim_Fault("sleeping with no wakeup source");
+     }
+     if (next > nowNs) {
+         nowNs = next;
+     }
+     Mock_SyncTimers();
+     Mock_RtcCalendar();
+
+     while (nowNs >= sysTickAt) {
+         if (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) {
+             sysTickPending = 1;
+         }
+         sysTickAt += Mock_SysTickPeriod();
+     }
+     Mock_SysTickVal();
+     while (adcHandle != NULL && nowNs >= adcElementAt) {
+         Mock_AdcConvert();
+     }
+     for (uint8_t i = 0; i < MOCK_DMA_CHANNELS; i++) {
+         if (dma[i].active && nowNs >= dma[i].doneAt) {
+             Mock_DmaAdvance(&dma[i], dma[i].length - dma[i].position);
+         }
+     }
+     if (rtcAlarmEnabled && nowNs >= rtcAlarmAt) {
+         rtcAlarmFlag = 1;
+         rtcAlarmAt += MOCK_NS_PER_S;
+         Mock_Raise(RTC_IRQn);
+     }
+     while (nowNs >= uartRxAt) {
+         Mock_UartByte();
+     }
+     if (nowNs >= uartIdleAt) {
+         uartIdleAt = MOCK_NEVER;
+         if (uartHandle->RxState == HAL_UART_STATE_BUSY_RX) {
+             uartIdlePending = 1;
+             Mock_Raise(USART1_IRQn);
+         }
+     }
+     if (nowNs >= uartTxDoneAt) {
+         uartTxDoneAt = MOCK_NEVER;
+         uartTxPending = 1;
+         Mock_Raise(USART1_IRQn);
+     }
+     if (nowNs >= uart2TxDoneAt) {
+         uart2TxDoneAt = MOCK_NEVER;
+         uart2TxPending = 1;
+         Mock_Raise(USART2_IRQn);
+     }
+     if (nowNs >= simPollAt) {
+         simPollAt = Sim_Poll(nowNs);
+         if (simPollAt <= nowNs) {
+             simPollAt = nowNs + 1U;
+         }
+     }
+ }
+
+ static uint8_t Mock_WakePending(void) {
+     return sysTickPending || (irqPending & irqEnabled) != 0;
+ }
+
+ // Run pending interrupts, highest priority first, until none is left or PRIMASK is set
+ static void Mock_Dispatch(void) {
+     if (inHandler) {
+         return;
+     }
+     inHandler = 1;
+     while (!primask) {
+         uint32_t ready = irqPending & irqEnabled;
+         uint32_t best = MOCK_IRQ_COUNT + 1U;
+
+         if (sysTickPending) {
+             best = MOCK_SYSTICK_IRQ;
+         }
+         for (uint32_t irq = 0; irq < MOCK_IRQ_COUNT; irq++) {
+             if ((ready & (1U << irq)) &&
+                 (best > MOCK_SYSTICK_IRQ || irqPriority[irq] < irqPriority[best])) {
+                 best = irq;
+             }
+         }
+         if (best > MOCK_SYSTICK_IRQ) {
+             break;
+         }
+         if (best == MOCK_SYSTICK_IRQ) {
+             sysTickPending = 0;
+             HAL_IncTick();
+         } else {
+             irqPending &= ~(1U << best);
+             if (vectors[best] == NULL) {
+                 Sim_Fault("interrupt without a handler");
+             }
+             vectors[best]();
+         }
+     }
+     inHandler = 0;
+ }
+
+ // Sleep until something can run
+ static void Mock_Sleep(void) {
+     while (!Mock_WakePending()) {
+         Mock_Step();
+     }
+ }
+
+ // Core stalled for `ns` on a flash operation: time passes, interrupts wait
+ static void Mock_Stall(uint64_t ns) {
+     stallUntil = nowNs + ns;
+     while (nowNs < stallUntil) {
+         Mock_Step();
+     }
+     stallUntil = MOCK_NEVER;
+     Mock_Dispatch();
+ }
+
+ // Simulator interface
+ uint64_t Mock_NowNs(void) {
+     return nowNs;
+ }
+
+ uint64_t Mock_StopNs(void) {
+     return stopNs;
+ }
+
+ uint64_t Mock_CoreCycles(void) {
+     return Mock_CoreCyclesAt(nowNs);
+ }
+
+ void Mock_SetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState level) {
+     uint16_t before = (uint16_t)(port->IDR & pin);
+     IRQn_Type irq = (pin & 0x0003U) ? EXTI0_1_IRQn : (pin & 0x000CU) ? EXTI2_3_IRQn : EXTI4_15_IRQn;
+
+     if (level == GPIO_PIN_SET) {
+         port->IDR |= pin;
+     } else {
+         port->IDR &= ~(uint32_t)pin;
+     }
+     if (before && level == GPIO_PIN_RESET && (extiFalling & pin)) {
+         extiPendingFalling |= pin;
+         Mock_Raise(irq);
+     } else if (!before && level == GPIO_PIN_SET && (extiRising & pin)) {
+         extiPendingRising |= pin;
+         Mock_Raise(irq);
+     }
+ }
+
+ uint32_t Mock_FlashWrites(void) {
+     return flashWrites;
+ }
+
+ void Mock_FailRcc(uint32_t calls) {
+     rccFailures = calls;
+ }
+
+ uint32_t Mock_FlashErases(void) {
+     return flashErases;
+ }
+
+ void Mock_Capture(TIM_TypeDef *tim, uint32_t channel) {
+     MockTimer *timer = Mock_FindTimer(tim);
+     uint32_t index = channel / 4U;
+     __IO uint32_t *ccr[4] = {&tim->CCR1, &tim->CCR2, &tim->CCR3, &tim->CCR4};
+
+     if (!(tim->CR1 & TIM_CR1_CEN)) {
+         return;
+     }
+     *ccr[index] = tim->CNT;
+     tim->SR |= TIM_SR_CC1IF << index;
+     if (tim->DIER & (TIM_IT_CC1 << index)) {
+         Mock_Raise(timer->captureIrq);
+     }
+ }
+
+ void Mock_SetRtcTime(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+     uint64_t timeOfDay = (uint64_t)hours * 3600U + (uint64_t)minutes * 60U + seconds;
+     uint64_t elapsed = (nowNs / MOCK_NS_PER_S) % 86400U;
+
+     rtcOffsetS = (timeOfDay + 86400U - elapsed) % 86400U;
+     Mock_RtcCalendar();
+ }
+
+ void Mock_LoadFlash(const uint8_t *image) {
+     memcpy(MockFlash, image, sizeof(MockFlash));
+     flashLoaded = 1;
+ }
+
+ void Mock_TearLastFlashWrite(void) {
+     if (flashLastOffset != UINT32_MAX) {
+         memset(&MockFlash[flashLastOffset + sizeof(uint32_t)], 0xFF, sizeof(uint32_t));
+     }
+ }
+
+ // Cortex-M0+ core
+ // A frame from the bus master, starting now; one at a time
+ void Mock_UartReceive(const uint8_t *data, uint16_t size) {
+     if (size == 0 || size > MOCK_UART_LINE || uartRxAt != MOCK_NEVER) {
+         Sim_Fault("USART1 frame overlaps the previous one");
+     }
+     if (uartHandle == NULL) {
+         return;
+     }
+     memcpy(uartLine, data, size);
+     uartLineCount = size;
+     uartLineNext = 0;
+     uartRxAt = nowNs + uartCharNs;
+     uartIdleAt = MOCK_NEVER;
+     USART1->ISR |= USART_ISR_BUSY;
+     if (uartHsiker && (USART1->CR1 & USART_CR1_UESM)) {
+         USART1->ISR |= USART_ISR_WUF;
+         if (USART1->CR3 & USART_CR3_WUFIE) {
+             Mock_Raise(USART1_IRQn);
+         }
+     }
+ }
+
+ void __disable_irq(void) {
+     primask = 1;
+ }
+
+ void __enable_irq(void) {
+     primask = 0;
+     Mock_Dispatch();
+ }
+
+ uint32_t __get_PRIMASK(void) {
+     return primask;
+ }
+
+ void __set_PRIMASK(uint32_t priMask) {
+     primask = priMask & 1U;
+     if (!primask) {
+         Mock_Dispatch();
+     }
+ }
+
+ void __WFI(void) {
+     Sim_Sleep();
+     Mock_Sleep();
+     Sim_Wake();
+     Mock_Dispatch();
+ }
+
+ void __DMB(void) {
+ }
+
+ void __DSB(void) {
+ }
+
+ void __ISB(void) {
+ }
+
+ void __NOP(void) {
+ }
+
+ void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) {
+     (void)SubPriority;
+     irqPriority[(IRQn == SysTick_IRQn) ? MOCK_SYSTICK_IRQ : (uint32_t)IRQn] = (uint8_t)PreemptPriority;
+ }
+
+ void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+     irqEnabled |= 1U << IRQn;
+ }
+
+ void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+     irqEnabled &= ~(1U << IRQn);
+ }
+
+ // HAL core
+ // A freshly programmed part: the pages past the image are erased
+ HAL_StatusTypeDef HAL_Init(void) {
+     if (!flashLoaded) {
+         memset(MockFlash, 0xFF, sizeof(MockFlash));
+     }
+     return HAL_InitTick(TICK_INT_PRIORITY);
+ }
+
+ // As the HAL's weak version: restarts SysTick with a 1 ms period at the current SYSCLK
+ __attribute__((weak)) HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority) {
+     SysTick->LOAD = SystemCoreClock / (1000U / (uint32_t)uwTickFreq) - 1U;
+     SysTick->VAL = 0;
+     SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+     sysTickAt = nowNs + Mock_SysTickPeriod();
+     HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+     uwTickPrio = TickPriority;
+     return HAL_OK;
+ }
+
+ uint32_t HAL_GetTick(void) {
+     return uwTick;
+ }
+
+ void HAL_IncTick(void) {
+     uwTick++;
+ }
+
+ void HAL_Delay(uint32_t Delay) {
+     uint32_t start = HAL_GetTick();
+     uint32_t wait = (Delay < HAL_MAX_DELAY) ? Delay + 1U : Delay;
+
+     if (primask || inHandler) {
+         Sim_Fault("HAL_Delay() with SysTick blocked");
+     }
+     while (HAL_GetTick() - start < wait) {
+         Mock_Sleep();
+         Mock_Dispatch();
+     }
+ }
+
+ void HAL_SuspendTick(void) {
+     SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+ }
+
+ void HAL_ResumeTick(void) {
+     SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+ }
+
+ // GPIO
+ void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+     uint16_t pins = (uint16_t)GPIO_Init->Pin;
+
+     // Like the HAL, only EXTI modes touch the EXTI configuration
+     if (GPIO_Init->Mode & 0x30U) {
+         extiRising = (GPIO_Init->Mode & 0x10U) ? (extiRising | pins) : (extiRising & ~pins);
+         extiFalling = (GPIO_Init->Mode & 0x20U) ? (extiFalling | pins) : (extiFalling & ~pins);
+     }
+     // Inputs idle at their pull level until the simulator drives them
+     if ((GPIO_Init->Mode == GPIO_MODE_INPUT || (GPIO_Init->Mode & 0x30U)) && GPIO_Init->Pull == GPIO_PULLUP) {
+         GPIOx->IDR |= pins;
+     }
+ }
+
+ GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+     return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+ }
+
+ void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+     if (PinState == GPIO_PIN_SET) {
+         GPIOx->ODR |= GPIO_Pin;
+     } else {
+         GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+     }
+ }
+
+ void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+     GPIOx->ODR ^= GPIO_Pin;
+ }
+
+ void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin) {
+     if (extiPendingRising & GPIO_Pin) {
+         extiPendingRising &= ~GPIO_Pin;
+         HAL_GPIO_EXTI_Rising_Callback(GPIO_Pin);
+     }
+     if (extiPendingFalling & GPIO_Pin) {
+         extiPendingFalling &= ~GPIO_Pin;
+         HAL_GPIO_EXTI_Falling_Callback(GPIO_Pin);
+     }
+ }
+
+ __attribute__((weak)) void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin) {
+     (void)GPIO_Pin;
+ }
+
+ __attribute__((weak)) void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin) {
+     (void)GPIO_Pin;
+ }
+
+ // RCC
+ // Start a new clock epoch at the current time
+ static void Mock_ClockEpoch(void) {
+     Mock_SyncTimers();
+     coreEpochCycles = Mock_CoreCyclesAt(nowNs);
+     clockEpochCycles = Mock_Cycles(nowNs);
+     clockEpochNs = nowNs;
+ }
+
+ static void Mock_SpiTiming(void) {
+     if (spiDivider != 0) {
+         spiByteNs = (8U * (uint64_t)spiDivider * MOCK_NS_PER_S) / Mock_Pclk();
+     }
+ }
+
+ // Sampling + 12.5 conversion cycles, in tenths of an ADC clock, per oversampled conversion
+ static void Mock_AdcTiming(const ADC_HandleTypeDef *hadc) {
+     static const uint32_t samplingTenths[8] = {15, 35, 75, 125, 195, 395, 795, 1605};
+     uint64_t adcHz = Mock_Pclk() >> hadc->Init.ClockPrescaler;
+     uint64_t tenths = samplingTenths[hadc->Init.SamplingTimeCommon1 & 7U] + 125U;
+
+     if (hadc->Init.OversamplingMode == ENABLE) {
+         tenths *= 2U << hadc->Init.Oversampling.Ratio;
+     }
+     adcConversionNs = (tenths * MOCK_NS_PER_S) / (10U * adcHz);
+ }
+
+ // Change SYSCLK and the APB divider without disturbing the timers' cycle counts
+ static void Mock_SetClocks(uint32_t sysclk, uint32_t apb) {
+     uint32_t oldCore = SystemCoreClock;
+     uint32_t oldPclk = Mock_Pclk();
+
+     Mock_ClockEpoch();
+     Mock_SysTickVal();
+     SystemCoreClock = sysclk;
+     apbDivider = apb;
+     timerClockHz = Mock_Pclk() << (apbDivider != RCC_APB1_DIV1 ? 1U : 0U);
+
+     // What is in flight finishes at the new rate
+     sysTickAt = Mock_Rescale(sysTickAt, oldCore, SystemCoreClock);
+     adcElementAt = Mock_Rescale(adcElementAt, oldPclk, Mock_Pclk());
+     for (uint8_t i = 0; i < MOCK_DMA_CHANNELS; i++) {
+         dma[i].doneAt = Mock_Rescale(dma[i].doneAt, oldPclk, Mock_Pclk());
+     }
+     Mock_SpiTiming();
+     if (adcHandle != NULL) {
+         Mock_AdcTiming(adcHandle);
+     }
+ }
+
+ static void Mock_CheckFlash(void) {
+     if (SystemCoreClock > 24000000U && flashLatency == FLASH_LATENCY_0) {
+         Sim_Fault("SYSCLK above 24 MHz without a flash wait state");
+     }
+ }
+
+ HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct) {
+     if (rccFailures > 0) {
+         rccFailures--;
+         return HAL_TIMEOUT;
+     }
+     if (RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSE) {
+         hseReady = (RCC_OscInitStruct->HSEState == RCC_HSE_ON);
+     }
+     if (RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSI) {
+         hsiDivider = RCC_OscInitStruct->HSIDiv;
+         // Running from HSISYS: the new divider applies at once, and the HAL retunes SysTick
+         if (sysclkSource == RCC_SYSCLKSOURCE_HSI) {
+             Mock_SetClocks(HSI_VALUE >> hsiDivider, apbDivider);
+             Mock_CheckFlash();
+             return HAL_InitTick(uwTickPrio);
+         }
+     }
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency) {
+     uint32_t sysclk = SystemCoreClock;
+     uint32_t apb = apbDivider;
+
+     if (rccFailures > 0) {
+         rccFailures--;
+         return HAL_TIMEOUT;
+     }
+     if (RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_SYSCLK) {
+         if (RCC_ClkInitStruct->SYSCLKSource == RCC_SYSCLKSOURCE_HSE) {
+             if (!hseReady) {
+                 return HAL_ERROR;
+             }
+             sysclk = HSE_VALUE;
+         } else {
+             sysclk = HSI_VALUE >> hsiDivider;
+         }
+         sysclkSource = RCC_ClkInitStruct->SYSCLKSource;
+     }
+     if (RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_PCLK1) {
+         apb = RCC_ClkInitStruct->APB1CLKDivider;
+     }
+     flashLatency = FLatency;
+     Mock_SetClocks(sysclk, apb);
+     Mock_CheckFlash();
+     return HAL_InitTick(uwTickPrio);
+ }
+
+ HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit) {
+     if (PeriphClkInit->PeriphClockSelection & RCC_PERIPHCLK_USART1) {
+         uartHsiker = (PeriphClkInit->Usart1ClockSelection == RCC_USART1CLKSOURCE_HSIKER);
+     }
+     return HAL_OK;
+ }
+
+ uint32_t HAL_RCC_GetSysClockFreq(void) {
+     return SystemCoreClock;
+ }
+
+ uint32_t HAL_RCC_GetHCLKFreq(void) {
+     return SystemCoreClock;
+ }
+
+ uint32_t HAL_RCC_GetPCLK1Freq(void) {
+     return Mock_Pclk();
+ }
+
+ // PWR: Stop mode until an EXTI line or the RTC alarm, then on HSISYS
+ void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry) {
+     uint64_t enteredNs = nowNs;
+     uint64_t sysTickLeft = (sysTickAt == MOCK_NEVER) ? MOCK_NEVER : sysTickAt - nowNs;
+     uint64_t adcLeft = (adcElementAt == MOCK_NEVER) ? MOCK_NEVER : adcElementAt - nowNs;
+
+     (void)Regulator;
+     (void)STOPEntry;
+     for (uint8_t i = 0; i < MOCK_DMA_CHANNELS; i++) {
+         if (dma[i].active && dma[i].handle->Init.Mode != DMA_CIRCULAR) {
+             Sim_Fault("Stop mode with a DMA transfer running");
+         }
+     }
+     if (uartTxDoneAt != MOCK_NEVER || uart2TxDoneAt != MOCK_NEVER) {
+         Sim_Fault("Stop mode with a USART transmission running");
+     }
+
+     Mock_ClockEpoch();
+     stopped = 1;
+     timerClockHz = 0;
+     sysTickAt = MOCK_NEVER;
+     adcElementAt = MOCK_NEVER;
+
+     Sim_Sleep();
+     Mock_Sleep();
+     Sim_Wake();
+
+     Mock_ClockEpoch();
+     stopped = 0;
+     stopNs += nowNs - enteredNs;
+     sysTickAt = (sysTickLeft == MOCK_NEVER) ? MOCK_NEVER : nowNs + sysTickLeft;
+     adcElementAt = (adcLeft == MOCK_NEVER) ? MOCK_NEVER : nowNs + adcLeft;
+     sysclkSource = RCC_SYSCLKSOURCE_HSI;
+     Mock_SetClocks(HSI_VALUE >> hsiDivider, apbDivider);
+     Mock_Dispatch();
+ }
+
+ // FLASH
+ HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+     flashUnlocked = 1;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+     flashUnlocked = 0;
+     return HAL_OK;
+ }
+
+ // Only into an erased, aligned double word, as PROGERR and PGAERR would stop it
+ HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data) {
+     uintptr_t offset = (uintptr_t)Address - (uintptr_t)MockFlash;
+
+     if (TypeProgram != FLASH_TYPEPROGRAM_DOUBLEWORD || !flashUnlocked) {
+         return HAL_ERROR;
+     }
+     if ((uintptr_t)Address < (uintptr_t)MockFlash || offset + sizeof(Data) > sizeof(MockFlash)) {
+         Sim_Fault("flash program outside the flash");
+     }
+     if ((offset % sizeof(Data)) != 0U) {
+         return HAL_ERROR;
+     }
+     for (uint32_t i = 0; i < sizeof(Data); i++) {
+         if (MockFlash[offset + i] != 0xFFU) {
+             return HAL_ERROR;
+         }
+     }
+     memcpy(&MockFlash[offset], &Data, sizeof(Data));
+     flashLastOffset = (uint32_t)offset;
+     flashWrites++;
+     Mock_Stall(MOCK_FLASH_PROGRAM_NS);
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError) {
+     *PageError = 0xFFFFFFFFU;
+     if (pEraseInit->TypeErase != FLASH_TYPEERASE_PAGES || !flashUnlocked ||
+         pEraseInit->Page + pEraseInit->NbPages > FLASH_PAGE_NB) {
+         *PageError = pEraseInit->Page;
+         return HAL_ERROR;
+     }
+     // The erase stalls the CPU for longer than a control period: the speed loop would stop
+     if (MockTIM3.CCR3 != 0U || MockTIM3.CCR4 != 0U) {
+         Sim_Fault("flash page erase with the motor driven");
+     }
+     if ((MockTIM14.CR1 & TIM_CR1_CEN) != 0U) {
+         Sim_Fault("flash page erase during a program step");
+     }
+     for (uint32_t page = pEraseInit->Page; page < pEraseInit->Page + pEraseInit->NbPages; page++) {
+         memset(&MockFlash[page * FLASH_PAGE_SIZE], 0xFF, FLASH_PAGE_SIZE);
+         flashErases++;
+         Mock_Stall(MOCK_FLASH_ERASE_NS);
+     }
+     return HAL_OK;
+ }
+
+ // DMA
+ HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+     MockDma *channel;
+
+     if (hdma == NULL) {
+         return HAL_ERROR;
+     }
+     channel = Mock_FindDma(hdma);
+     channel->handle = hdma;
+     channel->active = 0;
+     channel->doneAt = MOCK_NEVER;
+     hdma->State = HAL_DMA_STATE_READY;
+     hdma->ErrorCode = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength) {
+     return Mock_DmaStart(hdma, SrcAddress, DstAddress, DataLength);
+ }
+
+ HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma) {
+     MockDma *channel = Mock_FindDma(hdma);
+
+     channel->active = 0;
+     channel->halfPending = 0;
+     channel->fullPending = 0;
+     channel->doneAt = MOCK_NEVER;
+     hdma->Instance->CNDTR = 0;
+     hdma->State = HAL_DMA_STATE_READY;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma) {
+     HAL_DMA_Abort(hdma);
+     if (hdma->XferAbortCallback != NULL) {
+         hdma->XferAbortCallback(hdma);
+     }
+     return HAL_OK;
+ }
+
+ void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+     MockDma *channel = Mock_FindDma(hdma);
+
+     if (channel->handle != hdma) {
+         return;
+     }
+     if (channel->halfPending) {
+         channel->halfPending = 0;
+         if (hdma->XferHalfCpltCallback != NULL) {
+             hdma->XferHalfCpltCallback(hdma);
+         }
+     }
+     if (channel->fullPending) {
+         channel->fullPending = 0;
+         if (hdma->Init.Mode != DMA_CIRCULAR) {
+             hdma->State = HAL_DMA_STATE_READY;
+         }
+         if (hdma->XferCpltCallback != NULL) {
+             hdma->XferCpltCallback(hdma);
+         }
+     }
+ }
+
+ // ADC
+ static void Mock_AdcHalfDone(DMA_HandleTypeDef *hdma) {
+     HAL_ADC_ConvHalfCpltCallback((ADC_HandleTypeDef *)hdma->Parent);
+ }
+
+ static void Mock_AdcDone(DMA_HandleTypeDef *hdma) {
+     HAL_ADC_ConvCpltCallback((ADC_HandleTypeDef *)hdma->Parent);
+ }
+
+ static void Mock_AdcError(DMA_HandleTypeDef *hdma) {
+     HAL_ADC_ErrorCallback((ADC_HandleTypeDef *)hdma->Parent);
+ }
+
+ HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc) {
+     if (hadc->Init.NbrOfConversion == 0 || hadc->Init.NbrOfConversion > MOCK_ADC_RANK_COUNT) {
+         return HAL_ERROR;
+     }
+     Mock_AdcTiming(hadc);
+     adcHandle = hadc;
+     hadc->ErrorCode = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig) {
+     (void)hadc;
+     if (sConfig->Rank == 0 || sConfig->Rank > MOCK_ADC_RANK_COUNT || sConfig->Channel >= MOCK_ADC_CHANNEL_COUNT) {
+         return HAL_ERROR;
+     }
+     adcRankChannel[sConfig->Rank - 1U] = sConfig->Channel;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_ADCEx_Calibration_Start(ADC_HandleTypeDef *hadc) {
+     (void)hadc;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length) {
+     DMA_HandleTypeDef *hdma = hadc->DMA_Handle;
+     HAL_StatusTypeDef status;
+
+     if (hdma == NULL || hadc != adcHandle || Length < 2U) {
+         return HAL_ERROR;
+     }
+     hdma->XferHalfCpltCallback = Mock_AdcHalfDone;
+     hdma->XferCpltCallback = Mock_AdcDone;
+     hdma->XferErrorCallback = Mock_AdcError;
+     status = Mock_DmaStart(hdma, (uintptr_t)&hadc->Instance->DR, (uintptr_t)pData, Length);
+     if (status == HAL_OK) {
+         adcElementAt = nowNs + adcConversionNs;
+     }
+     return status;
+ }
+
+ // Software-started sequence, read one conversion at a time; takes no simulated time
+ HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc) {
+     if (hadc != adcHandle || adcElementAt != MOCK_NEVER) {
+         return HAL_ERROR;
+     }
+     adcPolledRank = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc, uint32_t Timeout) {
+     (void)Timeout;
+     return (hadc == adcHandle && adcPolledRank < hadc->Init.NbrOfConversion) ? HAL_OK : HAL_TIMEOUT;
+ }
+
+ uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc) {
+     (void)hadc;
+     return Mock_AdcValue(adcPolledRank++);
+ }
+
+ HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc) {
+     adcElementAt = MOCK_NEVER;
+     return HAL_DMA_Abort(hadc->DMA_Handle);
+ }
+
+ __attribute__((weak)) void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+     (void)hadc;
+ }
+
+ __attribute__((weak)) void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+     (void)hadc;
+ }
+
+ __attribute__((weak)) void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc) {
+     (void)hadc;
+ }
+
+ // SPI
+ static void Mock_SpiTxDone(DMA_HandleTypeDef *hdma) {
+     HAL_SPI_TxCpltCallback((SPI_HandleTypeDef *)hdma->Parent);
+ }
+
+ static void Mock_SpiError(DMA_HandleTypeDef *hdma) {
+     HAL_SPI_ErrorCallback((SPI_HandleTypeDef *)hdma->Parent);
+ }
+
+ HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) {
+     if (hspi->Instance == NULL) {
+         return HAL_ERROR;
+     }
+     spiDivider = 2U << (hspi->Init.BaudRatePrescaler >> 3);
+     Mock_SpiTiming();
+     hspi->ErrorCode = 0;
+     return HAL_OK;
+ }
+
+ // Blocking transmit: the bytes go out at once, without simulated time
+ HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+     (void)Timeout;
+     if (pData == NULL || Size == 0) {
+         return HAL_ERROR;
+     }
+     if (hspi->hdmatx != NULL && hspi->hdmatx->State == HAL_DMA_STATE_BUSY) {
+         return HAL_BUSY;
+     }
+     Sim_SpiTransmit(pData, Size);
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size) {
+     DMA_HandleTypeDef *hdma = hspi->hdmatx;
+     HAL_StatusTypeDef status;
+
+     if (hdma == NULL || pData == NULL || Size == 0) {
+         return HAL_ERROR;
+     }
+     hdma->XferHalfCpltCallback = NULL;
+     hdma->XferCpltCallback = Mock_SpiTxDone;
+     hdma->XferErrorCallback = Mock_SpiError;
+     status = Mock_DmaStart(hdma, (uintptr_t)pData, (uintptr_t)&hspi->Instance->DR, Size);
+     if (status == HAL_OK) {
+         Mock_FindDma(hdma)->doneAt = nowNs + spiByteNs * Size;
+         Sim_SpiTransmit(pData, Size);
+     }
+     return status;
+ }
+
+ void HAL_SPI_IRQHandler(SPI_HandleTypeDef *hspi) {
+     (void)hspi;
+ }
+
+ __attribute__((weak)) void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+     (void)hspi;
+ }
+
+ __attribute__((weak)) void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+     (void)hspi;
+ }
+
+ // UART
+ // Start bit, data bits (parity included in the word length) and stop bits
+ static uint64_t Mock_UartCharNs(const UART_HandleTypeDef *huart) {
+     uint32_t bits = 1U + ((huart->Init.WordLength == UART_WORDLENGTH_9B) ? 9U : 8U) +
+                     ((huart->Init.StopBits == UART_STOPBITS_2) ? 2U : 1U);
+
+     return ((uint64_t)bits * MOCK_NS_PER_S) / huart->Init.BaudRate;
+ }
+
+ // USART2 only; USART1 is brought up as the RS-485 port
+ HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+     if (huart == NULL || huart->Instance != USART2 || huart->Init.BaudRate == 0 ||
+         huart->Init.Mode != UART_MODE_TX) {
+         return HAL_ERROR;
+     }
+     uart2CharNs = Mock_UartCharNs(huart);
+     uart2Handle = huart;
+     huart->gState = HAL_UART_STATE_READY;
+     huart->RxState = HAL_UART_STATE_READY;
+     huart->ErrorCode = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_RS485Ex_Init(UART_HandleTypeDef *huart, uint32_t Polarity, uint32_t AssertionTime, uint32_t DeassertionTime) {
+     (void)Polarity;
+     (void)AssertionTime;
+     (void)DeassertionTime;
+     if (huart == NULL || huart->Instance != USART1 || huart->Init.BaudRate == 0) {
+         return HAL_ERROR;
+     }
+     uartCharNs = Mock_UartCharNs(huart);
+     uartHandle = huart;
+     huart->gState = HAL_UART_STATE_READY;
+     huart->RxState = HAL_UART_STATE_READY;
+     huart->ErrorCode = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+     if ((huart != uartHandle && huart != uart2Handle) || pData == NULL || Size == 0) {
+         return HAL_ERROR;
+     }
+     if (huart->gState != HAL_UART_STATE_READY) {
+         return HAL_BUSY;
+     }
+     huart->gState = HAL_UART_STATE_BUSY_TX;
+     huart->pTxBuffPtr = pData;
+     huart->TxXferSize = Size;
+     if (huart == uart2Handle) {
+         uart2TxDoneAt = nowNs + uart2CharNs * Size;
+         Sim_Usart2Transmit(pData, Size);
+     } else {
+         uartTxDoneAt = nowNs + uartCharNs * Size;
+         Sim_UartTransmit(pData, Size);
+     }
+     return HAL_OK;
+ }
+
+ // Blocking, USART2 only; like a blocking SPI transmit it takes no simulated time
+ HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+     (void)Timeout;
+     if (huart != uart2Handle || pData == NULL || Size == 0) {
+         return HAL_ERROR;
+     }
+     if (huart->gState != HAL_UART_STATE_READY) {
+         return HAL_BUSY;
+     }
+     Sim_Usart2Transmit(pData, Size);
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+     if (huart != uartHandle || pData == NULL || Size == 0) {
+         return HAL_ERROR;
+     }
+     if (huart->RxState != HAL_UART_STATE_READY) {
+         return HAL_BUSY;
+     }
+     huart->pRxBuffPtr = pData;
+     huart->RxXferSize = Size;
+     huart->RxXferCount = Size;
+     huart->RxEventType = HAL_UART_RXEVENT_TC;
+     huart->ErrorCode = 0;
+     huart->RxState = HAL_UART_STATE_BUSY_RX;
+     return HAL_OK;
+ }
+
+ HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart) {
+     return huart->RxEventType;
+ }
+
+ HAL_StatusTypeDef HAL_UARTEx_StopModeWakeUpSourceConfig(UART_HandleTypeDef *huart, UART_WakeUpTypeDef WakeUpSelection) {
+     (void)huart;
+     return (WakeUpSelection.WakeUpEvent == UART_WAKEUP_ON_STARTBIT) ? HAL_OK : HAL_ERROR;
+ }
+
+ HAL_StatusTypeDef HAL_UARTEx_EnableStopMode(UART_HandleTypeDef *huart) {
+     huart->Instance->CR1 |= USART_CR1_UESM;
+     return HAL_OK;
+ }
+
+ // Wakeup, received byte (ending the reception when the buffer is full), overrun,
+ // idle line and end of transmission
+ void HAL_UART_IRQHandler(UART_HandleTypeDef *huart) {
+     if (huart == uart2Handle && uart2TxPending) {
+         uart2TxPending = 0;
+         huart->gState = HAL_UART_STATE_READY;
+         HAL_UART_TxCpltCallback(huart);
+         return;
+     }
+     if (huart != uartHandle) {
+         return;
+     }
+     if ((huart->Instance->ISR & USART_ISR_WUF) && (huart->Instance->CR3 & USART_CR3_WUFIE)) {
+         huart->Instance->ISR &= ~USART_ISR_WUF;
+         HAL_UARTEx_WakeupCallback(huart);
+     }
+     if (uartRxPending) {
+         uartRxPending = 0;
+         if (uartOverrun) {
+             uartOverrun = 0;
+             huart->RxState = HAL_UART_STATE_READY;
+             huart->ErrorCode = HAL_UART_ERROR_ORE;
+             HAL_UART_ErrorCallback(huart);
+         } else if (huart->RxState == HAL_UART_STATE_BUSY_RX) {
+             huart->pRxBuffPtr[huart->RxXferSize - huart->RxXferCount] = (uint8_t)huart->Instance->RDR;
+             if (--huart->RxXferCount == 0) {
+                 huart->RxState = HAL_UART_STATE_READY;
+                 huart->RxEventType = HAL_UART_RXEVENT_TC;
+                 HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+             }
+         }
+     }
+     if (uartIdlePending) {
+         uartIdlePending = 0;
+         if (huart->RxState == HAL_UART_STATE_BUSY_RX && huart->RxXferCount != huart->RxXferSize) {
+             huart->RxState = HAL_UART_STATE_READY;
+             huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+             HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - huart->RxXferCount));
+         }
+     }
+     if (uartTxPending) {
+         uartTxPending = 0;
+         huart->gState = HAL_UART_STATE_READY;
+         HAL_UART_TxCpltCallback(huart);
+     }
+ }
+
+ __attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+     (void)huart;
+ }
+
+ __attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+     (void)huart;
+ }
+
+ __attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+     (void)huart;
+     (void)Size;
+ }
+
+ __attribute__((weak)) void HAL_UARTEx_WakeupCallback(UART_HandleTypeDef *huart) {
+     (void)huart;
+ }
+
+ // TIM
+ HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim) {
+     MockTimer *timer;
+
+     if (htim == NULL || htim->Instance == NULL) {
+         return HAL_ERROR;
+     }
+     timer = Mock_FindTimer(htim->Instance);
+     Mock_TimerSync(timer, Mock_Cycles(nowNs));
+     htim->Instance->PSC = htim->Init.Prescaler;
+     htim->Instance->ARR = htim->Init.Period;
+     htim->Instance->CNT = 0;
+     htim->Instance->SR = 0;
+     timer->prescaler = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+     htim->Instance->DIER |= TIM_IT_UPDATE;
+     htim->Instance->CR1 |= TIM_CR1_CEN;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+     htim->Instance->DIER &= ~TIM_IT_UPDATE;
+     htim->Instance->CR1 &= ~TIM_CR1_CEN;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim) {
+     return HAL_TIM_Base_Init(htim);
+ }
+
+ HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel) {
+     __IO uint32_t *ccr[4] = {&htim->Instance->CCR1, &htim->Instance->CCR2,
+                              &htim->Instance->CCR3, &htim->Instance->CCR4};
+
+     *ccr[Channel / 4U] = sConfig->Pulse;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel) {
+     (void)Channel;
+     htim->Instance->CR1 |= TIM_CR1_CEN;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim) {
+     return HAL_TIM_Base_Init(htim);
+ }
+
+ HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel) {
+     (void)htim;
+     (void)sConfig;
+     (void)Channel;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel) {
+     htim->Instance->DIER |= TIM_IT_CC1 << (Channel / 4U);
+     htim->Instance->CR1 |= TIM_CR1_CEN;
+     return HAL_OK;
+ }
+
+ uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel) {
+     __IO uint32_t *ccr[4] = {&htim->Instance->CCR1, &htim->Instance->CCR2,
+                              &htim->Instance->CCR3, &htim->Instance->CCR4};
+
+     return *ccr[Channel / 4U];
+ }
+
+ // Same order as the HAL: capture channels 1..4, then update
+ void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim) {
+     TIM_TypeDef *regs = htim->Instance;
+
+     for (uint32_t index = 0; index < 4U; index++) {
+         uint32_t flag = TIM_SR_CC1IF << index;
+
+         if ((regs->SR & flag) && (regs->DIER & (TIM_IT_CC1 << index))) {
+             regs->SR &= ~flag;
+             htim->Channel = (HAL_TIM_ActiveChannel)(HAL_TIM_ACTIVE_CHANNEL_1 << index);
+             HAL_TIM_IC_CaptureCallback(htim);
+             htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+         }
+     }
+     if ((regs->SR & TIM_SR_UIF) && (regs->DIER & TIM_IT_UPDATE)) {
+         regs->SR &= ~TIM_SR_UIF;
+         HAL_TIM_PeriodElapsedCallback(htim);
+     }
+ }
+
+ __attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+     (void)htim;
+ }
+
+ __attribute__((weak)) void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) {
+     (void)htim;
+ }
+
+ // RTC: the calendar starts at midnight on 1 January at reset
+ HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc) {
+     return (hrtc->Instance == NULL) ? HAL_ERROR : HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format) {
+     uint64_t seconds = Mock_RtcSeconds();
+
+     (void)hrtc;
+     (void)Format;
+     sTime->Hours = (uint8_t)((seconds / 3600U) % 24U);
+     sTime->Minutes = (uint8_t)((seconds / 60U) % 60U);
+     sTime->Seconds = (uint8_t)(seconds % 60U);
+     sTime->SubSeconds = 0;
+     return HAL_OK;
+ }
+
+ HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format) {
+     (void)hrtc;
+     (void)Format;
+     sDate->WeekDay = 1;
+     sDate->Month = 1;
+     sDate->Date = (uint8_t)(1U + Mock_RtcSeconds() / 86400U);
+     sDate->Year = 0;
+     return HAL_OK;
+ }
+
+ // Every alarm the firmware sets is "every second" (all fields masked)
+ HAL_StatusTypeDef HAL_RTC_SetAlarm_IT(RTC_HandleTypeDef *hrtc, RTC_AlarmTypeDef *sAlarm, uint32_t Format) {
+     (void)hrtc;
+     (void)Format;
+     if (sAlarm->AlarmMask != RTC_ALARMMASK_ALL) {
+         return HAL_ERROR;
+     }
+     rtcAlarmEnabled = 1;
+     rtcAlarmAt = (nowNs / MOCK_NS_PER_S + 1U) * MOCK_NS_PER_S;
+     return HAL_OK;
+ }
+
+ void HAL_RTC_AlarmIRQHandler(RTC_HandleTypeDef *hrtc) {
+     if (rtcAlarmFlag) {
+         rtcAlarmFlag = 0;
+         HAL_RTC_AlarmAEventCallback(hrtc);
+     }
+ }
+
+ __attribute__((weak)) void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc) {
+     (void)hrtc;
+ }
@@ -0,0 +1,74 @@
+/**
+ * @file mock_hal.h
+ * @brief Simulator side of the mock HAL: simulated time, inputs and hooks.
+ *
+ * This header declares what the simulator (sim.c) uses to drive the mock HAL,
+ * and the hooks the mock calls back into the simulator. The firmware never
+ * includes it; it only sees stm32c0xx_hal.h.
+ *
+ * Function Prototypes:
+ * - `Mock_NowNs()`: Simulated time since reset, in nanoseconds.
+ * - `Mock_StopNs()`: Part of it spent in Stop mode.
+ * - `Mock_CoreCycles()`: Core clock cycles since reset, sleeping included, Stop
+ *   mode excluded; over `Mock_NowNs()` it is the average SYSCLK.
+ * - `Mock_SetInput()`: Drive a GPIO input level; a falling (rising) edge on a
+ *   pin configured for EXTI raises its interrupt line.
+ * - `Mock_Capture()`: Latch a timer's counter into an input capture channel
+ *   now, as a tach edge on its pin would.
+ * - `Mock_FlashWrites()`, `Mock_FlashErases()`: Double words programmed and
+ *   pages erased since reset.
+ * - `Mock_FailRcc()`: Refuse the next `calls` RCC oscillator / clock configuration
+ *   calls with `HAL_TIMEOUT`.
+ * - `Mock_UartReceive()`: Put a frame on the USART1 receive line, starting now,
+ *   back to back at the firmware's character time. One frame at a time.
+ * - `Mock_SetRtcTime()`: Set the RTC calendar's time of day now, as a write
+ *   through `hrtc` would; the seconds keep their phase.
+ * - `Mock_LoadFlash()`: Power on with this flash image, as an earlier run left
+ *   it, instead of an erased part. Call before the firmware boots.
+ * - `Mock_TearLastFlashWrite()`: Erase the upper word of the last double word
+ *   programmed, as a power cut during that programming would leave it.
+ *
+ * Hooks (implemented by the simulator):
+ * - `Sim_Poll()`: Called after every step of simulated time, before interrupts
+ *   are raised; returns the next time (ns) it wants to run, or `MOCK_NEVER`.
+ * - `Sim_Sleep()` / `Sim_Wake()`: The firmware enters / leaves `__WFI()` or Stop mode.
+ * - `Sim_AdcSample()`: 12-bit reading of one ADC channel at the current time.
+ * - `Sim_SpiTransmit()`: Bytes clocked out of SPI1 (blocking or DMA).
+ * - `Sim_UartTransmit()`: Bytes USART1 starts sending now.
+ * - `Sim_Usart2Transmit()`: Bytes USART2 starts sending now (the profiler dump).
+ * - `Sim_Fault()`: The firmware did something the target would hang on or
+ *   trap; does not return.
+ */
+
+
+
+ #ifndef MOCK_HAL_H
+ #define MOCK_HAL_H
+
+ #include "stm32c0xx_hal.h"
+
+ #define MOCK_NEVER  UINT64_MAX
+
+ uint64_t Mock_NowNs(void);
+ uint64_t Mock_StopNs(void);
+ uint64_t Mock_CoreCycles(void);
+ void Mock_SetInput(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState level);
+ void Mock_Capture(TIM_TypeDef *tim, uint32_t channel);
+ uint32_t Mock_FlashWrites(void);
+ uint32_t Mock_FlashErases(void);
+ void Mock_FailRcc(uint32_t calls);
+ void Mock_UartReceive(const uint8_t *data, uint16_t size);
+ void Mock_SetRtcTime(uint8_t hours, uint8_t minutes, uint8_t seconds);
+ void Mock_LoadFlash(const uint8_t *image);
+ void Mock_TearLastFlashWrite(void);
+
+ uint64_t Sim_Poll(uint64_t nowNs);
+ void Sim_Sleep(void);
+ void Sim_Wake(void);
+ uint16_t Sim_AdcSample(uint32_t channel);
+ void Sim_SpiTransmit(const uint8_t *data, uint16_t size);
+ void Sim_UartTransmit(const uint8_t *data, uint16_t size);
+ void Sim_Usart2Transmit(const uint8_t *data, uint16_t size);
+ void Sim_Fault(const char *reason);
+
+ #endif // MOCK_HAL_H
@@ -0,0 +1,217 @@
+/**
+ * @file plant.c
+ * @brief Washer plant model driven by the mock HAL registers.
+ *
+ * This source file implements the plant declared in plant.h.
+ *
+ * Details:
+ * - Water: each open valve adds `PLANT_INFLOW_PCT_S` of capacity per second at
+ *   its supply temperature, mixed into the drum by volume. The water cools
+ *   slowly toward the room, and drains while the drum spins faster than
+ *   `PLANT_DRAIN_RPM` (the machine has no drain output; the spin pump is
+ *   assumed to follow the drum).
+ * - Drum: the motor duty (TIM3 CCR3 forward, CCR4 reverse, over ARR + 1) sets a
+ *   no-load speed of duty x `MOTOR_MAX_RPM`; the drum follows with a first-order
+ *   lag. The unbalance modulates the speed once per revolution.
+ * - Reversal: the drive changing sign without passing through (nearly) zero
+ *   duty is a fault; on the machine it shorts the inverter. A ramp steps a few
+ *   counts per PWM period, so up to `PLANT_REVERSAL_COUNTS` across the change
+ *   counts as through zero.
+ * - Tach: the drum angle is integrated in tach pulses; every whole pulse crossed
+ *   latches TIM1 CH4 through `Mock_Capture()`. The next edge is predicted from
+ *   the current rate, so the simulator steps right onto it.
+ * - ADC: temperature 0-100 °C over the full scale (the firmware's default
+ *   calibration), level linear between `WATER_LEVEL_EMPTY_RAW` and
+ *   `WATER_LEVEL_FULL_RAW`, current proportional to duty plus the unbalance
+ *   ripple. A fixed-seed LCG adds a few counts of noise, so every run is
+ *   identical.
+ *
+ * Dependencies:
+ * - plant.h (for the state and prototypes)
+ * - mock_hal.h (for the registers and `Mock_Capture()`)
+ * - main.h, adc.h, motor.h, speed.h, balance.h (for pins, ADC scaling and limits)
+ */
+
+
+
+ #include "plant.h"
+ #include "mock_hal.h"
+ #include "main.h"
+ #include "adc.h"
+ #include "motor.h"
+ #include "speed.h"
+ #include "balance.h"
+ #include <math.h>
+
+ #define PLANT_INFLOW_PCT_S     1.5
+ #define PLANT_HOT_SUPPLY_C     65.0
+ #define PLANT_COLD_SUPPLY_C    15.0
+ #define PLANT_ROOM_C           20.0
+ #define PLANT_COOLING_S        3600.0
+ #define PLANT_DRAIN_RPM        300.0
+ #define PLANT_DRAIN_PCT_S      2.5
+ #define PLANT_DRUM_LAG_S       0.5
+ #define PLANT_TUMBLE_RPM       60.0
+ #define PLANT_SETTLE_FACTOR    0.3
+ #define PLANT_MIN_TACH_RPM     2.0
+ #define PLANT_IDLE_CURRENT     200.0
+ #define PLANT_CURRENT_PER_DUTY 6.0
+ #define PLANT_RIPPLE_CURRENT   300.0
+ #define PLANT_NOISE_COUNTS     4U
+ #define PLANT_REVERSAL_COUNTS  8.0
+ #define PLANT_TWO_PI           6.283185307179586
+
+ static PlantState plant;
+ static double pulse;              // Drum angle in tach pulses since reset
+ static double nextPulse;          // Next whole pulse to latch
+ static double duty;               // 0..1 of the active channel
+ static double lastDrive;          // Signed duty at the previous step
+ static uint8_t spunUp;            // Above BALANCE_MIN_RPM since the last tumble
+ static uint64_t lastNs;
+ static uint32_t noiseState;
+
+ // Deterministic noise in [-PLANT_NOISE_COUNTS, PLANT_NOISE_COUNTS]
+ static int32_t Plant_Noise(void) {
+     noiseState = noiseState * 1664525U + 1013904223U;
+     return (int32_t)((noiseState >> 16) % (2U * PLANT_NOISE_COUNTS + 1U)) - (int32_t)PLANT_NOISE_COUNTS;
+ }
+
+ static uint16_t Plant_Clamp(double raw) {
+     if (raw < 0.0) {
+         return 0;
+     }
+     if (raw > 4095.0) {
+         return 4095;
+     }
+     return (uint16_t)raw;
+ }
+
+ // Signed duty from the PWM compare registers
+ static double Plant_Drive(void) {
+     double period = (double)TIM3->ARR + 1.0;
+
+     if (!(TIM3->CR1 & TIM_CR1_CEN)) {
+         return 0.0;
+     }
+     return ((double)TIM3->CCR3 - (double)TIM3->CCR4) / period;
+ }
+
+ static void Plant_Water(double dt) {
+     double inflow = 0.0;
+     double inflowC = 0.0;
+
+     if (WATER_GPIO_PORT->ODR & WATER_HOT_PIN) {
+         inflow += PLANT_INFLOW_PCT_S * dt;
+         inflowC += PLANT_HOT_SUPPLY_C * PLANT_INFLOW_PCT_S * dt;
+     }
+     if (WATER_GPIO_PORT->ODR & WATER_COLD_PIN) {
+         inflow += PLANT_INFLOW_PCT_S * dt;
+         inflowC += PLANT_COLD_SUPPLY_C * PLANT_INFLOW_PCT_S * dt;
+     }
+     if (inflow > 0.0) {
+         plant.waterC = (plant.waterC * plant.waterPct + inflowC) / (plant.waterPct + inflow);
+         plant.waterPct += inflow;
+         if (plant.waterPct > 100.0) {
+             plant.waterPct = 100.0;
+         }
+     }
+     plant.waterC += (PLANT_ROOM_C - plant.waterC) * (1.0 - exp(-dt / PLANT_COOLING_S));
+     if (fabs(plant.rpm) > PLANT_DRAIN_RPM) {
+         plant.waterPct -= PLANT_DRAIN_PCT_S * dt;
+         if (plant.waterPct < 0.0) {
+             plant.waterPct = 0.0;
+         }
+     }
+ }
+
+ static void Plant_Drum(double dt) {
+     double drive = Plant_Drive();
+     double target = drive * (double)MOTOR_MAX_RPM;
+     double speed;
+
+     if (drive * lastDrive < 0.0 &&
+         (fabs(drive) + fabs(lastDrive)) * (double)MOTOR_DUTY_MAX > PLANT_REVERSAL_COUNTS) {
+         Sim_Fault("motor direction changed at non-zero duty");
+     }
+     lastDrive = drive;
+
+     duty = fabs(drive);
+     plant.rpm += (target - plant.rpm) * (1.0 - exp(-dt / PLANT_DRUM_LAG_S));
+
+     // The load settles a little every time the drum drops back to a tumble
+     speed = fabs(plant.rpm);
+     if (speed >= (double)BALANCE_MIN_RPM) {
+         spunUp = 1;
+     } else if (spunUp && speed < PLANT_TUMBLE_RPM) {
+         spunUp = 0;
+         plant.unbalance *= PLANT_SETTLE_FACTOR;
+     }
+
+     // Once-per-revolution speed ripple from the unbalance
+     speed *= 1.0 + plant.unbalance * sin(PLANT_TWO_PI * pulse / (double)TACH_PULSES_PER_REV);
+     pulse += speed / 60.0 * (double)TACH_PULSES_PER_REV * dt;
+ }
+
+ void Plant_Reset(double unbalance) {
+     plant.waterPct = 0.0;
+     plant.waterC = PLANT_ROOM_C;
+     plant.rpm = 0.0;
+     plant.unbalance = unbalance;
+     pulse = 0.0;
+     nextPulse = 1.0;
+     duty = 0.0;
+     lastDrive = 0.0;
+     spunUp = 0;
+     lastNs = Mock_NowNs();
+     noiseState = 12345U;
+ }
+
+ uint64_t Plant_Advance(uint64_t nowNs) {
+     double dt = (double)(nowNs - lastNs) * 1e-9;
+     double rate;
+     uint64_t next = nowNs + PLANT_STEP_NS;
+
+     lastNs = nowNs;
+     if (dt > 0.0) {
+         Plant_Water(dt);
+         Plant_Drum(dt);
+     }
+
+     // Latch the edge just crossed (the capture register only holds the latest)
+     if (pulse + 1e-9 >= nextPulse) {
+         Mock_Capture(TIM1, TIM_CHANNEL_4);
+         nextPulse = floor(pulse + 1e-9) + 1.0;
+     }
+
+     rate = fabs(plant.rpm) / 60.0 * (double)TACH_PULSES_PER_REV;
+     if (fabs(plant.rpm) >= PLANT_MIN_TACH_RPM) {
+         uint64_t edge = nowNs + (uint64_t)((nextPulse - pulse) / rate * 1e9) + 1U;
+
+         if (edge < next) {
+             next = edge;
+         }
+     }
+     return next;
+ }
+
+ uint16_t Plant_AdcSample(uint32_t channel) {
+     switch (channel) {
+         case TEMP_SENSOR_ADC_CHANNEL:
+             return Plant_Clamp(plant.waterC * 40.96 + Plant_Noise());
+         case WATER_LEVEL_ADC_CHANNEL:
+             return Plant_Clamp(WATER_LEVEL_EMPTY_RAW +
+                                plant.waterPct * (WATER_LEVEL_FULL_RAW - WATER_LEVEL_EMPTY_RAW) / 100.0 +
+                                Plant_Noise());
+         case MOTOR_CURRENT_ADC_CHANNEL:
+             return Plant_Clamp(PLANT_IDLE_CURRENT + PLANT_CURRENT_PER_DUTY * duty * (double)MOTOR_DUTY_MAX +
+                                PLANT_RIPPLE_CURRENT * plant.unbalance * duty *
+                                sin(PLANT_TWO_PI * pulse / (double)TACH_PULSES_PER_REV) +
+                                Plant_Noise());
+         default:
+             return Plant_Clamp(2048.0 + Plant_Noise());
+     }
+ }
+
+ const PlantState *Plant_GetState(void) {
+     return &plant;
+ }
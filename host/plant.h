@@ -0,0 +1,51 @@
+/**
+ * @file plant.h
+ * @brief Scripted washer plant for the host simulator: water, heat, drum, tach.
+ *
+ * This header declares the physical model the simulated firmware controls. It
+ * reads the firmware's outputs straight from the mock registers (valve pins on
+ * GPIOB, the TIM3 compare registers) and produces the inputs: ADC samples for
+ * temperature, water level and motor current, and tach edges on TIM1 channel 4.
+ *
+ * Definitions:
+ * - `PlantState` struct: Current water level and temperature, signed drum speed
+ *   and remaining unbalance, for the simulator's report.
+ * - `PLANT_STEP_NS`: Longest integration step.
+ *
+ * Function Prototypes:
+ * - `Plant_Reset()`: Empty, cold drum at rest, with the given unbalance (share of
+ *   the drum speed as a once-per-revolution ripple, 0 for a balanced load).
+ * - `Plant_Advance()`: Integrate up to `nowNs` and latch a tach capture for each
+ *   edge on the way; returns the next time the plant wants to run.
+ * - `Plant_AdcSample()`: 12-bit reading of one ADC channel, with a little noise.
+ * - `Plant_GetState()`: Read-only view of the state.
+ *
+ * Notes:
+ * - All values are doubles; nothing here is meant to run on the target.
+ * - The load settles while the drum tumbles: every time the drum slows from
+ *   above `BALANCE_MIN_RPM` to a tumble, the unbalance drops to 30 %, so a
+ *   redistribution in the firmware really helps the next spin attempt.
+ */
+
+
+
+ #ifndef PLANT_H
+ #define PLANT_H
+
+ #include <stdint.h>
+
+ #define PLANT_STEP_NS  2000000ULL
+
+ typedef struct {
+     double waterPct;    // Level, percent of capacity
+     double waterC;      // Water temperature
+     double rpm;         // Drum speed, negative in reverse
+     double unbalance;   // Speed ripple share at the revolution frequency
+ } PlantState;
+
+ void Plant_Reset(double unbalance);
+ uint64_t Plant_Advance(uint64_t nowNs);
+ uint16_t Plant_AdcSample(uint32_t channel);
+ const PlantState *Plant_GetState(void);
+
+ #endif // PLANT_H
@@ -0,0 +1,971 @@
+/**
+ * @file sim.c
+ * @brief Host simulator: runs the firmware against the plant and benchmarks it.
+ *
+ * This source file boots the unmodified firmware (`main()` renamed to
+ * `Firmware_Main()` by the Makefile) on the mock HAL, drives it through every
+ * wash program with scripted button presses, and reports what a performance
+ * change to the state machine or the rendering code would move.
+ *
+ * Details:
+ * - The firmware runs on its own stack (a ucontext), painted before boot, so the
+ *   deepest use is read back at the end. It never returns; once the script is
+ *   done the simulator switches back and abandons it.
+ * - Script, per program: Stop, Up/Down presses until the program is selected,
+ *   Start, then wait for DONE. WASHER_ERROR or `SIM_PROGRAM_LIMIT_S` without
+ *   DONE fails the program. Presses are `SIM_PRESS_MS` long with
+ *   `SIM_GAP_MS` between them. Every fifth program runs with an unbalanced load.
+ * - Wakeup cost: host time from leaving `__WFI()` to entering it again, i.e. one
+ *   pass of the main loop plus the interrupts that woke it, split by washer state.
+ *   It is host time, so compare runs on the same machine only.
+ * - Display traffic: SPI bytes are decoded against the D/C and CS pins like the
+ *   panel would. A refresh is everything sent between two sleeps with the SPI
+ *   DMA idle, so a queued flush counts once even though it spans several wakeups.
+ * - Power: time in Stop mode and the average core clock over the whole run,
+ *   boot and script gaps included.
+ * - Clock faults: the first time a running program drops to the slow level, the
+ *   next RCC configuration call is refused (`Mock_FailRcc()`). The program must
+ *   still finish and the firmware must count exactly that one refused switch.
+ * - Journal: flash records written and pages erased by the cycle journal.
+ * - Power cut (`-c`, `-C`): a child process runs the first program and cuts
+ *   the power that many seconds after Start, which must land inside a step. It
+ *   hands its flash to the parent, with the newest journal record of the running
+ *   cycle (decoded by the layout in journal.c). With `-C` the cut lands during
+ *   that record's programming instead (`Mock_TearLastFlashWrite()`), so the
+ *   expected record is the one before it. The parent, whose firmware RAM was
+ *   never touched, boots on that flash with no button pressed. Once the resumed
+ *   step has finished its fill, the program, step and remaining time must match
+ *   the record; then the script carries on as usual.
+ * - Boot: simulated time from reset until the last boot stage finished.
+ * - Clock: `SIM_CLOCK_SET_MS` into the boot idle the RTC is set to
+ *   `SIM_CLOCK_SET`, a minute before midnight, as a write through `hrtc` would.
+ *   From the next second on, the time the firmware shows (`RTC_GetClock()`) must
+ *   match the calendar at every sleep.
+ * - Profiler: after the last program Stop is held for `SIM_LONG_PRESS_MS`, which
+ *   requests a dump of the profiler table over USART2. The dump must finish
+ *   within `SIM_DUMP_LIMIT_MS`. It must open with the header, end every line
+ *   with CRLF, and list each boot probe (boot-safe, boot-ready) exactly once.
+ * - Modbus: the simulator is the bus master. Every `SIM_BUS_PERIOD_MS` it reads
+ *   all input registers of this unit, `SIM_BUS_OTHER_MS` after a request to
+ *   another address. Each reply is checked against `Washer_GetStatus()` at the
+ *   moment it starts; turnaround runs from the request's last stop bit to then.
+ *   A poll left unanswered by the next frame, a wrong reply or a reply to the
+ *   other unit's request fails the run.
+ *   The script starts after `SIM_BOOT_MS` of idle, so the first polls have to
+ *   wake the core from Stop mode.
+ * - Heap: malloc/calloc/realloc/free are wrapped at link time and counted while
+ *   the firmware runs. The firmware allocates nothing; any count fails the run.
+ * - Exit status: 0 when every program reached DONE and every budget held, 1 on a
+ *   failed program or budget, 2 on a fault (`Sim_Fault()`, `Error_Handler()`).
+ *
+ * Usage:
+ *   sim [-p first[-last]] [-v] [-r max_refresh_bytes] [-s max_stack_bytes] [-t max_wake_ns]
+ *       [-m max_turnaround_us] [-c cut_seconds | -C torn_cut_seconds]
+ *   Programs are numbered 1-30 as on the display; a budget of 0 is not checked.
+ *   `-v` also prints the profiler dump and the final panel image as decoded from the SPI traffic.
+ *
+ * Dependencies:
+ * - mock_hal.h, plant.h (simulated time, inputs and the plant)
+ * - main.h, washer.h, program.h, spi.h (firmware pins, state and status snapshot)
+ * - power.h (Stop mode entries)
+ * - boot.h (boot completion)
+ * - rtc.h (the firmware's time of day)
+ * - journal.h (journal pages and entry)
+ * - profile.h (dump in progress)
+ * - modbus.h (slave address, bus speed and register map)
+ */
+
+
+
+ #define _GNU_SOURCE
+
+ #include "mock_hal.h"
+ #include "plant.h"
+ #include "main.h"
+ #include "washer.h"
+ #include "program.h"
+ #include "spi.h"
+ #include "power.h"
+ #include "boot.h"
+ #include "rtc.h"
+ #include "journal.h"
+ #include "modbus.h"
+ #include "profile.h"
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ucontext.h>
+ #include <unistd.h>
+ #include <sys/wait.h>
+
+ #define SIM_STACK_SIZE        (256U * 1024U)
+ #define SIM_STACK_PAINT       0xA5U
+ #define SIM_MS                1000000ULL
+ #define SIM_BOOT_MS           3000U   // Idle first: the early polls find the core in Stop mode
+ #define SIM_PRESS_MS          60U
+ #define SIM_LONG_PRESS_MS     (BUTTON_LONG_MS + 200U)
+ #define SIM_GAP_MS            100U
+ #define SIM_START_CHECK_MS    1000U
+ #define SIM_PROGRAM_LIMIT_S   (6U * 3600U)
+ #define SIM_UNBALANCE_EVERY   5U
+ #define SIM_UNBALANCE         0.06
+ #define SIM_PANEL_PAGES       8U
+ #define SIM_STATE_COUNT       (WASHER_ERROR + 1)
+ #define SIM_BUS_START_MS      200U
+ #define SIM_BUS_PERIOD_MS     1000U
+ #define SIM_BUS_OTHER_MS      20U
+ #define SIM_BUS_CHAR_NS       ((11ULL * 1000000000ULL) / MODBUS_BAUD)  // 8E1
+ #define SIM_BUS_REQUEST       8U
+ #define SIM_DUMP_LIMIT_MS     10000U
+ #define SIM_DUMP_SIZE         4096U
+ #define SIM_CLOCK_SET_MS      1500U
+ #define SIM_CLOCK_SET         23U, 59U, 0U
+ #define SIM_JOURNAL_TAG       0x5AU   // Record format tag (journal.c)
+ #define SIM_JOURNAL_NO_CYCLE  0xFFU   // Program index of an end record
+
+ typedef enum {
+     SCRIPT_SELECT = 0,   // Pressing buttons toward the program
+     SCRIPT_RUN,          // Waiting for DONE
+     SCRIPT_DUMP,         // Long press of Stop, waiting for the profiler dump
+     SCRIPT_FINISHED
+ } ScriptPhase;
+
+ typedef struct {
+     uint64_t count;
+     uint64_t totalNs;
+     uint64_t maxNs;
+ } SimCost;
+
+ // What the child leaves behind when the power goes
+ typedef struct {
+     uint8_t flash[sizeof(MockFlash)];
+     uint8_t found;        // The journal shows a running cycle
+     JournalEntry entry;   // Its newest record, the one to resume from
+ } SimPowerCut;
+
+ typedef struct {
+     uint8_t passed;
+     const char *reason;
+     uint64_t simNs;
+     uint64_t wakes;
+     SimCost cost;
+     uint32_t refreshes;
+     uint64_t refreshBytes;
+     uint32_t maxRefresh;
+ } SimResult;
+
+ int Firmware_Main(void);
+ void *__real_malloc(size_t size);
+ void *__real_calloc(size_t count, size_t size);
+ void *__real_realloc(void *pointer, size_t size);
+ void __real_free(void *pointer);
+
+ static ucontext_t simContext;
+ static ucontext_t firmwareContext;
+ static uint8_t firmwareStack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+
+ // Options
+ static uint8_t firstProgram = 0;
+ static uint8_t lastProgram = PROGRAM_COUNT - 1;
+ static uint8_t verbose = 0;
+ static uint32_t maxRefreshBudget = 0;
+ static uint32_t maxStackBudget = 0;
+ static uint32_t maxWakeBudget = 0;
+ static uint32_t maxTurnaroundBudget = 0;
+ static uint32_t cutSeconds = 0;        // Power cut after Start, 0 for none
+ static uint8_t cutTorn = 0;
+
+ // Script
+ static ScriptPhase phase = SCRIPT_SELECT;
+ static uint8_t program = 0;
+ static uint64_t nextActionNs = SIM_BOOT_MS * SIM_MS;
+ static uint16_t heldPin = 0;
+ static uint64_t programStartNs = 0;
+ static uint64_t startCheckNs = 0;
+ static SimResult results[PROGRAM_COUNT];
+
+ // Measurements
+ static uint8_t firmwareRunning = 0;
+ static uint8_t measuring = 0;
+ static uint8_t wakeState = IDLE;
+ static struct timespec wakeAt;
+ static SimCost stateCost[SIM_STATE_COUNT];
+ static uint64_t heapCalls = 0;
+ static uint32_t refreshBytes = 0;
+ static uint64_t commandBytes = 0;
+ static uint64_t dataBytes = 0;
+ static uint64_t badBytes = 0;
+ static uint64_t bootReadyNs = 0;
+ static uint8_t rccFaultInjected = 0;
+ static uint64_t clockCheckNs = 0;      // First whole second after the clock was set, 0 before
+ static uint64_t clockChecks = 0;
+ static uint64_t clockStale = 0;
+
+ // Power cut
+ static int cutPipe = -1;               // Child: where its flash goes at the cut
+ static SimPowerCut powerCut;
+ static uint8_t resumePending = 0;      // Parent: resumed step not seen yet
+ static uint8_t resumeGood = 0;
+ static WasherStatus resumeStatus;
+ static uint8_t panel[SIM_PANEL_PAGES][DISPLAY_PANEL_COLUMNS];
+ static uint8_t panelPage = 0;
+ static uint8_t panelColumn = 0;
+
+ // Profiler dump
+ static char dumpText[SIM_DUMP_SIZE];
+ static uint32_t dumpBytes = 0;
+ static uint32_t dumpLost = 0;          // Bytes past SIM_DUMP_SIZE
+ static uint64_t dumpRequestNs = 0;
+ static uint64_t dumpStartNs = 0;       // First byte on the wire
+ static uint64_t dumpDoneNs = 0;
+
+ // Bus master
+ static uint64_t busNextNs = SIM_BUS_START_MS * SIM_MS;
+ static uint8_t busOwnNext = 0;         // Next request for this unit (1) or another (0)
+ static uint64_t busRequestEndNs = 0;   // Last stop bit of the unanswered poll, 0 if none
+ static uint64_t busPolls = 0;
+ static uint64_t busAnswered = 0;
+ static uint64_t busMissed = 0;
+ static uint64_t busBad = 0;
+ static uint64_t busStray = 0;
+ static SimCost busTurnaround;
+
+ static const char *const stateNames[SIM_STATE_COUNT] = {
+     "IDLE", "FILL", "WASH", "RINSE", "SPIN", "DONE", "ERROR",
+ };
+
+ static uint64_t Sim_HostNs(void) {
+     struct timespec now;
+
+     clock_gettime(CLOCK_MONOTONIC, &now);
+     return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+ }
+
+ static void Sim_AddCost(SimCost *cost, uint64_t ns) {
+     cost->count++;
+     cost->totalNs += ns;
+     if (ns > cost->maxNs) {
+         cost->maxNs = ns;
+     }
+ }
+
+ static uint64_t Sim_Mean(const SimCost *cost) {
+     return (cost->count == 0) ? 0 : cost->totalNs / cost->count;
+ }
+
+ static void Sim_Hold(uint16_t pin, uint32_t ms, uint64_t nowNs) {
+     Mock_SetInput(BUTTON_GPIO_PORT, pin, GPIO_PIN_RESET);
+     heldPin = pin;
+     nextActionNs = nowNs + ms * SIM_MS;
+ }
+
+ static void Sim_Press(uint16_t pin, uint64_t nowNs) {
+     Sim_Hold(pin, SIM_PRESS_MS, nowNs);
+ }
+
+ static void Sim_Finish(uint8_t passed, const char *reason, uint64_t nowNs) {
+     SimResult *result = &results[program];
+
+     if (cutPipe >= 0) {
+         fprintf(stderr, "power cut: program %02u ended before the cut\n", program + 1U);
+         _exit(1);
+     }
+     result->passed = passed;
+     result->reason = reason;
+     result->simNs = nowNs - programStartNs;
+     measuring = 0;
+     if (program == lastProgram) {
+         phase = SCRIPT_DUMP;
+     } else {
+         program++;
+         phase = SCRIPT_SELECT;
+     }
+     nextActionNs = nowNs + SIM_GAP_MS * SIM_MS;
+ }
+
+ // CRC-8 of a journal record's seven payload bytes (journal.c)
+ static uint8_t Sim_JournalCrc(uint64_t record) {
+     uint8_t crc = 0;
+
+     for (uint8_t i = 0; i < 7U; i++) {
+         crc ^= (uint8_t)(record >> (8U * i));
+         for (uint8_t bit = 0; bit < 8U; bit++) {
+             crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+         }
+     }
+     return crc;
+ }
+
+ // Newest valid journal record, by sequence; returns 1 if it belongs to a running cycle
+ static uint8_t Sim_JournalNewest(const uint8_t *flash, JournalEntry *entry) {
+     const uint8_t *pages = &flash[JOURNAL_FIRST_PAGE * FLASH_PAGE_SIZE];
+     uint64_t newest = 0;
+     uint8_t found = 0;
+
+     for (uint32_t offset = 0; offset < JOURNAL_PAGES * FLASH_PAGE_SIZE; offset += sizeof(newest)) {
+         uint64_t record;
+
+         memcpy(&record, &pages[offset], sizeof(record));
+         if ((uint8_t)(record >> 48) == SIM_JOURNAL_TAG && (uint8_t)(record >> 56) == Sim_JournalCrc(record) &&
+             (!found || (uint16_t)record > (uint16_t)newest)) {
+             newest = record;
+             found = 1;
+         }
+     }
+     if (!found || (uint8_t)(newest >> 16) == SIM_JOURNAL_NO_CYCLE) {
+         return 0;
+     }
+     entry->programIndex = (uint8_t)(newest >> 16);
+     entry->stepIndex = (uint8_t)(newest >> 24);
+     entry->elapsedSeconds = (uint16_t)(newest >> 32);
+     return 1;
+ }
+
+ // Child: the power goes now; hand the flash and the record to resume from to the parent
+ static void Sim_PowerCut(const WasherStatus *status) {
+     const uint8_t *data = (const uint8_t *)&powerCut;
+     size_t left = sizeof(powerCut);
+
+     if (status->state != WASH && status->state != RINSE && status->state != SPIN) {
+         fprintf(stderr, "power cut: program %02u is not inside a step at the cut\n", program + 1U);
+         _exit(1);
+     }
+     if (cutTorn) {
+         Mock_TearLastFlashWrite();
+     }
+     memcpy(powerCut.flash, MockFlash, sizeof(powerCut.flash));
+     powerCut.found = Sim_JournalNewest(powerCut.flash, &powerCut.entry);
+     while (left > 0) {
+         ssize_t written = write(cutPipe, data, left);
+
+         if (written <= 0) {
+             _exit(1);
+         }
+         data += written;
+         left -= (size_t)written;
+     }
+     _exit(0);
+ }
+
+ // Parent: the first time the resumed step runs past its fill
+ static void Sim_CheckResume(const WasherStatus *status) {
+     const JournalEntry *entry = &powerCut.entry;
+     const ProgramStep *step = Program_GetStep(entry->programIndex, entry->stepIndex);
+
+     resumePending = 0;
+     resumeStatus = *status;
+     resumeGood = step != NULL && status->programIndex == entry->programIndex &&
+                  status->stepIndex == entry->stepIndex && status->state == step->state &&
+                  status->remainingSeconds == step->durationSeconds - entry->elapsedSeconds;
+ }
+
+ // One script step; `nextActionNs` is the next time it needs to run
+ static void Sim_Script(uint64_t nowNs) {
+     WasherStatus status;
+
+     if (phase == SCRIPT_FINISHED) {
+         // Leave the firmware where it is; main() picks up after its swapcontext
+         swapcontext(&firmwareContext, &simContext);
+         return;
+     }
+     if (heldPin != 0) {
+         if (nowNs >= nextActionNs) {
+             Mock_SetInput(BUTTON_GPIO_PORT, heldPin, GPIO_PIN_SET);
+             heldPin = 0;
+             nextActionNs = nowNs + SIM_GAP_MS * SIM_MS;
+         }
+         return;
+     }
+
+     Washer_GetStatus(&status);
+     if (phase == SCRIPT_RUN) {
+         if (cutPipe >= 0 && nowNs - programStartNs >= (uint64_t)cutSeconds * 1000U * SIM_MS) {
+             Sim_PowerCut(&status);
+         }
+         if (resumePending && status.state != IDLE && status.state != FILL_WATER) {
+             Sim_CheckResume(&status);
+         }
+         if (status.state != IDLE && Power_GetLevel() == POWER_SLOW && !rccFaultInjected) {
+             Mock_FailRcc(1);
+             rccFaultInjected = 1;
+         }
+         if (status.state == DONE) {
+             Sim_Finish(1, "", nowNs);
+         } else if (status.state == WASHER_ERROR) {
+             Sim_Finish(0, "error state", nowNs);
+         } else if (status.state == IDLE && nowNs >= startCheckNs) {
+             Sim_Finish(0, "did not start", nowNs);
+         } else if (nowNs - programStartNs >= (uint64_t)SIM_PROGRAM_LIMIT_S * 1000U * SIM_MS) {
+             Sim_Finish(0, "timeout", nowNs);
+         }
+         return;
+     }
+     if (nowNs < nextActionNs) {
+         return;
+     }
+     if (phase == SCRIPT_DUMP) {
+         if (dumpRequestNs == 0) {
+             Sim_Hold(BUTTON_STOP_PIN, SIM_LONG_PRESS_MS, nowNs);
+             dumpRequestNs = nowNs;
+         } else if (dumpBytes > 0 && !Profile_IsBusy()) {
+             dumpDoneNs = nowNs;
+             phase = SCRIPT_FINISHED;
+         } else if (nowNs - dumpRequestNs >= SIM_DUMP_LIMIT_MS * SIM_MS) {
+             phase = SCRIPT_FINISHED;
+         } else {
+             nextActionNs = nowNs + SIM_MS;
+         }
+         return;
+     }
+
+     // Select: back to IDLE, step to the program, start it
+     if (status.state != IDLE) {
+         Sim_Press(BUTTON_STOP_PIN, nowNs);
+     } else if (status.programIndex < program) {
+         Sim_Press(BUTTON_UP_PIN, nowNs);
+     } else if (status.programIndex > program) {
+         Sim_Press(BUTTON_DOWN_PIN, nowNs);
+     } else {
+         Plant_Reset((program % SIM_UNBALANCE_EVERY == SIM_UNBALANCE_EVERY - 1U) ? SIM_UNBALANCE : 0.0);
+         Sim_Press(BUTTON_START_PIN, nowNs);
+         memset(&results[program], 0, sizeof(results[program]));
+         phase = SCRIPT_RUN;
+         programStartNs = nowNs;
+         measuring = 1;
+         // The state must have left IDLE by then
+         startCheckNs = nowNs + SIM_START_CHECK_MS * SIM_MS;
+     }
+ }
+
+ // CRC-16/MODBUS, the reference bitwise form
+ static uint16_t Sim_Crc(const uint8_t *data, uint16_t size) {
+     uint16_t crc = 0xFFFFU;
+
+     for (uint16_t i = 0; i < size; i++) {
+         crc ^= data[i];
+         for (uint8_t bit = 0; bit < 8U; bit++) {
+             crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ 0xA001U) : (uint16_t)(crc >> 1);
+         }
+     }
+     return crc;
+ }
+
+ // Next bus frame: another unit's request, then a read of every register here
+ static void Sim_Bus(uint64_t nowNs) {
+     uint8_t request[SIM_BUS_REQUEST] = {0, 0x04U, 0, 0, 0, MODBUS_REG_COUNT};
+     uint16_t crc;
+
+     if (nowNs < busNextNs) {
+         return;
+     }
+     if (busRequestEndNs != 0) {
+         busMissed++;
+         busRequestEndNs = 0;
+     }
+     request[0] = busOwnNext ? MODBUS_ADDRESS : (uint8_t)(MODBUS_ADDRESS + 1U);
+     crc = Sim_Crc(request, SIM_BUS_REQUEST - 2U);
+     request[SIM_BUS_REQUEST - 2U] = (uint8_t)crc;
+     request[SIM_BUS_REQUEST - 1U] = (uint8_t)(crc >> 8);
+     Mock_UartReceive(request, SIM_BUS_REQUEST);
+     if (busOwnNext) {
+         busPolls++;
+         busRequestEndNs = nowNs + SIM_BUS_REQUEST * SIM_BUS_CHAR_NS;
+         busNextNs = nowNs + (SIM_BUS_PERIOD_MS - SIM_BUS_OTHER_MS) * SIM_MS;
+     } else {
+         busNextNs = nowNs + SIM_BUS_OTHER_MS * SIM_MS;
+     }
+     busOwnNext = !busOwnNext;
+ }
+
+ // Mock HAL hooks
+ uint64_t Sim_Poll(uint64_t nowNs) {
+     uint64_t next;
+
+     firmwareRunning = 0;
+     next = Plant_Advance(nowNs);
+     if (clockCheckNs == 0 && nowNs >= SIM_CLOCK_SET_MS * SIM_MS) {
+         Mock_SetRtcTime(SIM_CLOCK_SET);
+         clockCheckNs = (nowNs / (1000U * SIM_MS) + 1U) * 1000U * SIM_MS;
+     }
+     Sim_Bus(nowNs);
+     Sim_Script(nowNs);
+     if (clockCheckNs == 0 && SIM_CLOCK_SET_MS * SIM_MS < next) {
+         next = SIM_CLOCK_SET_MS * SIM_MS;
+     }
+     if (nextActionNs > nowNs && nextActionNs < next) {
+         next = nextActionNs;
+     }
+     if (busNextNs < next) {
+         next = busNextNs;
+     }
+     firmwareRunning = 1;
+     return next;
+ }
+
+ void Sim_Sleep(void) {
+     uint64_t ns = Sim_HostNs() - ((uint64_t)wakeAt.tv_sec * 1000000000ULL + (uint64_t)wakeAt.tv_nsec);
+
+     firmwareRunning = 0;
+     // First sleep after the last boot stage, within one main loop pass of it
+     if (bootReadyNs == 0 && Boot_IsDone()) {
+         bootReadyNs = Mock_NowNs();
+     }
+     // Every interrupt raised so far has run: the alarm has taken the current second
+     if (clockCheckNs != 0 && Mock_NowNs() >= clockCheckNs) {
+         RTC_TimeTypeDef time;
+         uint32_t clock = RTC_GetClock();
+
+         HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+         clockChecks++;
+         clockStale += RTC_CLOCK_HOURS(clock) != time.Hours || RTC_CLOCK_MINUTES(clock) != time.Minutes ||
+                       RTC_CLOCK_SECONDS(clock) != time.Seconds;
+     }
+     if (measuring) {
+         SimResult *result = &results[program];
+
+         Sim_AddCost(&stateCost[wakeState], ns);
+         Sim_AddCost(&result->cost, ns);
+         result->wakes++;
+         // A refresh ends once the queued regions have all gone out
+         if (refreshBytes > 0 && hdma_spi1_tx.State != HAL_DMA_STATE_BUSY) {
+             result->refreshes++;
+             result->refreshBytes += refreshBytes;
+             if (refreshBytes > result->maxRefresh) {
+                 result->maxRefresh = refreshBytes;
+             }
+         }
+     }
+     if (hdma_spi1_tx.State != HAL_DMA_STATE_BUSY) {
+         refreshBytes = 0;
+     }
+ }
+
+ void Sim_Wake(void) {
+     WasherStatus status;
+
+     Washer_GetStatus(&status);
+     wakeState = (status.state < SIM_STATE_COUNT) ? (uint8_t)status.state : WASHER_ERROR;
+     firmwareRunning = 1;
+     clock_gettime(CLOCK_MONOTONIC, &wakeAt);
+ }
+
+ uint16_t Sim_AdcSample(uint32_t channel) {
+     return Plant_AdcSample(channel);
+ }
+
+ // Panel model: D/C low selects page and column, D/C high writes columns
+ void Sim_SpiTransmit(const uint8_t *data, uint16_t size) {
+     uint8_t dataMode = (DISPLAY_DC_GPIO_Port->ODR & DISPLAY_DC_Pin) != 0;
+
+     refreshBytes += size;
+     if (DISPLAY_CS_GPIO_Port->ODR & DISPLAY_CS_Pin) {
+         badBytes += size;
+         return;
+     }
+     for (uint16_t i = 0; i < size; i++) {
+         uint8_t byte = data[i];
+
+         if (dataMode) {
+             dataBytes++;
+             if (panelColumn < DISPLAY_PANEL_COLUMNS) {
+                 panel[panelPage][panelColumn++] = byte;
+             } else {
+                 badBytes++;
+             }
+             continue;
+         }
+         commandBytes++;
+         if ((byte & 0xF8U) == DISPLAY_CMD_SET_PAGE) {
+             panelPage = byte & 0x07U;
+         } else if ((byte & 0xF0U) == DISPLAY_CMD_SET_COL_HIGH) {
+             panelColumn = (uint8_t)((panelColumn & 0x0FU) | ((byte & 0x0FU) << 4));
+         } else if ((byte & 0xF0U) == DISPLAY_CMD_SET_COL_LOW) {
+             panelColumn = (uint8_t)((panelColumn & 0xF0U) | (byte & 0x0FU));
+         }
+     }
+ }
+
+ // Reply from this unit: every register as the firmware publishes it right now
+ void Sim_UartTransmit(const uint8_t *data, uint16_t size) {
+     WasherStatus status;
+     uint16_t expected[MODBUS_REG_COUNT];
+     uint8_t good = (size == 5U + 2U * MODBUS_REG_COUNT);
+
+     if (busRequestEndNs == 0) {
+         busStray++;
+         return;
+     }
+     Sim_AddCost(&busTurnaround, Mock_NowNs() - busRequestEndNs);
+     busRequestEndNs = 0;
+
+     Washer_GetStatus(&status);
+     expected[MODBUS_REG_STATE] = (uint16_t)status.state;
+     expected[MODBUS_REG_PROGRAM] = (uint16_t)(status.programIndex + 1U);
+     expected[MODBUS_REG_STEP] = status.stepIndex;
+     expected[MODBUS_REG_REMAINING] = status.remainingSeconds;
+     expected[MODBUS_REG_TEMPERATURE] = (uint16_t)status.temperature;
+     expected[MODBUS_REG_RPM] = status.rpm;
+     expected[MODBUS_REG_LEVEL] = status.waterLevel;
+     expected[MODBUS_REG_FAULT] = status.fault;
+     expected[MODBUS_REG_REQUESTS] = (uint16_t)busPolls;
+     expected[MODBUS_REG_ERRORS] = 0;
+     if (good) {
+         uint16_t crc = Sim_Crc(data, (uint16_t)(size - 2U));
+
+         good = data[0] == MODBUS_ADDRESS && data[1] == 0x04U && data[2] == 2U * MODBUS_REG_COUNT &&
+                data[size - 2U] == (uint8_t)crc && data[size - 1U] == (uint8_t)(crc >> 8);
+     }
+     for (uint16_t i = 0; good && i < MODBUS_REG_COUNT; i++) {
+         good = ((uint16_t)(data[3U + 2U * i] << 8) | data[4U + 2U * i]) == expected[i];
+     }
+     if (good) {
+         busAnswered++;
+     } else {
+         busBad++;
+     }
+ }
+
+ // Profiler dump lines, kept for the check at the end
+ void Sim_Usart2Transmit(const uint8_t *data, uint16_t size) {
+     if (dumpStartNs == 0) {
+         dumpStartNs = Mock_NowNs();
+     }
+     for (uint16_t i = 0; i < size; i++) {
+         if (dumpBytes < SIM_DUMP_SIZE - 1U) {
+             dumpText[dumpBytes++] = (char)data[i];
+         } else {
+             dumpLost++;
+         }
+     }
+ }
+
+ // Dump lines and the two boot probes; returns 1 if the text is well formed
+ static uint8_t Sim_CheckDump(uint32_t *lines, uint32_t *bootSafeUs, uint32_t *bootReadyUs) {
+     uint32_t safeCount = 0;
+     uint32_t readyCount = 0;
+     uint8_t good = dumpLost == 0 && strncmp(dumpText, "probe ", 6) == 0;
+     char *line = dumpText;
+
+     *lines = 0;
+     while (*line != '\0') {
+         char *end = strstr(line, "\r\n");
+         unsigned long min;
+         unsigned long count;
+
+         if (end == NULL) {
+             good = 0;
+             break;
+         }
+         (*lines)++;
+         if (sscanf(line, "boot-safe %lu %*u %*u %lu", &min, &count) == 2) {
+             *bootSafeUs = (uint32_t)min;
+             safeCount += (uint32_t)count;
+         } else if (sscanf(line, "boot-ready %lu %*u %*u %lu", &min, &count) == 2) {
+             *bootReadyUs = (uint32_t)min;
+             readyCount += (uint32_t)count;
+         }
+         line = end + 2;
+     }
+     return good && safeCount == 1U && readyCount == 1U;
+ }
+
+ void Sim_Fault(const char *reason) {
+     fprintf(stderr, "FAULT at %.3f s (program %02u): %s\n",
+             (double)Mock_NowNs() / 1e9, program + 1U, reason);
+     exit(2);
+ }
+
+ // Firmware hooks: init failure trap, heap accounting
+ void Error_Handler(void) {
+     Sim_Fault("Error_Handler()");
+ }
+
+ void *__wrap_malloc(size_t size) {
+     heapCalls += firmwareRunning;
+     return __real_malloc(size);
+ }
+
+ void *__wrap_calloc(size_t count, size_t size) {
+     heapCalls += firmwareRunning;
+     return __real_calloc(count, size);
+ }
+
+ void *__wrap_realloc(void *pointer, size_t size) {
+     heapCalls += firmwareRunning;
+     return __real_realloc(pointer, size);
+ }
+
+ void __wrap_free(void *pointer) {
+     heapCalls += firmwareRunning && pointer != NULL;
+     __real_free(pointer);
+ }
+
+ static void Sim_FirmwareEntry(void) {
+     firmwareRunning = 1;
+     Firmware_Main();
+     Sim_Fault("main() returned");
+ }
+
+ static uint32_t Sim_StackUsed(void) {
+     uint32_t unused = 0;
+
+     while (unused < SIM_STACK_SIZE && firmwareStack[unused] == SIM_STACK_PAINT) {
+         unused++;
+     }
+     return SIM_STACK_SIZE - unused;
+ }
+
+ static void Sim_Usage(const char *name) {
+     fprintf(stderr, "usage: %s [-p first[-last]] [-v] [-r max_refresh_bytes] [-s max_stack_bytes] [-t max_wake_ns]"
+                     " [-m max_turnaround_us] [-c cut_seconds | -C torn_cut_seconds]\n", name);
+     exit(2);
+ }
+
+ static void Sim_ParseArgs(int argc, char **argv) {
+     for (int i = 1; i < argc; i++) {
+         const char *option = argv[i];
+         char *end;
+         unsigned long value;
+
+         if (strcmp(option, "-v") == 0) {
+             verbose = 1;
+             continue;
+         }
+         if (i + 1 >= argc || option[0] != '-' || option[2] != '\0') {
+             Sim_Usage(argv[0]);
+         }
+         value = strtoul(argv[++i], &end, 10);
+         switch (option[1]) {
+             case 'p':
+                 if (value < 1 || value > PROGRAM_COUNT) {
+                     Sim_Usage(argv[0]);
+                 }
+                 firstProgram = lastProgram = (uint8_t)(value - 1U);
+                 if (*end == '-') {
+                     value = strtoul(end + 1, &end, 10);
+                     if (value < firstProgram + 1U || value > PROGRAM_COUNT) {
+                         Sim_Usage(argv[0]);
+                     }
+                     lastProgram = (uint8_t)(value - 1U);
+                 }
+                 break;
+             case 'r':
+                 maxRefreshBudget = (uint32_t)value;
+                 break;
+             case 's':
+                 maxStackBudget = (uint32_t)value;
+                 break;
+             case 't':
+                 maxWakeBudget = (uint32_t)value;
+                 break;
+             case 'm':
+                 maxTurnaroundBudget = (uint32_t)value;
+                 break;
+             case 'c':
+             case 'C':
+                 if (value == 0 || cutSeconds != 0) {
+                     Sim_Usage(argv[0]);
+                 }
+                 cutSeconds = (uint32_t)value;
+                 cutTorn = option[1] == 'C';
+                 break;
+             default:
+                 Sim_Usage(argv[0]);
+         }
+         if (*end != '\0') {
+             Sim_Usage(argv[0]);
+         }
+     }
+ }
+
+ static uint8_t Sim_Budget(const char *name, uint64_t value, uint32_t budget) {
+     if (budget == 0 || value <= budget) {
+         return 1;
+     }
+     printf("BUDGET %s: %llu > %u\n", name, (unsigned long long)value, budget);
+     return 0;
+ }
+
+ // Per-program table, per-state cost and totals; returns 1 if anything failed
+ static uint8_t Sim_Report(uint64_t wallNs, uint32_t stackUsed) {
+     uint32_t dumpLines = 0;
+     uint32_t bootSafeUs = 0;
+     uint32_t bootReadyUs = 0;
+     uint8_t dumpGood = Sim_CheckDump(&dumpLines, &bootSafeUs, &bootReadyUs);
+     uint64_t simNs = 0;
+     uint32_t maxRefresh = 0;
+     uint64_t maxWake = 0;
+     uint8_t failed = 0;
+
+     printf("prog result        sim[s]     wakes  mean[ns]   max[ns]  refresh  mean[B]  max[B]\n");
+     for (uint8_t p = firstProgram; p <= lastProgram; p++) {
+         const SimResult *result = &results[p];
+         uint32_t meanRefresh = (result->refreshes == 0) ? 0 : (uint32_t)(result->refreshBytes / result->refreshes);
+
+         printf("%4u %-12s %7.1f %9llu %9llu %9llu %8u %8u %7u\n", p + 1U,
+                result->passed ? "DONE" : result->reason, (double)result->simNs / 1e9,
+                (unsigned long long)result->wakes, (unsigned long long)Sim_Mean(&result->cost),
+                (unsigned long long)result->cost.maxNs, result->refreshes, meanRefresh, result->maxRefresh);
+         failed |= !result->passed;
+         simNs += result->simNs;
+         if (result->maxRefresh > maxRefresh) {
+             maxRefresh = result->maxRefresh;
+         }
+         if (result->cost.maxNs > maxWake) {
+             maxWake = result->cost.maxNs;
+         }
+     }
+
+     printf("\nstate    wakes      mean[ns]   max[ns]\n");
+     for (uint8_t s = 0; s < SIM_STATE_COUNT; s++) {
+         if (stateCost[s].count > 0) {
+             printf("%-6s %9llu %11llu %9llu\n", stateNames[s], (unsigned long long)stateCost[s].count,
+                    (unsigned long long)Sim_Mean(&stateCost[s]), (unsigned long long)stateCost[s].maxNs);
+         }
+     }
+
+     printf("\nsimulated %.1f s in %.2f s wall (x%.0f)\n", (double)simNs / 1e9, (double)wallNs / 1e9,
+            (wallNs == 0) ? 0.0 : (double)simNs / (double)wallNs);
+     printf("display: %llu command + %llu data bytes, %llu outside a transfer or past the panel edge\n",
+            (unsigned long long)commandBytes, (unsigned long long)dataBytes, (unsigned long long)badBytes);
+     printf("power: %.1f s in Stop mode (%.1f %%, %lu entries), average core clock %.1f MHz, "
+            "%lu refused level switches\n",
+            (double)Mock_StopNs() / 1e9, (Mock_NowNs() == 0) ? 0.0 : 100.0 * (double)Mock_StopNs() / (double)Mock_NowNs(),
+            (unsigned long)Power_GetStops(),
+            (Mock_NowNs() == 0) ? 0.0 : (double)Mock_CoreCycles() * 1e3 / (double)Mock_NowNs(),
+            (unsigned long)Power_GetSwitchFailures());
+     printf("boot: ready after %.3f ms\n", (double)bootReadyNs / 1e6);
+     printf("clock: %llu of %llu sleeps with a time of day off the calendar\n",
+            (unsigned long long)clockStale, (unsigned long long)clockChecks);
+     printf("modbus: %llu polls, %llu answered, %llu missed, %llu wrong, %llu to another unit; "
+            "turnaround mean %.3f ms, max %.3f ms\n",
+            (unsigned long long)busPolls, (unsigned long long)busAnswered, (unsigned long long)busMissed,
+            (unsigned long long)busBad, (unsigned long long)busStray,
+            (double)Sim_Mean(&busTurnaround) / 1e6, (double)busTurnaround.maxNs / 1e6);
+     printf("profile: dump of %lu lines, %lu bytes in %.1f ms; boot-safe %lu us, boot-ready %lu us\n",
+            (unsigned long)dumpLines, (unsigned long)(dumpBytes + dumpLost),
+            (dumpDoneNs == 0) ? 0.0 : (double)(dumpDoneNs - dumpStartNs) / 1e6,
+            (unsigned long)bootSafeUs, (unsigned long)bootReadyUs);
+     printf("journal: %lu records, %lu page erases\n", (unsigned long)Mock_FlashWrites(),
+            (unsigned long)Mock_FlashErases());
+     if (cutSeconds != 0) {
+         printf("power cut: %s after %u s; journal program %u step %u, %u s run; resumed program %u step %u, %u s left\n",
+                cutTorn ? "torn record" : "clean", cutSeconds, powerCut.entry.programIndex + 1U,
+                powerCut.entry.stepIndex, powerCut.entry.elapsedSeconds, resumeStatus.programIndex + 1U,
+                resumeStatus.stepIndex, resumeStatus.remainingSeconds);
+     }
+     printf("stack: %u bytes (host frames), heap calls: %llu\n", stackUsed, (unsigned long long)heapCalls);
+     if (verbose) {
+         printf("\nprofile dump:\n%s", dumpText);
+         printf("\npanel:\n");
+         for (uint8_t page = 0; page < SIM_PANEL_PAGES; page++) {
+             for (uint8_t bit = 0; bit < 8U; bit++) {
+                 for (uint8_t col = 0; col < DISPLAY_PANEL_COLUMNS; col++) {
+                     putchar((panel[page][col] >> bit) & 1U ? '#' : ' ');
+                 }
+                 putchar('\n');
+             }
+         }
+     }
+
+     failed |= !Sim_Budget("refresh bytes", maxRefresh, maxRefreshBudget);
+     failed |= !Sim_Budget("stack bytes", stackUsed, maxStackBudget);
+     failed |= !Sim_Budget("wake ns", maxWake, maxWakeBudget);
+     failed |= !Sim_Budget("turnaround us", busTurnaround.maxNs / 1000U, maxTurnaroundBudget);
+     if (heapCalls > 0 || badBytes > 0) {
+         printf("FAIL: heap calls or stray display bytes\n");
+         failed = 1;
+     }
+     if (Power_GetSwitchFailures() != rccFaultInjected) {
+         printf("FAIL: refused clock switch not counted once\n");
+         failed = 1;
+     }
+     if (dumpDoneNs == 0 || !dumpGood) {
+         printf("FAIL: profiler dump incomplete or boot probes missing\n");
+         failed = 1;
+     }
+     if (cutSeconds != 0 && !resumeGood) {
+         printf("FAIL: cycle not resumed at the journal's step and time\n");
+         failed = 1;
+     }
+     if (clockStale > 0 || clockChecks == 0) {
+         printf("FAIL: firmware time of day does not follow the RTC\n");
+         failed = 1;
+     }
+     if (busMissed > 0 || busBad > 0 || busStray > 0 || busAnswered == 0) {
+         printf("FAIL: Modbus polls missed or answered wrongly\n");
+         failed = 1;
+     }
+     printf("%s\n", failed ? "FAIL" : "PASS");
+     return failed;
+ }
+
+ // Run the first program in a child up to the power cut, then boot here on the flash it left
+ static void Sim_RunPowerCut(void) {
+     uint8_t *data = (uint8_t *)&powerCut;
+     size_t got = 0;
+     int fds[2];
+     int status;
+     pid_t child;
+
+     fflush(NULL);
+     if (pipe(fds) != 0 || (child = fork()) < 0) {
+         perror("power cut");
+         exit(2);
+     }
+     if (child == 0) {
+         close(fds[0]);
+         cutPipe = fds[1];
+         return;
+     }
+     close(fds[1]);
+     while (got < sizeof(powerCut)) {
+         ssize_t n = read(fds[0], data + got, sizeof(powerCut) - got);
+
+         if (n <= 0) {
+             break;
+         }
+         got += (size_t)n;
+     }
+     close(fds[0]);
+     if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+         got != sizeof(powerCut) || !powerCut.found) {
+         printf("FAIL: power cut run did not leave a running cycle in the journal\n");
+         exit(1);
+     }
+
+     // Power back: no buttons, the journal alone restarts the program
+     Mock_LoadFlash(powerCut.flash);
+     resumePending = 1;
+     Plant_Reset((program % SIM_UNBALANCE_EVERY == SIM_UNBALANCE_EVERY - 1U) ? SIM_UNBALANCE : 0.0);
+     phase = SCRIPT_RUN;
+     programStartNs = 0;
+     startCheckNs = SIM_START_CHECK_MS * SIM_MS;
+     measuring = 1;
+ }
+
+ int main(int argc, char **argv) {
+     uint64_t wallStart;
+     uint64_t wallNs;
+
+     Sim_ParseArgs(argc, argv);
+     program = firstProgram;
+     if (cutSeconds != 0) {
+         Sim_RunPowerCut();
+     }
+
+     memset(firmwareStack, SIM_STACK_PAINT, sizeof(firmwareStack));
+     getcontext(&firmwareContext);
+     firmwareContext.uc_stack.ss_sp = firmwareStack;
+     firmwareContext.uc_stack.ss_size = sizeof(firmwareStack);
+     firmwareContext.uc_link = NULL;
+     makecontext(&firmwareContext, Sim_FirmwareEntry, 0);
+
+     // Runs until the script has finished the last program
+     wallStart = Sim_HostNs();
+     swapcontext(&simContext, &firmwareContext);
+     wallNs = Sim_HostNs() - wallStart;
+     firmwareRunning = 0;
+     return Sim_Report(wallNs, Sim_StackUsed());
+ }
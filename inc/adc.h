@@ -1,33 +1,148 @@
 /**
  * @file adc.h
- * @brief Interface for ADC-based temperature reading on STM32C0 series.
+ * @brief Interface for ADC-based sensor reading on STM32C0 series.
  *
  * This header file provides the declaration for accessing the ADC hardware
- * (hadc1) and reading temperature values through the function Read_Temperature().
+ * (hadc1) and reading sensor values through a scan group: a fixed list of
+ * channels (temperature, water level, motor current) that the ADC converts
+ * in one hardware sequence, with DMA copying each sequence into a circular
+ * buffer in the background.
  * It includes:
- * - External declaration of the ADC handle (hadc1) used for ADC operations.
- * - Prototype for the Read_Temperature() function, which reads an analog
- *   value from the ADC, converts it to a floating-point temperature value,
- *   and returns it.
+ * - External declaration of the ADC handle (hadc1) and its DMA channel (hdma_adc1).
+ * - `ADC_ScanChannel` enum naming the members of the scan group, in sequence order.
+ * - Prototype for ADC_Init(), which configures the scan sequence, and ADC_Start(),
+ *   which calibrates the ADC and starts sampling (a boot stage, boot.h).
+ * - ADC_HasSamples(), 1 once the first sample set has been filtered.
+ * - Per-channel accessors ADC_GetRaw() (latest filtered 12-bit sample) and
+ *   ADC_GetFiltered() (same value with ADC_OVERSAMPLE_BITS extra bits), and
+ *   ADC_GetLatest(), the newest unfiltered conversion, at most one scan
+ *   sequence old.
+ * - ADC_SetFilterTimeConstant() to tune the per-channel IIR stage of the
+ *   filter pipeline (hardware oversampling → mean → median → IIR), which runs
+ *   in the DMA callbacks so values are already filtered when read.
+ * - A "new sample set ready" flag (ADC_ScanReady()) and an optional callback
+ *   (ADC_SetScanCallback()) so consumers don't have to poll the hardware.
+ * - ADC_Process(), run by the scheduler's sensor task, which converts each new
+ *   sample set into engineering units once instead of on every read.
+ * - Prototype for the Read_Temperature() function, which returns the most
+ *   recent filtered temperature sample in tenths of a degree (`int16_t`).
+ *   It never starts or waits on a conversion and uses no floating point.
+ * - Read_WaterLevel(), the drum water level in percent of capacity, scaled
+ *   linearly between the empty and full sensor readings (multiply and shift).
+ * - `TempCalibration` lookup table type and ADC_SetTemperatureCalibration(),
+ *   so each board revision can supply its own calibration points from flash.
  *
  * This file uses include guards to prevent multiple inclusions and relies
  * on the STM32 HAL library for hardware abstraction.
  *
  * Usage:
- * Include this header in any source file that needs to initiate ADC readings
- * or read temperature data.
+ * Call ADC_Init() and ADC_Start() once at startup, then include this header in any source
+ * file that needs to read temperature, water level or motor current data.
  */
 
 
  #ifndef ADC_H
  #define ADC_H
- 
+
  #include "stm32c0xx_hal.h"
- 
+ #include "ramfunc.h"
+ #include <stdint.h>
+
+ // Temperature sensor input (PA6: SPI1 MISO, unused by the write-only panel;
+ // PA0-PA3 are the buttons)
+ #define TEMP_SENSOR_ADC_CHANNEL    ADC_CHANNEL_6
+ #define TEMP_SENSOR_PORT           GPIOA
+ #define TEMP_SENSOR_PIN            GPIO_PIN_6
+
+ // Water level sensor input
+ #define WATER_LEVEL_ADC_CHANNEL    ADC_CHANNEL_4
+ #define WATER_LEVEL_PORT           GPIOA
+ #define WATER_LEVEL_PIN            GPIO_PIN_4
+
+ // Water level sensor readings (12-bit) at an empty drum and at fill capacity
+ #define WATER_LEVEL_EMPTY_RAW      400
+ #define WATER_LEVEL_FULL_RAW       3600
+
+ // Motor current sense input
+ #define MOTOR_CURRENT_ADC_CHANNEL  ADC_CHANNEL_8
+ #define MOTOR_CURRENT_PORT         GPIOA
+ #define MOTOR_CURRENT_PIN          GPIO_PIN_8
+
+ // Scan group members, in hardware sequence order
+ typedef enum {
+     ADC_CH_TEMPERATURE = 0,
+     ADC_CH_WATER_LEVEL,
+     ADC_CH_MOTOR_CURRENT,
+     ADC_SCAN_CHANNEL_COUNT
+ } ADC_ScanChannel;
+
+ // Complete sequences held in the circular DMA buffer (filtered one half at a time)
+ #define ADC_SCAN_DEPTH_LOG2        4
+ #define ADC_SCAN_DEPTH             (1 << ADC_SCAN_DEPTH_LOG2)
+ #define ADC_DMA_BUFFER_LEN         (ADC_SCAN_DEPTH * ADC_SCAN_CHANNEL_COUNT)
+
+ // Extra resolution gained by hardware oversampling (16x, shifted right by 2)
+ #define ADC_OVERSAMPLE_BITS        2
+
+ // Default IIR time constant, in powers of two of the half-buffer period
+ #define ADC_FILTER_DEFAULT_SHIFT   2
+
+ // Temperature calibration: one point every 2^TEMP_CAL_SHIFT raw counts across the
+ // 12-bit range, so interpolation between points needs only a multiply and a shift.
+ #define TEMP_CAL_SHIFT             8
+ #define TEMP_CAL_POINTS            ((4096 >> TEMP_CAL_SHIFT) + 1)
+
+ // Whole degrees to the 0.1 °C fixed-point unit used by Read_Temperature()
+ #define TEMP_DECI(degrees)         ((int16_t)((degrees) * 10))
+
+ // Temperature in 0.1 °C at raw = i << TEMP_CAL_SHIFT, for i = 0..TEMP_CAL_POINTS-1
+ typedef struct {
+     int16_t deci[TEMP_CAL_POINTS];
+ } TempCalibration;
+
+ // Called from the DMA interrupt each time a new filtered sample set is published
+ typedef void (*ADC_ScanCallback)(void);
+
  extern ADC_HandleTypeDef hadc1;
- 
- // Function prototype to read temperature from ADC
- float Read_Temperature(void);
- 
+ extern DMA_HandleTypeDef hdma_adc1;
+
+ // Configure the scan sequence + DMA
+ void ADC_Init(void);
+
+ // Calibrate, then start continuous background sampling
+ void ADC_Start(void);
+
+ // 1 once the first sample set has been filtered (the readings are real from then on)
+ uint8_t ADC_HasSamples(void);
+
+ // Latest filtered raw 12-bit sample for one scan group member (non-blocking)
+ uint16_t ADC_GetRaw(ADC_ScanChannel channel);
+
+ // Latest filtered sample with ADC_OVERSAMPLE_BITS extra bits of resolution
+ uint16_t ADC_GetFiltered(ADC_ScanChannel channel);
+
+ // Newest conversion as DMA stored it: hardware oversampling only, ADC_OVERSAMPLE_BITS extra bits
+ RAMFUNC uint16_t ADC_GetLatest(ADC_ScanChannel channel);
+
+ // IIR time constant for one channel (shift 0 = median output unsmoothed)
+ void ADC_SetFilterTimeConstant(ADC_ScanChannel channel, uint8_t shift);
+
+ // Returns 1 once per new sample set, then clears the flag
+ uint8_t ADC_ScanReady(void);
+
+ // Register a callback for new sample sets (NULL to disable)
+ void ADC_SetScanCallback(ADC_ScanCallback callback);
+
+ // Convert a newly published sample set (called from the sensor task)
+ void ADC_Process(void);
+
+ // Select the calibration table (must stay valid, normally const in flash)
+ void ADC_SetTemperatureCalibration(const TempCalibration *calibration);
+
+ // Function prototype to read temperature from ADC, in 0.1 °C
+ int16_t Read_Temperature(void);
+
+ // Water level in percent of capacity (0-100)
+ uint8_t Read_WaterLevel(void);
+
  #endif // ADC_H
- 
\ No newline at end of file
@@ -0,0 +1,68 @@
+/**
+ * @file balance.h
+ * @brief Streaming drum unbalance detector for the spin ramp.
+ *
+ * This header declares the balance module. An unbalanced load makes the drum
+ * speed and the motor current swing once per revolution. The detector measures
+ * that once-per-revolution component of both signals as the tach pulses arrive,
+ * with running sums only (no sample buffers), and turns the result into a
+ * verdict the spin logic can act on while the drum is still accelerating.
+ *
+ * Definitions:
+ * - `BalanceVerdict` enum: MEASURING (not enough revolutions yet), OK (keep
+ *   ramping), HOLD (stop accelerating and let the load settle) or REDISTRIBUTE
+ *   (drop to tumble speed and try again).
+ * - `BALANCE_SPEED_*_PCT`, `BALANCE_CURRENT_*_PCT`: Ripple thresholds, as a
+ *   percentage of the mean over the same revolution.
+ *
+ * Function Prototypes:
+ * - `Balance_Init()`: Build the trend tables and clear the detector.
+ * - `Balance_Reset()`: Start a new measurement (spin start or retry).
+ * - `Balance_Pulse()`: Feed one tach period; called from the TIM1 capture interrupt.
+ * - `Balance_GetVerdict()`: Current verdict (plain loads and compares).
+ * - `Balance_GetSpeedRipple()` / `Balance_GetCurrentRipple()`: Smoothed ripple
+ *   in 0.1 % of the mean, for diagnostics.
+ *
+ * Notes:
+ * - Only the first harmonic of the revolution is measured, so the belt and
+ *   commutation ripple at higher orders do not count as unbalance.
+ * - Revolutions below `BALANCE_MIN_RPM` are ignored: the load still tumbles there.
+ * - The motor current is sampled fresh for every tach pulse up to about
+ *   5000 rpm (balance.c), so the current term holds over the whole spin range.
+ */
+
+
+
+ #ifndef BALANCE_H
+ #define BALANCE_H
+
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ typedef enum {
+     BALANCE_MEASURING = 0,
+     BALANCE_OK,
+     BALANCE_HOLD,
+     BALANCE_REDISTRIBUTE
+ } BalanceVerdict;
+
+ // Speed ripple (share of the mean tach period) for HOLD and REDISTRIBUTE
+ #define BALANCE_SPEED_HOLD_PCT           2U
+ #define BALANCE_SPEED_REDISTRIBUTE_PCT   5U
+
+ // Motor current ripple (share of the mean current) for HOLD and REDISTRIBUTE
+ #define BALANCE_CURRENT_HOLD_PCT         15U
+ #define BALANCE_CURRENT_REDISTRIBUTE_PCT 35U
+
+ // Revolutions measured before the first verdict, and the slowest one counted
+ #define BALANCE_MIN_REVS                 4U
+ #define BALANCE_MIN_RPM                  90U
+
+ void Balance_Init(void);
+ void Balance_Reset(void);
+ RAMFUNC void Balance_Pulse(uint32_t periodUs);
+ BalanceVerdict Balance_GetVerdict(void);
+ uint16_t Balance_GetSpeedRipple(void);
+ uint16_t Balance_GetCurrentRipple(void);
+
+ #endif // BALANCE_H
@@ -0,0 +1,61 @@
+/**
+ * @file bench.h
+ * @brief On-target benchmark image: SPI, ADC, rendering and RTC costs over USART2.
+ *
+ * This header declares the benchmark runner. A firmware built with `BENCH_IMAGE`
+ * set boots through the normal peripheral setup, then `Bench_Run()` takes over
+ * instead of the washer: it times the display and sensor paths on the real
+ * hardware, prints one line per benchmark and stops. The numbers are meant for
+ * choosing the system clock and the panel SPI prescaler of each board revision.
+ *
+ * Definitions:
+ * - `BENCH_IMAGE`: Build flag (default 0). With 0 the module adds no code and
+ *   `Bench_Run()` returns at once, so the product image is unchanged. The
+ *   benchmark image has its own build: `make -C target IMAGE=bench` writes
+ *   it to target/build/bench/<profile>/; `make -C host bench` compiles it
+ *   against the mock HAL.
+ * - `BENCH_SPI_FRAMES`: Full-panel frames sent per SPI measurement.
+ * - `BENCH_ADC_SCANS`: DMA half-buffer scans, and polled sequences, per ADC measurement.
+ * - `BENCH_RENDER_ROUNDS`: Repetitions of the glyph and framebuffer benchmarks.
+ * - `BENCH_RTC_READS`: Reads per RTC measurement.
+ *
+ * Function Prototypes:
+ * - `Bench_Run()`: Run every benchmark in turn, print the report, then sleep
+ *   forever. Call once, after `Display_Init()`.
+ *
+ * Notes:
+ * - The C0 has no DWT cycle counter; timing is taken from SysTick through
+ *   `Boot_Cycles()` (boot.h), which resolves one core clock.
+ * - Report output: the console (console.h), USART2 TX on PA14, blocking. PA14
+ *   is SWCLK, so the debugger detaches when the report starts.
+ * - Report format: a `clock <Hz>` header, then `name ops cycles/op ns/op bytes/s`
+ *   per benchmark, with `-` where no data is moved.
+ * - Interrupts stay enabled (SysTick drives the clock, DMA and SPI the transfers);
+ *   the button and RTC interrupts add a few cycles to whichever run they hit.
+ */
+
+
+
+ #ifndef BENCH_H
+ #define BENCH_H
+
+ #ifndef BENCH_IMAGE
+ #define BENCH_IMAGE  0
+ #endif
+
+ #define BENCH_SPI_FRAMES     8U
+ #define BENCH_ADC_SCANS      16U
+ #define BENCH_RENDER_ROUNDS  16U
+ #define BENCH_RTC_READS      256U
+
+ #if BENCH_IMAGE
+
+ void Bench_Run(void);
+
+ #else
+
+ static inline void Bench_Run(void) {}
+
+ #endif // BENCH_IMAGE
+
+ #endif // BENCH_H
@@ -0,0 +1,63 @@
+/**
+ * @file boot.h
+ * @brief Staged boot: safe outputs first, slow peripheral bring-up in the background.
+ *
+ * This header declares the boot sequencer. `main()` forces the outputs off and
+ * arms the buttons before anything that has to wait on hardware, then starts
+ * the scheduler. The peripherals that need settling time come up as
+ * independent stages, advanced from the main loop between events, side by side:
+ *
+ * - RTC: start the LSI, wait until it is ready, then set up the calendar and
+ *   the second alarm (`MX_RTC_Init()`).
+ * - ADC: calibrate and start the scan (`ADC_Start()`), wait for the first
+ *   filtered sample set and convert it, so the first readings are real ones.
+ * - Panel: send the controller's clear command and let it execute.
+ *
+ * Definitions:
+ * - `BootStage` enum: Stage identifiers, in table order.
+ * - `BOOT_RTC_TIMEOUT_MS`, `BOOT_ADC_TIMEOUT_MS`: Longest a stage may wait;
+ *   past that the board is faulty and `Error_Handler()` runs (outputs stay off).
+ *
+ * Function Prototypes:
+ * - `Boot_Start()`: Record the time to safe outputs and start every stage. Call
+ *   once the outputs and buttons are set up.
+ * - `Boot_Service()`: Advance every stage still waiting. Returns 1 once, on the
+ *   call that finishes the last stage; cheap once done.
+ * - `Boot_IsDone()`: 1 once every stage has finished.
+ * - `Boot_Cycles()`: Core clock cycles since `HAL_Init()` started SysTick
+ *   (milliseconds times the reload, plus the down-counter), for timing short
+ *   runs at one clock level; 32 bits, so it wraps after some 89 s at 48 MHz.
+ *
+ * Notes:
+ * - Times are recorded through the profiler (`PROFILE_BOOT_SAFE`,
+ *   `PROFILE_BOOT_READY`), in microseconds since `HAL_Init()` started SysTick.
+ *   The startup code before `main()` (data copy, bss clear) comes on top and
+ *   only depends on the image size.
+ * - Until `Boot_IsDone()` the main loop does not flush the display, hand button
+ *   events to the washer or enter Stop mode.
+ */
+
+
+
+ #ifndef BOOT_H
+ #define BOOT_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+
+ #define BOOT_RTC_TIMEOUT_MS  10U
+ #define BOOT_ADC_TIMEOUT_MS  50U
+
+ typedef enum {
+     BOOT_STAGE_RTC = 0,
+     BOOT_STAGE_ADC,
+     BOOT_STAGE_PANEL,
+     BOOT_STAGE_COUNT
+ } BootStage;
+
+ void Boot_Start(void);
+ uint8_t Boot_Service(void);
+ uint8_t Boot_IsDone(void);
+ uint32_t Boot_Cycles(void);
+
+ #endif // BOOT_H
@@ -0,0 +1,79 @@
+/**
+ * @file button.h
+ * @brief Timer-scanned debouncer for the four front-panel buttons.
+ *
+ * This header declares the button debouncer. All buttons are sampled together
+ * as one bitmask from the TIM17 scan tick and debounced with a 2-bit vertical
+ * counter, so RAM use and cycles per tick are the same for one button or eight.
+ *
+ * Definitions:
+ * - `WasherButton` enum: Logical button identifiers (bit positions in the mask,
+ *   matching `BUTTON_START_PIN`..`BUTTON_DOWN_PIN` = GPIOA pins 0..3 in main.h).
+ * - `ButtonAction` enum: Clean events produced by the debouncer.
+ * - `BUTTON_EVENT_PARAM()` / `BUTTON_EVENT_ID()` / `BUTTON_EVENT_ACTION()`:
+ *   Packing of button + action into the one-byte `Event.param`.
+ *
+ * Timing:
+ * - A change is accepted after 4 identical samples (4 x `BUTTON_SCAN_MS`).
+ * - `BUTTON_LONG_PRESS` fires once after `BUTTON_LONG_MS` held.
+ * - `BUTTON_REPEAT` fires every `BUTTON_REPEAT_MS` after `BUTTON_REPEAT_DELAY_MS`.
+ *
+ * Function Prototypes:
+ * - `Button_Init()`: Configure TIM17 as the scan tick (stopped until needed).
+ * - `Button_Wake()`: Called from the button EXTI callback; starts scanning.
+ * - `Button_Scan()`: Called from the TIM17 update interrupt; posts events and
+ *   stops the scan tick again once every button is released and stable.
+ * - `Button_IsScanning()`: Nonzero while the scan tick runs (a button is held or settling).
+ */
+
+
+
+ #ifndef BUTTON_H
+ #define BUTTON_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ // Button identifiers (bit n of the sample mask = GPIOA pin n)
+ typedef enum {
+     BUTTON_START,
+     BUTTON_STOP,
+     BUTTON_UP,
+     BUTTON_DOWN,
+     BUTTON_COUNT
+ } WasherButton;
+
+ typedef enum {
+     BUTTON_PRESSED,
+     BUTTON_RELEASED,
+     BUTTON_LONG_PRESS,
+     BUTTON_REPEAT
+ } ButtonAction;
+
+ #define BUTTON_MASK             ((1u << BUTTON_COUNT) - 1u)
+
+ // Scan and hold timing
+ #define BUTTON_SCAN_MS          5U
+ #define BUTTON_LONG_MS          1000U
+ #define BUTTON_REPEAT_DELAY_MS  500U
+ #define BUTTON_REPEAT_MS        150U
+ 
+ // Hold counters are one byte each
+ #if (BUTTON_LONG_MS / BUTTON_SCAN_MS) > 255 || (BUTTON_REPEAT_DELAY_MS / BUTTON_SCAN_MS) > 255
+ #error "Button hold times exceed the 8-bit scan counters"
+ #endif
+
+ // Event.param packing
+ #define BUTTON_EVENT_PARAM(button, action)  ((uint8_t)(((action) << 4) | (button)))
+ #define BUTTON_EVENT_ID(param)              ((param) & 0x0Fu)
+ #define BUTTON_EVENT_ACTION(param)          ((ButtonAction)((param) >> 4))
+
+ extern TIM_HandleTypeDef htim17;
+
+ void Button_Init(void);
+ void Button_Wake(void);
+ RAMFUNC void Button_Scan(void);
+ uint8_t Button_IsScanning(void);
+
+ #endif // BUTTON_H
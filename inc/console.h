@@ -0,0 +1,56 @@
+/**
+ * @file console.h
+ * @brief Text output on USART2 for the profiler dump and the benchmark report.
+ *
+ * This header declares the console: USART2 set up transmit only, and the line
+ * formatting the profiler (profile.h) and the benchmark image (bench.h) share.
+ * The console only sends; each user picks its own transfer (the profiler
+ * interrupt driven, one line per scheduler pass, the benchmark blocking).
+ *
+ * Definitions:
+ * - `CONSOLE_ENABLE`: 1 when a user of the console is built in (`PROFILE_ENABLE`
+ *   or `BENCH_IMAGE`); with 0 the module adds no code, RAM or peripherals.
+ * - `CONSOLE_GPIO_PORT`, `CONSOLE_TX_PIN`, `CONSOLE_BAUD`: Output pin and speed, 8N1.
+ *
+ * External Variables:
+ * - `huart2`: The console UART, for `HAL_UART_Transmit()` / `HAL_UART_Transmit_IT()`.
+ *
+ * Function Prototypes:
+ * - `Console_Init()`: Configure USART2 and take over the pin; later calls do nothing.
+ * - `Console_Append()`: Copy text to `out`; returns the new end.
+ * - `Console_AppendNumber()`: Append a space and a decimal number; returns the new end.
+ *
+ * Notes:
+ * - PA14 is also SWCLK: the debugger detaches at `Console_Init()` and stays
+ *   detached until the next reset, so call it only once output is wanted.
+ * - The formatters write no terminator; callers size their line buffers for the
+ *   longest line (a number is at most 11 characters with its space).
+ */
+
+
+
+ #ifndef CONSOLE_H
+ #define CONSOLE_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+ #include "profile.h"
+ #include "bench.h"
+
+ #define CONSOLE_ENABLE     (PROFILE_ENABLE || BENCH_IMAGE)
+
+ #define CONSOLE_GPIO_PORT  GPIOA
+ #define CONSOLE_TX_PIN     GPIO_PIN_14
+ #define CONSOLE_BAUD       115200U
+
+ #if CONSOLE_ENABLE
+
+ extern UART_HandleTypeDef huart2;
+
+ void Console_Init(void);
+ char *Console_Append(char *out, const char *text);
+ char *Console_AppendNumber(char *out, uint32_t value);
+
+ #endif // CONSOLE_ENABLE
+
+ #endif // CONSOLE_H
@@ -1,107 +1,63 @@
 /**
- * @file washer.c
- * @brief Washer control state machine implementation for STM32-based system.
+ * @file display.h
+ * @brief Framebuffer display interface for the washer status panel.
  *
- * This source file defines the core behavior of the washer control system, 
- * managing different operating states and responding to user inputs.
- * It includes:
- * - Initialization of the washer control structure.
- * - Periodic updating of the washer's operating state (state machine).
- * - Handling of button presses (Start, Stop, Up, Down) to control program selection and operation.
- * - Interaction with the display module to reflect the current washer state and selected program.
+ * This header declares the display layer used by the washer firmware. All
+ * drawing goes into a RAM framebuffer laid out like the panel controller's
+ * memory (DISPLAY_PAGES pages of 8 pixel rows, one byte per column per page,
+ * bit 0 = top pixel). Nothing is sent to the panel until `Display_Flush()`.
  *
- * Main Functions:
- * - Washer_Init(WasherControl *washer): Initializes the washer to the IDLE state and updates the display.
- * - Washer_Update(WasherControl *washer): Progresses the washer through its operation cycle 
- *   (FILL_WATER → WASH → RINSE → SPIN → IDLE) based on the current state.
- * - Washer_HandleButtonPress(WasherControl *washer, int button): Handles user button input to 
- *   start/stop the washer or change the selected program when idle.
+ * Dirty Tracking:
+ * - Every write compares against the framebuffer and only widens the page's
+ *   dirty column range when a byte actually changes, so redrawing an unchanged
+ *   string costs no SPI traffic.
+ * - `Display_Flush()` queues each dirty range as one CS-asserted DMA burst
+ *   (page/column address commands followed by the column data) and returns
+ *   without waiting for the panel.
  *
- * Dependencies:
- * - washer.h (for WasherControl struct and state definitions)
- * - display.h (for updating the display based on washer state)
- * - main.h (for button definitions)
- * - rtc.h (for updating real-time clock display)
+ * Function Prototypes:
+ * - `Display_Init()`: Clear the framebuffer and mark the whole panel dirty.
+ * - `Display_Clear()`: Blank the framebuffer (change-tracked).
+ * - `Display_DrawString()`: Draw text on a page, padded with spaces to a width.
+ * - `Display_Flush()`: Queue all dirty regions for transmission (non-blocking).
+ * - `Display_IsDirty()`: Nonzero while any region still waits for a flush.
+ * - `Display_UpdateWasherState()`: Draw the state and program on the status line.
+ * - `Display_ShowSelectedProgram()`: Draw the program selection line.
+ * - `Display_UpdateTime()`: Draw the RTC time of day, changed digits only.
  *
- * Notes:
- * - State transitions are linear and automatic after each phase (fill → wash → rinse → spin).
- * - Button handling only affects operation when the washer is IDLE.
- * - The time display is refreshed both during state changes and button presses.
+ * Dependencies:
+ * - washer.h (for `WasherState`)
+ * - spi.h (for the region transfer to the panel)
  */
 
 
+
+ #ifndef DISPLAY_H
+ #define DISPLAY_H
+
+ #include <stdint.h>
  #include "washer.h"
- #include "display.h"
- #include "main.h"
- #include "rtc.h"
- 
- // Initialize washer state
- void Washer_Init(WasherControl *washer) {
-     washer->state = IDLE;
-     washer->programIndex = 0;
-     washer->stepIndex = 0;
-     washer->timer = 0;
-     washer->direction = FORWARD;
-     Display_UpdateWasherState(washer->state, washer->programIndex);
-     Display_UpdateTime();
- }
- 
- // Update washer state machine
- void Washer_Update(WasherControl *washer) {
-     switch (washer->state) {
-         case IDLE:
-             // Wait for start button press
-             break;
-         case FILL_WATER:
-             Display_UpdateWasherState(FILL_WATER, washer->programIndex);
-             // Handle fill water logic
-             washer->state = WASH;
-             break;
-         case WASH:
-             Display_UpdateWasherState(WASH, washer->programIndex);
-             // Handle washing logic
-             washer->state = RINSE;
-             break;
-         case RINSE:
-             Display_UpdateWasherState(RINSE, washer->programIndex);
-             // Handle rinsing logic
-             washer->state = SPIN;
-             break;
-         case SPIN:
-             Display_UpdateWasherState(SPIN, washer->programIndex);
-             // Handle spinning logic
-             washer->state = IDLE;
-             break;
-         case ERROR:
-             Display_UpdateWasherState(ERROR, washer->programIndex);
-             // Handle error condition
-             break;
-         default:
-             Display_UpdateWasherState(ERROR, washer->programIndex);
-             break;
-     }
-     Display_UpdateTime(); // Refresh time display
- }
- 
- // Handle button inputs
- void Washer_HandleButtonPress(WasherControl *washer, int button) {
-     if (button == BUTTON_START && washer->state == IDLE) {
-         washer->state = FILL_WATER;
-         Display_UpdateWasherState(washer->state, washer->programIndex);
-     } else if (button == BUTTON_STOP) {
-         washer->state = IDLE;
-         Display_UpdateWasherState(washer->state, washer->programIndex);
-     } else if (button == BUTTON_UP && washer->state == IDLE) {
-         if (washer->programIndex < 29) {
-             washer->programIndex++;
-             Display_ShowSelectedProgram(washer->programIndex);
-         }
-     } else if (button == BUTTON_DOWN && washer->state == IDLE) {
-         if (washer->programIndex > 0) {
-             washer->programIndex--;
-             Display_ShowSelectedProgram(washer->programIndex);
-         }
-     }
-     Display_UpdateTime(); // Ensure time updates when buttons are pressed
- }
- 
\ No newline at end of file
+
+ // Panel geometry
+ #define DISPLAY_WIDTH        128
+ #define DISPLAY_PAGES        8
+
+ // Text cell (5 glyph columns + 1 spacing column)
+ #define DISPLAY_CHAR_WIDTH   6
+
+ // Screen layout (page numbers)
+ #define DISPLAY_PAGE_STATUS  0
+ #define DISPLAY_PAGE_PROGRAM 2
+ #define DISPLAY_PAGE_CLOCK   7
+
+ void Display_Init(void);
+ void Display_Clear(void);
+ void Display_DrawString(uint8_t page, uint8_t col, const char *text, uint8_t minChars);
+ void Display_Flush(void);
+ uint8_t Display_IsDirty(void);
+
+ void Display_UpdateWasherState(WasherState state, int programIndex);
+ void Display_ShowSelectedProgram(int programIndex);
+ void Display_UpdateTime(void);
+
+ #endif // DISPLAY_H
@@ -0,0 +1,57 @@
+/**
+ * @file event.h
+ * @brief Lock-free event rings between interrupts and the main loop.
+ *
+ * This header declares the event queue used to hand work from interrupt
+ * handlers (the button debouncer, the RTC second interrupt, the step timer) to the main loop, which sleeps in WFI
+ * whenever every ring is empty and no scheduler task is ready.
+ *
+ * Definitions:
+ * - `EventType` enum: Kind of event. Each type has its own single-producer,
+ *   single-consumer ring, so the type doubles as the ring index.
+ * - `Event` struct: Event type plus a one-byte parameter (e.g. packed button + action).
+ * - `EVENT_RING_SIZE`: Capacity of each ring (power of two).
+ *
+ * Function Prototypes:
+ * - `Event_Post()`: Append an event to its type's ring; no interrupt masking.
+ * - `Event_Get()`: Remove the oldest event of the first non-empty ring; called
+ *   from the main loop only.
+ * - `Event_Pending()`: Non-destructive check used before entering sleep.
+ *
+ * Notes:
+ * - Each event type must be posted from one interrupt only (its producer); the
+ *   main loop is the only consumer. Posting a type from a second context needs a
+ *   new type and ring instead.
+ * - Events of one type stay in order; across types, lower enum values are served first.
+ * - When a ring is full new events of that type are dropped and `Event_Post()` returns 0.
+ */
+
+
+
+ #ifndef EVENT_H
+ #define EVENT_H
+
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ // Ring capacity per event type (must be a power of two, at most 128)
+ #define EVENT_RING_SIZE  8
+
+ typedef enum {
+     EVENT_NONE = 0,
+     EVENT_STEP_TIMER,   // Step deadline reached, param = deadline sequence (TIM14, see steptimer.h)
+     EVENT_BUTTON,       // param = BUTTON_EVENT_PARAM(button, action) (TIM17, see button.h)
+     EVENT_CLOCK,        // RTC second elapsed, param unused (RTC alarm, see rtc.h)
+     EVENT_TYPE_COUNT
+ } EventType;
+
+ typedef struct {
+     EventType type;
+     uint8_t param;
+ } Event;
+
+ RAMFUNC uint8_t Event_Post(EventType type, uint8_t param);
+ RAMFUNC uint8_t Event_Get(Event *event);
+ uint8_t Event_Pending(void);
+
+ #endif // EVENT_H
@@ -0,0 +1,65 @@
+/**
+ * @file filter.h
+ * @brief Integer filter building blocks for sampled sensor data.
+ *
+ * This header declares small, allocation-free filters used between the ADC DMA
+ * buffer and the consumers of sensor values. All arithmetic is integer, so the
+ * filters are cheap enough to run inside the DMA half/full-transfer callbacks
+ * on a Cortex-M0+ without an FPU or hardware divider.
+ *
+ * Functionality:
+ * - `MedianFilter`: median of the last FILTER_MEDIAN_LEN samples, rejecting
+ *   single-sample spikes without smearing steps.
+ * - `IirFilter`: first-order low-pass `y += (x - y) / 2^shift`, with the time
+ *   constant set by `shift` (about 2^shift update periods). The state keeps
+ *   FILTER_IIR_FRAC_BITS fractional bits so small steps are not lost.
+ * - `Filter_Decimate()`: averages a power-of-two number of interleaved samples
+ *   using only adds and a shift.
+ *
+ * Notes:
+ * - Each filter instance belongs to exactly one producer (normally an ISR);
+ *   readers should consume the published result instead of the filter state.
+ *
+ * Usage:
+ * - Call the *_Init function once, then feed one sample per update.
+ */
+
+
+
+ #ifndef FILTER_H
+ #define FILTER_H
+
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ // Window length of the median stage (odd, small)
+ #define FILTER_MEDIAN_LEN      3
+
+ // Fractional bits carried in the IIR state
+ #define FILTER_IIR_FRAC_BITS   8
+
+ typedef struct {
+     uint16_t window[FILTER_MEDIAN_LEN];
+     uint8_t pos;
+     uint8_t primed;  // First sample seeds the whole window
+ } MedianFilter;
+
+ typedef struct {
+     int32_t state;   // Filtered value << FILTER_IIR_FRAC_BITS
+     uint8_t shift;   // Time constant as a power of two (0 = pass-through)
+     uint8_t primed;  // First sample loads the state directly
+ } IirFilter;
+
+ // Median-of-N stage
+ void Filter_MedianInit(MedianFilter *filter);
+ RAMFUNC uint16_t Filter_Median(MedianFilter *filter, uint16_t sample);
+
+ // First-order IIR stage
+ void Filter_IirInit(IirFilter *filter, uint8_t shift);
+ void Filter_IirSetShift(IirFilter *filter, uint8_t shift);
+ RAMFUNC uint16_t Filter_Iir(IirFilter *filter, uint16_t sample);
+
+ // Mean of 2^log2Count samples taken every `stride` entries
+ RAMFUNC uint16_t Filter_Decimate(const uint16_t *samples, uint8_t log2Count, uint8_t stride);
+
+ #endif // FILTER_H
@@ -15,7 +15,8 @@
  * - `font[95][5]`: 2D array where each entry holds 5 bytes of column data for one character.
  *
  * Usage:
- * - To render a character, lookup `font[ascii_code - 32]` and draw each column sequentially.
+ * - To render a character, use `FONT_GLYPH(c)` (or `font[c - FONT_FIRST_CHAR]`) and copy its
+ *   `FONT_GLYPH_WIDTH` column bytes; they are already in panel page format.
  * - Assumes top-to-bottom bit ordering for each byte (bit 0 = top pixel, bit 7 = bottom pixel).
  *
  * Dependencies:
@@ -27,8 +28,20 @@
  #ifndef __FONT_H
  #define __FONT_H
  
+ #include <stdint.h>
+ 
+ // Table range and glyph size
+ #define FONT_FIRST_CHAR   32
+ #define FONT_LAST_CHAR    126
+ #define FONT_GLYPH_COUNT  (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+ #define FONT_GLYPH_WIDTH  5
+
+ // Glyph for a character, unprintable characters map to space
+ #define FONT_GLYPH(c) \
+     font[((uint8_t)(c) >= FONT_FIRST_CHAR && (uint8_t)(c) <= FONT_LAST_CHAR) ? (uint8_t)(c) - FONT_FIRST_CHAR : 0]
+
  // Simple 5x8 characters
- extern const uint8_t font[95][5];
+ extern const uint8_t font[FONT_GLYPH_COUNT][FONT_GLYPH_WIDTH];
  
  #endif /* __FONT_H */
  
\ No newline at end of file
@@ -0,0 +1,86 @@
+/**
+ * @file journal.h
+ * @brief Power-fail-safe wash cycle journal in the last two flash pages.
+ *
+ * This header declares the cycle journal. The washer appends a record at every
+ * step boundary, a checkpoint every few minutes inside a step, and an end
+ * record when the cycle finishes, stops or fails. After a power cut the boot
+ * code finds the newest record and, if the cycle was still running, resumes
+ * it at the recorded step and time.
+ *
+ * Definitions:
+ * - `JOURNAL_ENABLE`: Build flag (default 1). With 0 nothing is ever written,
+ *   `Journal_Init()` finds no cycle to resume, and the pages stay free.
+ * - `JournalEntry` struct: Program index, step index and seconds already run in
+ *   that step.
+ * - `JOURNAL_FIRST_PAGE`, `JOURNAL_PAGES`: Flash pages reserved for the journal.
+ * - `JOURNAL_CHECKPOINT_MS`: Time between checkpoints inside a running step.
+ *
+ * Function Prototypes:
+ * - `Journal_Init()`: Find the newest record. Returns 1 and fills `entry` if it
+ *   belongs to a cycle that was still running, 0 otherwise.
+ * - `Journal_Record()`: Append `entry` unless it matches the newest record.
+ * - `Journal_Clear()`: Append an end record unless the newest one already is.
+ * - `Journal_Prepare()`: Erase the spare page if it is not blank yet. Call it
+ *   only with no program running and the motor stopped: the erase holds off
+ *   every interrupt for its duration.
+ *
+ * Notes:
+ * - Records are single flash double words, programmed in one operation: a cut
+ *   during programming leaves either the old state or a record that fails its
+ *   check and is skipped. The pages are used in turn. The other page is erased
+ *   only once the current one holds a record, so the newest valid record
+ *   survives a cut during the erase.
+ * - Each record carries a 16-bit sequence number; the page holding the newer
+ *   last record is the current one. Within a page the slots fill in order, so
+ *   the first blank slot is found by binary search.
+ * - A 2 KB page holds 256 records, about 20 cycles of the longest program.
+ * - The linker script must keep code and data out of the last
+ *   `JOURNAL_PAGES` pages. `Journal_Init()` checks the end of the image
+ *   (`_sidata` plus the size of .data) and calls Error_Handler() on overlap.
+ * - Programming and erasing stall the CPU (about 85 us per record, 22 ms per
+ *   erase); DMA and the timer outputs keep running meanwhile. A record fits
+ *   inside a control period, but an erase does not, so records never erase. A
+ *   record that finds the current page full and the spare not yet erased is
+ *   dropped.
+ */
+
+
+
+ #ifndef JOURNAL_H
+ #define JOURNAL_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+
+ #ifndef JOURNAL_ENABLE
+ #define JOURNAL_ENABLE  1
+ #endif
+
+ #define JOURNAL_PAGES          2U
+ #define JOURNAL_FIRST_PAGE     (FLASH_PAGE_NB - JOURNAL_PAGES)
+ #define JOURNAL_CHECKPOINT_MS  300000U
+
+ typedef struct {
+     uint8_t programIndex;
+     uint8_t stepIndex;
+     uint16_t elapsedSeconds;  // Already run in the step when the record was written
+ } JournalEntry;
+
+ #if JOURNAL_ENABLE
+
+ uint8_t Journal_Init(JournalEntry *entry);
+ void Journal_Record(const JournalEntry *entry);
+ void Journal_Clear(void);
+ void Journal_Prepare(void);
+
+ #else
+
+ static inline uint8_t Journal_Init(JournalEntry *entry) { (void)entry; return 0; }
+ static inline void Journal_Record(const JournalEntry *entry) { (void)entry; }
+ static inline void Journal_Clear(void) {}
+ static inline void Journal_Prepare(void) {}
+
+ #endif // JOURNAL_ENABLE
+
+ #endif // JOURNAL_H
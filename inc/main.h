@@ -19,15 +19,25 @@
  * - Output Ports:
  *   - `BUTTON_GPIO_PORT` (GPIOA)
  *   - `OUTPUT_GPIO_PORT` (GPIOB)
+ *   - `MOTOR_GPIO_PORT`, `WATER_GPIO_PORT` (aliases of `OUTPUT_GPIO_PORT`)
+ * - Status LED: `STATUS_LED_PIN` on `STATUS_LED_GPIO_PORT` (PB5), lit by `Error_Handler()`.
  *
  * External Variables:
- * - `htim3`: Timer used for motor control timing sequences.
- * - `htim14`: Timer used for water filling timeouts.
+ * - `htim3`: Motor PWM timer (motor.c).
+ * - `htim14`: Fill and step deadline timer (steptimer.c).
+ * - `htim16`: Scheduler tick timer; calls `Scheduler_Tick()` every `SCHEDULER_TICK_MS`.
+ *
+ * Task Periods:
+ * - `SPEED_PERIOD_MS`, `CONTROL_PERIOD_MS`, `SENSOR_PERIOD_MS`, `MIXER_PERIOD_MS`, `DISPLAY_PERIOD_MS`, `FLUSH_PERIOD_MS`, `PROFILE_PERIOD_MS`
+ * - `*_DEADLINE_MS`: Release-to-completion deadline of each task.
+ * - `*_BUDGET_MS`: Worst-case run time of the sheddable (cosmetic) work, including
+ *   the clock redraw, which is checked against the next critical release.
  *
  * Function Prototypes:
  * - `SystemClock_Config(void)`: Configures the main system clock.
- * - `GPIO_Init(void)`: Sets up GPIO ports for inputs and outputs.
- * - `Timer_Init(void)`: Initializes timers for motor and water control operations.
+ * - `GPIO_Init(void)`: Sets up GPIO ports for outputs and button EXTI inputs.
+ * - `Timer_Init(void)`: Initializes the scheduler tick timer.
+ * - `Error_Handler(void)`: Fault trap for init and boot-stage failures: outputs off, status LED on.
  *
  * Usage:
  * - Include this file in any module that needs access to core hardware definitions or 
@@ -51,21 +61,53 @@
  #define BUTTON_DOWN_PIN     GPIO_PIN_3
  #define BUTTON_GPIO_PORT    GPIOA
  
- // Motor and Water Outputs
+ // Motor and Water Outputs (motor pins are TIM3 CH3/CH4 once Motor_Init() has run)
  #define MOTOR_FORWARD_PIN   GPIO_PIN_0
  #define MOTOR_REVERSE_PIN   GPIO_PIN_1
  #define WATER_HOT_PIN       GPIO_PIN_2
  #define WATER_COLD_PIN      GPIO_PIN_3
  #define OUTPUT_GPIO_PORT    GPIOB
+ #define MOTOR_GPIO_PORT     OUTPUT_GPIO_PORT
+ #define WATER_GPIO_PORT     OUTPUT_GPIO_PORT
+
+ // Fault indicator, not an actuator
+ #define STATUS_LED_PIN       GPIO_PIN_5
+ #define STATUS_LED_GPIO_PORT GPIOB
  
  // Timer Handles
- extern TIM_HandleTypeDef htim3;  // Motor Control Timer
- extern TIM_HandleTypeDef htim14; // Fill Water Timer
+ extern TIM_HandleTypeDef htim3;  // Motor PWM Timer (motor.c)
+ extern TIM_HandleTypeDef htim14; // Fill / Step Deadline Timer (steptimer.c)
+ extern TIM_HandleTypeDef htim16; // Scheduler Tick Timer
+ 
+ // Task periods (scheduler tick is SCHEDULER_TICK_MS, see scheduler.h)
+ #define SPEED_PERIOD_MS     20U    // Spin PI speed loop, 50 Hz
+ #define CONTROL_PERIOD_MS   50U    // Washer state machine, 20 Hz
+ #define SENSOR_PERIOD_MS    10U    // ADC sample set conversion
+ #define MIXER_PERIOD_MS     100U   // Fill valve time-proportioning
+ #define DISPLAY_PERIOD_MS   1000U  // Status display refresh
+ #define FLUSH_PERIOD_MS     50U    // Framebuffer flush (dirty regions only)
+ #define PROFILE_PERIOD_MS   10U    // Profiler dump, one line per run while dumping
+ 
+ // Task deadlines, from release to completion
+ #define SPEED_DEADLINE_MS   5U
+ #define CONTROL_DEADLINE_MS 10U
+ #define SENSOR_DEADLINE_MS  5U
+ #define MIXER_DEADLINE_MS   20U
+ #define DISPLAY_DEADLINE_MS 1000U
+ #define FLUSH_DEADLINE_MS   50U
+ #define PROFILE_DEADLINE_MS 10U
+ 
+ // Cosmetic work budgets, deferred while a critical task is due within them
+ #define DISPLAY_BUDGET_MS   2U
+ #define FLUSH_BUDGET_MS     1U
+ #define PROFILE_BUDGET_MS   1U
+ #define CLOCK_BUDGET_MS     1U     // Clock digit redraw on EVENT_CLOCK
  
  // Function Prototypes
  void SystemClock_Config(void);
  void GPIO_Init(void);
  void Timer_Init(void);
+ void Error_Handler(void);
  
  #endif // MAIN_H
  
\ No newline at end of file
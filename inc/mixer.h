@@ -0,0 +1,49 @@
+/**
+ * @file mixer.h
+ * @brief Time-proportioned PI mixing of the hot and cold water valves.
+ *
+ * This header declares the fill water mixer. While the drum fills, exactly one
+ * valve is open at any time: each mixing window opens the hot valve for a share
+ * of the window and the cold valve for the rest. A PI loop on the measured water
+ * temperature sets that share, so the fill settles on the step's target instead
+ * of switching between all-hot and all-cold.
+ *
+ * Definitions:
+ * - `MIXER_WINDOW_MS`: Length of one hot/cold cycle; the PI runs once per window.
+ * - `MIXER_KP_Q8`, `MIXER_KI_Q12`: Hot share (1/256 of the window) per 0.1 °C of
+ *   error, and integral share per 0.1 °C per window (1/4096).
+ * - `MIXER_START_SHARE_Q8`: Hot share of the first window, before any feedback.
+ *
+ * Function Prototypes:
+ * - `Mixer_Start()`: Begin mixing toward `target` (0.1 °C); `PROGRAM_TEMP_COLD`
+ *   gives cold water only.
+ * - `Mixer_Stop()`: Close both valves and stop mixing.
+ * - `Mixer_Update()`: Run every `MIXER_PERIOD_MS` (main.h) from the scheduler.
+ * - `Mixer_GetHotShare()`: Current hot share in 1/256 (diagnostics).
+ *
+ * Notes:
+ * - The valves are only driven while the fill deadline is armed; once the step
+ *   timer has closed them from its interrupt, the mixer cannot reopen them.
+ */
+
+
+
+ #ifndef MIXER_H
+ #define MIXER_H
+
+ #include <stdint.h>
+
+ #define MIXER_WINDOW_MS        2000U
+
+ // PI gains: ~9 °C of error alone opens the hot valve for the whole window
+ #define MIXER_KP_Q8            3
+ #define MIXER_KI_Q12           8
+
+ #define MIXER_START_SHARE_Q8   128
+
+ void Mixer_Start(int16_t target);
+ void Mixer_Stop(void);
+ void Mixer_Update(void);
+ uint16_t Mixer_GetHotShare(void);
+
+ #endif // MIXER_H
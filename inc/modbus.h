@@ -0,0 +1,101 @@
+/**
+ * @file modbus.h
+ * @brief Modbus RTU slave on RS-485 for fleet status and telemetry polls.
+ *
+ * This header declares the Modbus interface. A site controller polls each
+ * machine on a shared RS-485 bus; the washer answers read requests for its
+ * state, program, remaining time, sensor readings and fault code from the
+ * published `WasherStatus` snapshot (washer.h). Reception, framing, the reply
+ * and its transmission all run in the USART1 interrupt; the main loop and the
+ * scheduler never see the bus.
+ *
+ * Definitions:
+ * - `MODBUS_ENABLE`: Build flag (default 1). With 0 the module adds no code,
+ *   RAM or peripherals.
+ * - `MODBUS_ADDRESS`: Slave address (1-247), one per machine on the bus; set it
+ *   per unit on the compiler command line (`make -C target DEFS=-DMODBUS_ADDRESS=7U`).
+ * - `MODBUS_BAUD`: Bus speed, 8 data bits, even parity, 1 stop bit (the Modbus
+ *   default framing).
+ * - `ModbusRegister` enum: Register map. Function 0x04 (read input registers)
+ *   and 0x03 (read holding registers) read the same read-only registers.
+ *
+ * Function Prototypes:
+ * - `Modbus_Init()`: Configure USART1 and the RS-485 driver enable, and start
+ *   listening.
+ * - `Modbus_IsBusy()`: Nonzero while a frame is being received or a reply sent;
+ *   the core stays out of Stop mode meanwhile (power.h).
+ * - `Modbus_SetWakeup()`: Arm (1) or disarm (0) the start-bit wakeup; called by
+ *   `Power_Sleep()` around Stop mode.
+ *
+ * Notes:
+ * - Pins: PA9 TX, PA10 RX, PA12 driver enable (DE, driven by the USART, so the
+ *   turnaround to receive needs no software), all AF1.
+ * - Receive: interrupt driven, one interrupt per byte (about 1800 a second on a
+ *   busy bus, a few microseconds each). A frame ends at an idle line (one
+ *   character time of silence) rather than RTU's 3.5 characters, so a reply
+ *   starts about one character time after the request; masters that poll one
+ *   unit at a time and wait for its answer are unaffected.
+ * - Frames for other addresses are dropped on the address byte, without a CRC;
+ *   thirty and more units on one bus cost each of them a few interrupts per
+ *   frame and nothing in the main loop.
+ * - Transmit: interrupt driven; a read of every register is 25 bytes. Neither
+ *   direction takes a DMA channel, so the module builds on every C0 part, the
+ *   3-channel C031 included.
+ * - In Stop mode USART1 runs from HSIKER and wakes the core on a start bit, so
+ *   an idle machine still answers its polls.
+ */
+
+
+
+ #ifndef MODBUS_H
+ #define MODBUS_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+
+ #ifndef MODBUS_ENABLE
+ #define MODBUS_ENABLE  1
+ #endif
+
+ #ifndef MODBUS_ADDRESS
+ #define MODBUS_ADDRESS  1U
+ #endif
+
+ #define MODBUS_BAUD          19200U
+
+ // Bus pins
+ #define MODBUS_GPIO_PORT     GPIOA
+ #define MODBUS_TX_PIN        GPIO_PIN_9
+ #define MODBUS_RX_PIN        GPIO_PIN_10
+ #define MODBUS_DE_PIN        GPIO_PIN_12
+
+ // Register map (one 16-bit register each)
+ typedef enum {
+     MODBUS_REG_STATE = 0,        // WasherState (washer.h)
+     MODBUS_REG_PROGRAM,          // Selected program, numbered as on the display (1-30)
+     MODBUS_REG_STEP,             // Step within the program, from 0
+     MODBUS_REG_REMAINING,        // Seconds to the step (or fill timeout) deadline
+     MODBUS_REG_TEMPERATURE,      // Water temperature, 0.1 °C, signed
+     MODBUS_REG_RPM,              // Measured drum speed
+     MODBUS_REG_LEVEL,            // Water level, percent of capacity
+     MODBUS_REG_FAULT,            // WasherFault (washer.h)
+     MODBUS_REG_REQUESTS,         // Requests to this address answered, wraps
+     MODBUS_REG_ERRORS,           // Frames dropped on a CRC, parity or framing error, wraps
+     MODBUS_REG_COUNT
+ } ModbusRegister;
+
+ #if MODBUS_ENABLE
+
+ void Modbus_Init(void);
+ uint8_t Modbus_IsBusy(void);
+ void Modbus_SetWakeup(uint8_t enable);
+
+ #else
+
+ static inline void Modbus_Init(void) {}
+ static inline uint8_t Modbus_IsBusy(void) { return 0; }
+ static inline void Modbus_SetWakeup(uint8_t enable) { (void)enable; }
+
+ #endif // MODBUS_ENABLE
+
+ #endif // MODBUS_H
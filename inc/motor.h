@@ -0,0 +1,75 @@
+/**
+ * @file motor.h
+ * @brief TIM3 PWM drum motor drive with DMA-played soft ramps.
+ *
+ * This header declares the motor driver. The inverter's forward and reverse
+ * speed inputs are driven with PWM from TIM3 (CH3 on `MOTOR_FORWARD_PIN`,
+ * CH4 on `MOTOR_REVERSE_PIN`). Speed changes are never steps: the driver
+ * plays a const S-curve ramp table into the active compare register through
+ * DMA, one sample per PWM period, so the CPU does no work while a ramp runs.
+ *
+ * Definitions:
+ * - `MotorDirection` enum: Drum rotation direction.
+ * - `MotorRamp` enum: Ramp profile (soft agitation strokes or spin acceleration).
+ * - `MOTOR_PWM_HZ`, `MOTOR_DUTY_MAX`: PWM frequency and resolution (8-bit duty).
+ * - `MOTOR_MAX_RPM`: Drum speed at full duty.
+ *
+ * Function Prototypes:
+ * - `Motor_Init()`: Configure TIM3 PWM, its update DMA channel and the pins.
+ * - `Motor_Run()`: Ramp to a direction and speed. Repeating the current request
+ *   does nothing, so it can be called every control tick.
+ * - `Motor_Stop()`: Ramp down to standstill with the last used profile.
+ * - `Motor_Off()`: Cut both outputs immediately (faults).
+ * - `Motor_SetDuty()`: Apply a duty at once, cancelling any ramp (closed-loop
+ *   speed control, speed.h). A later `Motor_Run()`/`Motor_Stop()` ramps from it.
+ *   Ignored if it would change direction while the motor turns or ramps.
+ * - `Motor_RpmToDuty()`: Open-loop duty for a drum speed.
+ * - `Motor_GetDuty()`: Duty currently applied (live compare value, also mid-ramp).
+ * - `Motor_IsRamping()`: 1 while a ramp is playing.
+ *
+ * Notes:
+ * - Direction changes go through zero: the running direction ramps down
+ *   completely before the other one ramps up.
+ * - A new request during a ramp is picked up when that ramp completes.
+ */
+
+
+
+ #ifndef MOTOR_H
+ #define MOTOR_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+
+ // PWM speed reference: 8-bit duty at 500 Hz (one ramp sample per period)
+ #define MOTOR_PWM_HZ    500U
+ #define MOTOR_DUTY_MAX  255U
+
+ // Drum speed at full duty
+ #define MOTOR_MAX_RPM   1400U
+
+ // Drum rotation direction
+ typedef enum {
+     FORWARD,
+     REVERSE
+ } MotorDirection;
+
+ typedef enum {
+     MOTOR_RAMP_SOFT = 0,  // Agitation strokes, ~0.26 s full scale
+     MOTOR_RAMP_SPIN,      // Spin acceleration and braking, ~1 s full scale
+     MOTOR_RAMP_COUNT
+ } MotorRamp;
+
+ extern TIM_HandleTypeDef htim3;
+ extern DMA_HandleTypeDef hdma_tim3_up;
+
+ void Motor_Init(void);
+ void Motor_Run(MotorDirection direction, uint16_t rpm, MotorRamp ramp);
+ void Motor_Stop(void);
+ void Motor_Off(void);
+ void Motor_SetDuty(MotorDirection direction, uint8_t duty);
+ uint8_t Motor_RpmToDuty(uint16_t rpm);
+ uint8_t Motor_GetDuty(void);
+ uint8_t Motor_IsRamping(void);
+
+ #endif // MOTOR_H
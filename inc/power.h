@@ -0,0 +1,69 @@
+/**
+ * @file power.h
+ * @brief Core clock scaling and Stop-mode sleep.
+ *
+ * This header declares the power manager. The system clock comes from HSI48
+ * and runs at one of two levels: full speed while display refreshes or spin
+ * control are pending, half speed otherwise. When the washer is IDLE and no
+ * peripheral still needs a clock, the main loop sleeps in Stop mode and wakes
+ * on the RTC second alarm, a button edge or a Modbus start bit.
+ *
+ * Definitions:
+ * - `PowerLevel` enum: `POWER_SLOW` (HSI48 / 2 = 24 MHz, no flash wait state) and
+ *   `POWER_FAST` (48 MHz, one wait state).
+ * - `POWER_PCLK_HZ`: APB clock, the same at both levels.
+ * - `POWER_TIMER_HZ`: Timer kernel clock. The APB prescaler is never 1, so the
+ *   timers run at twice PCLK.
+ * - `POWER_HOLD_MS`: Time the core stays fast after the last demand, so a burst
+ *   of refreshes does not switch the clock on every wakeup.
+ *
+ * Function Prototypes:
+ * - `Power_Init()`: Start HSI48 and run at `POWER_FAST`; called by `SystemClock_Config()`.
+ * - `Power_Update()`: Main loop, once per pass: go fast while `demand` is set or
+ *   a display refresh is pending, back to slow `POWER_HOLD_MS` after the last one.
+ * - `Power_Sleep()`: Sleep until the next interrupt. Stop mode if `idle` is set and
+ *   nothing needs a clock, WFI otherwise. Call with interrupts masked.
+ * - `Power_GetLevel()`, `Power_GetStops()`: Current level and Stop entries so far.
+ * - `Power_GetSwitchFailures()`: Run-time level switches refused by the RCC; the
+ *   core stayed at its level each time.
+ *
+ * Notes:
+ * - Each level moves the APB prescaler with SYSCLK (/4 at 48 MHz, /2 at 24 MHz), so
+ *   timers, SPI, ADC and UART keep their clocks and are configured only once.
+ *   Modules derive timer prescalers from `POWER_TIMER_HZ`, not from PCLK.
+ * - While switching, PCLK only ever dips below `POWER_PCLK_HZ`, never above.
+ * - `HAL_InitTick()` is replaced so a level change rescales SysTick from the next
+ *   millisecond on instead of restarting the current one, and the millisecond in
+ *   progress, run at the new clock, is made up in `uwTick`; `HAL_GetTick()` does
+ *   not drift with the switching.
+ * - Stop mode freezes every timer, the ADC and SysTick; `HAL_GetTick()` does not
+ *   advance while stopped. Only the RTC (LSI), EXTI and USART1 (HSIKER) keep
+ *   running.
+ */
+
+
+
+ #ifndef POWER_H
+ #define POWER_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+
+ #define POWER_PCLK_HZ    12000000U
+ #define POWER_TIMER_HZ   (2U * POWER_PCLK_HZ)
+ #define POWER_HOLD_MS    100U
+
+ typedef enum {
+     POWER_SLOW = 0,
+     POWER_FAST,
+     POWER_LEVEL_COUNT
+ } PowerLevel;
+
+ void Power_Init(void);
+ void Power_Update(uint8_t demand);
+ void Power_Sleep(uint8_t idle);
+ PowerLevel Power_GetLevel(void);
+ uint32_t Power_GetStops(void);
+ uint32_t Power_GetSwitchFailures(void);
+
+ #endif // POWER_H
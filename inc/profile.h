@@ -0,0 +1,112 @@
+/**
+ * @file profile.h
+ * @brief On-target task and interrupt latency profiler with a UART dump.
+ *
+ * This header declares the profiler. Each probe brackets one task, event
+ * handler or interrupt handler with a start timestamp and a record call; the
+ * record keeps min/max/total/count and a power-of-two histogram per probe in a
+ * static table. A long press of Stop dumps the table as text over USART2.
+ *
+ * Definitions:
+ * - `PROFILE_ENABLE`: Build flag (default 1). With 0 every probe compiles to
+ *   nothing and the module adds no code, RAM or peripherals.
+ * - `ProfileProbe` enum: Probe identifiers. Scheduler tasks use
+ *   `PROFILE_TASK(index)`, event handlers `PROFILE_EVENT(type)`.
+ * - `PROFILE_BUCKETS`: Histogram buckets; bucket 0 is below `PROFILE_BUCKET0_US`,
+ *   each next one doubles the limit, the last is open-ended.
+ * - `PROFILE_BEGIN()` / `PROFILE_END(probe)`: Probe pair for one block (same scope).
+ *
+ * Function Prototypes:
+ * - `Profile_Init()`: Clear the table.
+ * - `Profile_Now()`: Cycle clock in microseconds (16 bits, wraps every 65.5 ms).
+ * - `Profile_Record()`: Add one measurement since `start` to a probe.
+ * - `Profile_RecordUs()`: Add one measurement given in microseconds (for times
+ *   not taken with `Profile_Now()`, such as the boot times in boot.c).
+ * - `Profile_RequestDump()`: Start a dump (ignored while one is running).
+ * - `Profile_Service()`: Scheduler task; sends the dump one line at a time.
+ * - `Profile_IsBusy()`: Nonzero while a dump is pending or a line is still being sent.
+ *
+ * Notes:
+ * - The C0 has no DWT cycle counter, so the clock is the TIM1 counter, which
+ *   already free-runs at 1 MHz for the tach capture (speed.h).
+ * - Each probe must be recorded from one context only (one interrupt, or the
+ *   main loop); then the table needs no locking on the record path.
+ * - Dump output: the console (console.h), USART2 TX on PA14, interrupt driven,
+ *   so no DMA channel is needed (the 3-channel parts have none left). PA14 is
+ *   also SWCLK: the pin is only taken over at the first dump request, and the
+ *   debugger stays detached until the next reset.
+ */
+
+
+
+ #ifndef PROFILE_H
+ #define PROFILE_H
+
+ #include "stm32c0xx_hal.h"
+ #include "scheduler.h"
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ #ifndef PROFILE_ENABLE
+ #define PROFILE_ENABLE  1
+ #endif
+
+ // Histogram: <8, <16, <32, <64, <128, <256, <512, >=512 us
+ #define PROFILE_BUCKETS         8
+ #define PROFILE_BUCKET0_US      8U
+
+ typedef enum {
+     PROFILE_LOOP = 0,            // Main loop, wakeup to sleep
+     PROFILE_ISR_TACH,            // TIM1 capture (speed.c)
+     PROFILE_ISR_ADC,             // DMA1 ch1, ADC filter stage (adc.c)
+     PROFILE_ISR_DMA2_3,          // DMA1 ch2/3, SPI flush and motor ramp (main.c)
+     PROFILE_ISR_SPI,             // SPI1 (spi.c)
+     PROFILE_ISR_STEP_TIMER,      // TIM14 (steptimer.c)
+     PROFILE_ISR_TICK,            // TIM16 scheduler tick (main.c)
+     PROFILE_ISR_BUTTON,          // TIM17 debouncer (button.c)
+     PROFILE_ISR_RTC,             // RTC alarm (rtc.c)
+     PROFILE_ISR_MODBUS,          // USART1, Modbus framing and replies (modbus.c)
+     PROFILE_BOOT_SAFE,           // HAL_Init() to safe outputs and live buttons (boot.c)
+     PROFILE_BOOT_READY,          // HAL_Init() to every boot stage finished (boot.c)
+     PROFILE_EVENT_STEP_TIMER,    // Event handlers, in EventType order (event.h)
+     PROFILE_EVENT_BUTTON,
+     PROFILE_EVENT_CLOCK,         // Deferred clock redraw (main.c)
+     PROFILE_TASK_FIRST,          // Scheduler tasks follow, in table order
+     PROFILE_PROBE_COUNT = PROFILE_TASK_FIRST + SCHEDULER_MAX_TASKS
+ } ProfileProbe;
+
+ #define PROFILE_TASK(index)     ((ProfileProbe)(PROFILE_TASK_FIRST + (index)))
+ #define PROFILE_EVENT(type)     ((ProfileProbe)(PROFILE_EVENT_STEP_TIMER + (type) - 1))
+
+ #if PROFILE_ENABLE
+
+ #define PROFILE_BEGIN()         uint16_t profileStart = Profile_Now()
+ #define PROFILE_END(probe)      Profile_Record((probe), profileStart)
+
+ static inline uint16_t Profile_Now(void) {
+     return (uint16_t)TIM1->CNT;
+ }
+
+ void Profile_Init(void);
+ RAMFUNC void Profile_Record(ProfileProbe probe, uint16_t start);
+ RAMFUNC void Profile_RecordUs(ProfileProbe probe, uint16_t elapsed);
+ void Profile_RequestDump(void);
+ void Profile_Service(void);
+ uint8_t Profile_IsBusy(void);
+
+ #else
+
+ #define PROFILE_BEGIN()         do { } while (0)
+ #define PROFILE_END(probe)      do { } while (0)
+
+ static inline uint16_t Profile_Now(void) { return 0; }
+ static inline void Profile_Init(void) {}
+ static inline void Profile_Record(ProfileProbe probe, uint16_t start) { (void)probe; (void)start; }
+ static inline void Profile_RecordUs(ProfileProbe probe, uint16_t elapsed) { (void)probe; (void)elapsed; }
+ static inline void Profile_RequestDump(void) {}
+ static inline void Profile_Service(void) {}
+ static inline uint8_t Profile_IsBusy(void) { return 0; }
+
+ #endif // PROFILE_ENABLE
+
+ #endif // PROFILE_H
@@ -0,0 +1,77 @@
+/**
+ * @file program.h
+ * @brief Wash program table: 30 const program descriptors kept in flash.
+ *
+ * This header declares the wash programs run by the washer state machine.
+ * A program is a list of steps; each step fills the drum (optionally), then
+ * runs its wash, rinse or spin phase for a fixed time. The tables are const
+ * and never copied to RAM, so adding a program or a step costs flash only.
+ *
+ * Definitions:
+ * - `AgitationPattern` enum: Drum motion while a wash or rinse step runs.
+ * - `AgitationTiming` struct: Run and pause seconds and drum speed of one pattern;
+ *   the drum turns forward, pauses, turns in reverse, pauses, and repeats.
+ * - `ProgramStep` struct: One step (state shown, fill level, water temperature,
+ *   agitation pattern, duration, spin speed).
+ * - `WashProgram` struct: Pointer to a step list and its length.
+ * - `PROGRAM_COUNT`: Number of selectable programs (shown as 01-30).
+ *
+ * Function Prototypes:
+ * - `Program_GetStep()`: Step `stepIndex` of program `programIndex`, or NULL
+ *   past the last step (or for an invalid program). Constant time.
+ * - `Program_GetAgitation()`: Timing of an agitation pattern.
+ *
+ * Notes:
+ * - `temperature` is in 0.1 °C (see `TEMP_DECI()` in adc.h); `PROGRAM_TEMP_COLD`
+ *   selects the cold valve only.
+ * - `fillLevel` is a percentage of the drum capacity; 0 means the step does not fill.
+ * - `spinRpm` is only used by SPIN steps; 0 means the drum stays still.
+ */
+
+
+
+ #ifndef PROGRAM_H
+ #define PROGRAM_H
+
+ #include <stdint.h>
+ #include "washer.h"
+
+ #define PROGRAM_COUNT      30
+
+ // Target temperature meaning "cold water only"
+ #define PROGRAM_TEMP_COLD  0
+
+ typedef enum {
+     AGITATE_NONE = 0,
+     AGITATE_GENTLE,
+     AGITATE_NORMAL,
+     AGITATE_HEAVY,
+     AGITATE_PATTERN_COUNT
+ } AgitationPattern;
+
+ typedef struct {
+     uint8_t runSeconds;    // Per direction, 0 = drum stays still
+     uint8_t pauseSeconds;  // Between direction changes
+     uint8_t rpm;           // Drum speed while turning
+ } AgitationTiming;
+
+ typedef struct {
+     uint8_t state;          // WasherState shown while the step runs (WASH, RINSE or SPIN)
+     uint8_t fillLevel;      // Water level target in percent, 0 = no fill
+     int16_t temperature;    // Water temperature target in 0.1 °C
+     uint8_t agitation;      // AgitationPattern
+     uint16_t durationSeconds;
+     uint16_t spinRpm;
+ } ProgramStep;
+
+ typedef struct {
+     const ProgramStep *steps;
+     uint8_t stepCount;
+ } WashProgram;
+
+ extern const WashProgram programTable[PROGRAM_COUNT];
+
+ const ProgramStep *Program_GetStep(int programIndex, int stepIndex);
+ const AgitationTiming *Program_GetAgitation(uint8_t pattern);
+
+ #endif // PROGRAM_H
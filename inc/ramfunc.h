@@ -0,0 +1,59 @@
+/**
+ * @file ramfunc.h
+ * @brief Placement of the interrupt paths, the event ring and the glyph blitter in SRAM.
+ *
+ * This header defines the function attribute that selects where the hot code
+ * runs from. Above 24 MHz the C0 flash needs a wait state, and every fetch of
+ * an interrupt handler or inner loop pays it; code copied to SRAM does not.
+ *
+ * Definitions:
+ * - `RAMFUNC_ENABLE`: Build flag (default 0). 0 is the size profile: everything
+ *   runs from flash. 1 is the speed profile: every `RAMFUNC` function is linked
+ *   into SRAM.
+ * - `RAMFUNC`: Function attribute; put it on the prototype and on the definition.
+ *
+ * Marked functions:
+ * - The timer, ADC DMA, SPI and SPI/motor DMA interrupt handlers, the HAL
+ *   callbacks they reach in main.c, adc.c and spi.c, and the module code those
+ *   call (tach capture and balance bins, step deadline, scheduler tick, button
+ *   scan, ADC filter kernels, SPI region chaining, motor ramp completion, the
+ *   profiler record).
+ * - `Event_Post()` and `Event_Get()`, the event ring.
+ * - `Display_BlitGlyph()` and its dirty-range update, the framebuffer blitter.
+ *
+ * Build profiles (target/Makefile, `PROFILE=size` or `PROFILE=speed`):
+ * - Size: `-Os -ffunction-sections -fdata-sections -Wl,--gc-sections`, `RAMFUNC_ENABLE` 0.
+ * - Speed: `-O2 -flto -ffunction-sections -fdata-sections -Wl,--gc-sections -DRAMFUNC_ENABLE=1`.
+ * - Both link with `-Wl,-Map=`; `make -C target map` runs `tools/map_report.py`
+ *   on the profile's map for flash and RAM use per module.
+ * - The host simulator builds with `RAMFUNC_ENABLE` 0.
+ *
+ * Notes:
+ * - `.RamFunc` is the section the STM32Cube linker scripts already copy from
+ *   flash to SRAM together with `.data`, so the linker script needs no change.
+ *   Each marked function then costs its size twice: in flash (load image) and in RAM.
+ * - Flash and SRAM are further apart than a Thumb BL reaches; `long_call` makes
+ *   callers that see the prototype load the address instead. Calls made from
+ *   the HAL (the callbacks) go through linker veneers in flash.
+ * - The HAL drivers the handlers call (`HAL_TIM_IRQHandler()`, `HAL_DMA_IRQHandler()`,
+ *   ...) and the font table stay in flash.
+ * - Data needs no marking: the event rings, queues and framebuffer are in SRAM already.
+ * - `noinline` keeps a marked function from being copied into a flash caller.
+ */
+
+
+
+ #ifndef RAMFUNC_H
+ #define RAMFUNC_H
+
+ #ifndef RAMFUNC_ENABLE
+ #define RAMFUNC_ENABLE  0
+ #endif
+
+ #if RAMFUNC_ENABLE
+ #define RAMFUNC  __attribute__((section(".RamFunc"), long_call, noinline))
+ #else
+ #define RAMFUNC
+ #endif
+
+ #endif // RAMFUNC_H
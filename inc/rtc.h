@@ -2,15 +2,24 @@
  * @file rtc.h
  * @brief Header file for Real-Time Clock (RTC) management.
  *
- * This file declares the external RTC handle and provides the prototype
- * for initializing the RTC peripheral.
+ * This file declares the external RTC handle, the RTC initialization and
+ * the interrupt-maintained time of day used by the clock display.
  *
  * Functionality:
  * - Defines the external `RTC_HandleTypeDef` used across the system.
  * - Declares `MX_RTC_Init()` function for setting up the RTC hardware.
+ * - Declares `RTC_StartClock()` and `RTC_ClockReady()`, which start the LSI the RTC
+ *   runs from and report when it is stable, so the boot does not wait on it (boot.h).
+ * - Declares `RTC_GetClock()`, which returns the time of day the 1 Hz RTC
+ *   interrupt last read from the calendar, as one packed word (no HAL calls, no
+ *   shadow register wait).
+ * - `RTC_CLOCK_HOURS()`, `RTC_CLOCK_MINUTES()`, `RTC_CLOCK_SECONDS()` unpack it.
  *
  * Notes:
- * - `MX_RTC_Init()` must be called during system initialization to configure the RTC.
+ * - `MX_RTC_Init()` must be called during system initialization to configure the RTC,
+ *   once `RTC_ClockReady()` reports the LSI running.
+ * - Each second the RTC interrupt re-reads the calendar and posts `EVENT_CLOCK`
+ *   (event.h), so the clock is redrawn when it changes instead of being polled.
  * - Supports both C and C++ compilation by wrapping in `extern "C"`.
  *
  * Dependencies:
@@ -18,7 +27,8 @@
  *
  * Usage:
  * - Call `MX_RTC_Init()` once at startup.
- * - Use `hrtc` handle to access HAL RTC functions throughout the project.
+ * - Use `RTC_GetClock()` to read the time; use `hrtc` only for setting it. A new
+ *   time shows from the next second's interrupt.
  */
 
 
@@ -34,7 +44,15 @@
  
  extern RTC_HandleTypeDef hrtc;
  
+ // Packed time of day: hours << 16 | minutes << 8 | seconds
+ #define RTC_CLOCK_HOURS(clock)    ((uint8_t)((clock) >> 16))
+ #define RTC_CLOCK_MINUTES(clock)  ((uint8_t)((clock) >> 8))
+ #define RTC_CLOCK_SECONDS(clock)  ((uint8_t)(clock))
+ 
+ void RTC_StartClock(void);
+ uint8_t RTC_ClockReady(void);
  void MX_RTC_Init(void);
+ uint32_t RTC_GetClock(void);
  
  #ifdef __cplusplus
  }
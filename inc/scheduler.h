@@ -0,0 +1,77 @@
+/**
+ * @file scheduler.h
+ * @brief Static cooperative tick scheduler for the periodic firmware tasks.
+ *
+ * This header declares a small run-to-completion scheduler. The application
+ * supplies a const task table (in flash); each entry has its own period, and
+ * its position in the table is its priority (index 0 runs first).
+ *
+ * Definitions:
+ * - `SchedulerTask` struct: Task function, period and deadline in scheduler ticks,
+ *   load class, run-time budget and name.
+ * - `SchedulerClass` enum: `SCHEDULER_CRITICAL` tasks always run when released;
+ *   `SCHEDULER_SHEDDABLE` tasks only run if no critical task is due within their
+ *   budget, and are skipped once they are past their own deadline.
+ * - `SCHEDULER_MAX_TASKS`: Capacity of the per-task RAM state (no heap).
+ * - `SCHEDULER_TICK_MS`: Scheduler tick period, generated by TIM16 (main.c).
+ *
+ * Function Prototypes:
+ * - `Scheduler_Init()`: Register the task table.
+ * - `Scheduler_Tick()`: Called from the tick interrupt; releases due tasks.
+ * - `Scheduler_RunNext()`: Called from the main loop; runs the highest-priority
+ *   released task and returns 1, or returns 0 if nothing is ready.
+ * - `Scheduler_Pending()`: Non-destructive check used before entering sleep.
+ * - `Scheduler_GetName()`: Name of the task at a table index (NULL past the end).
+ * - `Scheduler_HasRoom()`: 1 if work of `budgetTicks` can run now without delaying
+ *   a critical task; for cosmetic work outside the table (e.g. the clock redraw).
+ * - `Scheduler_GetMisses()` / `Scheduler_GetSheds()`: Per-task counters of runs
+ *   that finished past the deadline, and of releases skipped by load shedding.
+ *
+ * Notes:
+ * - Tasks never preempt each other; keep each one short.
+ * - `periodTicks` must be at least 1.
+ * - If a task is released again before it ran, the extra release is merged
+ *   (the task runs once, it does not try to catch up) and counts as a miss.
+ * - `deadlineTicks` is measured from the release to the end of the run.
+ */
+
+
+
+ #ifndef SCHEDULER_H
+ #define SCHEDULER_H
+
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ #define SCHEDULER_MAX_TASKS  8
+ #define SCHEDULER_TICK_MS    1U
+
+ // Milliseconds to scheduler ticks
+ #define SCHEDULER_MS(ms)     ((uint16_t)((ms) / SCHEDULER_TICK_MS))
+
+ typedef void (*TaskFunction)(void);
+
+ typedef enum {
+     SCHEDULER_CRITICAL = 0,
+     SCHEDULER_SHEDDABLE
+ } SchedulerClass;
+
+ typedef struct {
+     TaskFunction run;
+     uint16_t periodTicks;
+     uint16_t deadlineTicks;  // Release to completion; later counts as a miss
+     uint8_t loadClass;       // SchedulerClass
+     uint8_t budgetTicks;     // Worst-case run time (sheddable tasks only)
+     const char *name;
+ } SchedulerTask;
+
+ void Scheduler_Init(const SchedulerTask *table, uint8_t count);
+ RAMFUNC void Scheduler_Tick(void);
+ uint8_t Scheduler_RunNext(void);
+ uint8_t Scheduler_Pending(void);
+ const char *Scheduler_GetName(uint8_t index);
+ uint8_t Scheduler_HasRoom(uint8_t budgetTicks);
+ uint16_t Scheduler_GetMisses(uint8_t index);
+ uint16_t Scheduler_GetSheds(uint8_t index);
+
+ #endif // SCHEDULER_H
@@ -0,0 +1,67 @@
+/**
+ * @file speed.h
+ * @brief Drum tachometer capture and closed-loop spin speed control.
+ *
+ * This header declares the speed module. The motor tachometer drives TIM1 CH4
+ * input capture; the capture interrupt turns each pulse period into rpm with
+ * one integer division. A fixed-rate PI loop (the scheduler's speed task)
+ * then drives the motor PWM so the drum tracks a spin target.
+ *
+ * Definitions:
+ * - `TACH_PULSES_PER_REV`: Tach pulses per drum revolution (motor poles x belt ratio).
+ * - `SPEED_ACCEL_RPM_PER_S`: Rate at which the setpoint approaches the target.
+ * - `SPEED_KP_Q8`, `SPEED_KI_Q8`: PI gains in duty units per rpm, Q8 fixed point.
+ *
+ * Function Prototypes:
+ * - `Speed_Init()`: Configure TIM1 as a 1 MHz free-running capture timer.
+ * - `Speed_GetRpm()`: Latest measured drum speed (0 when no pulses arrive).
+ * - `Speed_SetTarget()`: Take over the motor and hold `rpm` forward; 0 releases
+ *   the motor (the caller then stops it, e.g. with `Motor_Stop()`).
+ * - `Speed_Hold()`: Stop accelerating: the target becomes the current setpoint.
+ * - `Speed_AtTarget()`: 1 once the measured speed is within the tolerance band.
+ * - `Speed_GetTarget()`: Current target (after `Speed_Hold()`, the held speed).
+ * - `Speed_Control()`: One PI iteration; run every `SPEED_PERIOD_MS` (main.h).
+ * - `Speed_Capture()` / `Speed_Overflow()`: Called from the TIM1 capture and
+ *   update interrupts.
+ *
+ * Notes:
+ * - Tach input: PA11 (TIM1_CH4, AF2).
+ * - The loop output includes a feed-forward term from the open-loop duty curve,
+ *   so the PI part only corrects load and supply variation.
+ */
+
+
+
+ #ifndef SPEED_H
+ #define SPEED_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ // Tachometer input
+ #define TACH_GPIO_PORT          GPIOA
+ #define TACH_PIN                GPIO_PIN_11
+ #define TACH_PULSES_PER_REV     16U
+
+ // Setpoint slew and PI gains (duty per rpm, Q8)
+ #define SPEED_ACCEL_RPM_PER_S   300U
+ #define SPEED_KP_Q8             12
+ #define SPEED_KI_Q8             3
+
+ // |measured - target| counted as "at speed"
+ #define SPEED_TOLERANCE_RPM     30
+
+ extern TIM_HandleTypeDef htim1;
+
+ void Speed_Init(void);
+ uint16_t Speed_GetRpm(void);
+ void Speed_SetTarget(uint16_t rpm);
+ void Speed_Hold(void);
+ uint16_t Speed_GetTarget(void);
+ uint8_t Speed_AtTarget(void);
+ void Speed_Control(void);
+ RAMFUNC void Speed_Capture(void);
+ RAMFUNC void Speed_Overflow(void);
+
+ #endif // SPEED_H
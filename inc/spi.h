@@ -6,15 +6,33 @@
  * along with GPIO pin configuration for the display chip select (CS) line.
  *
  * Functionality:
- * - `SPI_Init()` initializes the SPI peripheral for communication.
+ * - `SPI_Init()` initializes SPI1, its TX DMA channel and the CS/D/C pins.
  * - `SPI_SendCommand(uint8_t cmd)` sends a command byte to the display.
  * - `SPI_SendData(uint8_t data)` sends a data byte to the display.
  * - `SPI_DisplayClear()` clears the entire display buffer.
- * - `SPI_WriteString(uint8_t row, uint8_t col, const char *text)` writes a string at the specified row and column.
+ * - `SPI_WriteString(uint8_t page, uint8_t col, const char *text)` draws text directly on the panel
+ *   (bypassing the framebuffer): one address burst, then each glyph streamed from the font in
+ *   flash with no intermediate buffer. Returns the number of characters that fit on the line.
+ * - `SPI_WriteRegion(uint8_t page, uint8_t col, const uint8_t *data, uint16_t len)` sets the controller's
+ *   page/column address and streams `len` column bytes in one CS-asserted burst (framebuffer flush).
  * - `SPI_CheckStatus()` returns the SPI status via HAL.
  *
+ * Asynchronous Transmit:
+ * - `SPI_QueueRegion(page, col, data, len)` queues the same region transfer as `SPI_WriteRegion()`
+ *   and returns immediately. Transfers run back to back on DMA: the completion callback
+ *   deasserts CS and starts the next queued transfer, so the CPU never waits on the panel.
+ * - `data` must stay valid until the transfer completes (the framebuffer does).
+ * - `SPI_IsBusy()` reports whether queued transfers are still in flight; the blocking
+ *   functions above wait for the queue to drain before using the bus.
+ * - `SPI_QUEUE_SIZE` regions can be queued (one per display page).
+ *
  * Display Control:
+ * - SPI1 SCK/MOSI are on PA5/PA7 (AF0); MISO (PA6) is not used and carries the
+ *   temperature sensor (adc.h). PA0-PA3 are the buttons.
  * - `DISPLAY_CS_GPIO_Port` and `DISPLAY_CS_Pin` define the chip select pin used to initiate communication with the display.
+ * - `DISPLAY_DC_GPIO_Port` and `DISPLAY_DC_Pin` select command (low) or data (high) bytes.
+ * - `DISPLAY_CMD_*` are the page-addressing and clear commands of the panel controller;
+ *   `DISPLAY_CLEAR_MS` is how long the controller takes to execute a clear.
  *
  * Dependencies:
  * - Requires STM32 HAL (`stm32c0xx_hal.h`).
@@ -37,14 +55,42 @@
  // Define SPI-related GPIO pins
  #define DISPLAY_CS_GPIO_Port GPIOB
  #define DISPLAY_CS_Pin GPIO_PIN_6
+ #define DISPLAY_DC_GPIO_Port GPIOB
+ #define DISPLAY_DC_Pin GPIO_PIN_7
+ 
+ // SPI1 bus pins
+ #define DISPLAY_SPI_GPIO_Port GPIOA
+ #define DISPLAY_SCK_Pin GPIO_PIN_5
+ #define DISPLAY_MOSI_Pin GPIO_PIN_7
+ 
+ // Queued region transfers (power of two)
+ #define SPI_QUEUE_SIZE 8
+ 
+ // Panel controller page addressing commands
+ #define DISPLAY_CMD_SET_PAGE      0xB0  // | page (0-7)
+ #define DISPLAY_CMD_SET_COL_HIGH  0x10  // | column bits 7-4
+ #define DISPLAY_CMD_SET_COL_LOW   0x00  // | column bits 3-0
+ #define DISPLAY_CMD_CLEAR         0x01  // Clear display (depends on display controller)
+ #define DISPLAY_CLEAR_MS          2U
+ 
+ // Panel columns per page (text written past the last column is clipped)
+ #define DISPLAY_PANEL_COLUMNS     128
  
  // SPI communication functions
  void SPI_Init();
  void SPI_SendCommand(uint8_t cmd);
  void SPI_SendData(uint8_t data);
  void SPI_DisplayClear();
- void SPI_WriteString(uint8_t row, uint8_t col, const char *text);
+ uint8_t SPI_WriteString(uint8_t page, uint8_t col, const char *text);
+ void SPI_WriteRegion(uint8_t page, uint8_t col, const uint8_t *data, uint16_t len);
  HAL_StatusTypeDef SPI_CheckStatus();
  
+ // Asynchronous DMA transmit path
+ uint8_t SPI_QueueRegion(uint8_t page, uint8_t col, const uint8_t *data, uint16_t len);
+ uint8_t SPI_IsBusy(void);
+ 
+ extern SPI_HandleTypeDef hspi1;
+ extern DMA_HandleTypeDef hdma_spi1_tx;
+ 
  #endif // SPI_H
  
\ No newline at end of file
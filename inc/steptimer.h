@@ -0,0 +1,54 @@
+/**
+ * @file steptimer.h
+ * @brief TIM14 one-pulse deadline timer for timed wash step phases.
+ *
+ * This header declares the step timer used by the washer state machine for
+ * its timed phases (filling, and each wash, rinse or spin step). TIM14 runs
+ * in one-pulse mode and interrupts exactly at the deadline, independently of
+ * how often the control task runs.
+ *
+ * Definitions:
+ * - `STEP_TIMER_CLOSE_VALVES`: Flag for `StepTimer_Start()`; the interrupt closes
+ *   both water valves itself at the deadline, so dosing does not wait for the
+ *   main loop.
+ * - `STEP_TIMER_TICKS_PER_MS`: TIM14 count rate.
+ *
+ * Function Prototypes:
+ * - `StepTimer_Init()`: Configure TIM14 (stopped).
+ * - `StepTimer_Start()`: Arm a deadline `ms` from now, replacing any running one.
+ * - `StepTimer_Cancel()`: Stop the running deadline; no event will be delivered.
+ * - `StepTimer_Running()`: 1 while a deadline is armed and has not expired.
+ * - `StepTimer_IsCurrent()`: Check that an `EVENT_STEP_TIMER` belongs to the latest
+ *   `StepTimer_Start()` (a restart or cancel makes older events stale).
+ * - `StepTimer_Elapsed()`: Called from the TIM14 update interrupt.
+ *
+ * Notes:
+ * - At the deadline `EVENT_STEP_TIMER` is posted with the deadline's sequence
+ *   number as `param`.
+ * - Deadlines longer than the 16-bit counter range are split into several pulses.
+ * - A deadline of 0 ms expires after 1 ms, from the interrupt like any other.
+ */
+
+
+
+ #ifndef STEPTIMER_H
+ #define STEPTIMER_H
+
+ #include "stm32c0xx_hal.h"
+ #include <stdint.h>
+ #include "ramfunc.h"
+
+ // StepTimer_Start() flags
+ #define STEP_TIMER_CLOSE_VALVES  0x01
+
+ // 2 kHz count clock, so even a 1 ms pulse has an auto-reload value above 0
+ #define STEP_TIMER_TICKS_PER_MS  2U
+
+ void StepTimer_Init(void);
+ void StepTimer_Start(uint32_t ms, uint8_t flags);
+ void StepTimer_Cancel(void);
+ uint8_t StepTimer_Running(void);
+ uint8_t StepTimer_IsCurrent(uint8_t eventSequence);
+ RAMFUNC void StepTimer_Elapsed(void);
+
+ #endif // STEPTIMER_H
@@ -8,35 +8,46 @@
  *
  * Definitions:
  * - `WasherState` enum: Enumerates all washer operation states such as IDLE,
- *   FILL_WATER, WASH, RINSE, SPIN, and DONE.
+ *   FILL_WATER, WASH, RINSE, SPIN, DONE and WASHER_ERROR.
+ * - `WasherFault` enum: Why the washer last went to WASHER_ERROR; kept until the
+ *   next cycle starts.
+ * - `WasherStatus` struct: Consistent copy of the washer's state for readers outside
+ *   the control path (display, telemetry).
  * - `WasherControl` struct: Holds state information for a washer program, including:
  *   - current state
- *   - selected program index
- *   - individual timers for motor, fill, and spin phases
+ *   - selected program index and current step within the program (`program.h`)
+ *   - step start time, motor direction and the agitation cycle position
+ *   - spin phase and redistribution count (unbalance handling)
+ *   - whether the fill has reached its water level
+ *   - step time to skip after a power-cut resume, and the last journal checkpoint
+ *   - the fault code
  *
  * Note:
- * - Replace `GPIO_PIN_X` and `GPIO_PIN_Y` with actual pin assignments in `main.h`.
- * - This module interacts with GPIO and should be synchronized with HAL or LL drivers.
+ * - Pin assignments for valves and motor live in `main.h`.
+ * - Button identifiers and actions (`WasherButton`, `ButtonAction`) come from `button.h`.
+ * - `MotorDirection` comes from `motor.h`.
+ * - The error state is named `WASHER_ERROR` because the CMSIS device header
+ *   already defines `ERROR` (ErrorStatus).
  *
  * Function Prototypes:
- * - `updateWasher()`: Call this regularly to advance the washer through its steps
- *   based on timers, inputs, and temperature conditions.
+ * - `Washer_Init()`: Reset the control structure to IDLE and refresh the display.
+ * - `Washer_Resume()`: Resume the cycle the journal (`journal.h`) shows as cut by a
+ *   power loss. Call once the boot stages are done (`boot.h`).
+ * - `Washer_Update()`: Call this regularly to advance the washer through the steps
+ *   of the selected program based on timers, inputs, and temperature conditions.
+ * - `Washer_HandleStepTimer()`: Apply a step timer deadline (`EVENT_STEP_TIMER`).
+ * - `Washer_HandleButtonPress()`: Apply one debounced button event to the state machine.
+ * - `Washer_GetStatus()`: Copy the last published `WasherStatus`; never blocks the writer.
  */
 
-//Also, consider these two suggestions to improve washer.h:
-//You may want to remove WATER_HOT_PIN, WATER_COLD_PIN, and WATER_GPIO_PORT from this header — they’re better placed and centralized in main.h, which already has them.
-//Rename the prototype updateWasher() to Washer_Update() to match the implementation and be consistent with the rest of your naming.
-
 
 
 #ifndef WASHER_H
 #define WASHER_H
 
 #include "main.h"
-
-#define WATER_HOT_PIN   GPIO_PIN_X  // Replace X with actual pin
-#define WATER_COLD_PIN  GPIO_PIN_Y  // Replace Y with actual pin
-#define WATER_GPIO_PORT GPIOB       // Adjust based on actual wiring
+#include "button.h"
+#include "motor.h"
 
 // Washer States
 typedef enum {
@@ -45,19 +56,52 @@ typedef enum {
     WASH,
     RINSE,
     SPIN,
-    DONE
+    DONE,
+    WASHER_ERROR
 } WasherState;
 
+// Fault codes (values are part of the telemetry register map, modbus.h)
+typedef enum {
+    WASHER_FAULT_NONE = 0,
+    WASHER_FAULT_FILL_TIMEOUT,  // Water level not reached within WASHER_FILL_TIMEOUT_MS
+    WASHER_FAULT_PROGRAM        // Step missing from the program table, or an unknown state
+} WasherFault;
+
 // Washer Control Structure
 typedef struct {
     WasherState state;
     int programIndex;
-    int motorTimer;
-    int fillTimer;
-    int spinTimer;
+    int stepIndex;
+    uint32_t timer;          // HAL_GetTick() when the current state was entered
+    MotorDirection direction;
+    uint8_t agitationPhase;  // 0 forward, 1 pause, 2 reverse, 3 pause
+    uint32_t phaseTimer;     // HAL_GetTick() when the agitation, spin or fill settle phase began
+    uint8_t spinPhase;       // 0 ramp, 1 hold, 2 redistribute (balance.h verdicts), 3 settle
+    uint8_t spinAttempts;    // Redistributions in the current spin step
+    uint8_t levelReached;    // Fill level at target, settling since phaseTimer
+    uint32_t resumeMs;       // Step time run before a power cut, skipped when the step runs
+    uint32_t journalTimer;   // HAL_GetTick() of the last journal checkpoint
+    WasherFault fault;       // Reason for the last WASHER_ERROR
 } WasherControl;
 
+// Read-only snapshot for the display and telemetry (Washer_GetStatus)
+typedef struct {
+    WasherState state;
+    uint8_t programIndex;
+    uint8_t stepIndex;
+    uint16_t remainingSeconds;  // Until the step (or fill timeout) deadline, 0 when not running
+    int16_t temperature;        // 0.1 °C
+    uint16_t rpm;               // Measured drum speed
+    uint8_t waterLevel;         // Percent of capacity
+    uint8_t fault;              // WasherFault
+} WasherStatus;
+
 // Function Prototypes
-void updateWasher(WasherControl *washer);
+void Washer_Init(WasherControl *washer);
+void Washer_Resume(WasherControl *washer);
+void Washer_Update(WasherControl *washer);
+void Washer_HandleStepTimer(WasherControl *washer, uint8_t sequence);
+void Washer_GetStatus(WasherStatus *status);
+void Washer_HandleButtonPress(WasherControl *washer, int button, ButtonAction action);
 
 #endif // WASHER_H
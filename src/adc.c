@@ -1,39 +1,333 @@
 /**
  * @file adc.c
- * @brief ADC temperature reading implementation for STM32C0 series.
+ * @brief ADC scan group implementation for STM32C0 series.
  *
- * This source file implements the function declared in adc.h for reading
- * a temperature value from the ADC peripheral (hadc1). The process includes:
- * - Starting an ADC conversion.
- * - Waiting for the conversion to complete.
- * - Reading the raw ADC value.
- * - Stopping the ADC.
- * - Converting the raw ADC value into a temperature (in degrees) using
- *   a simple linear formula.
+ * This source file implements the functions declared in adc.h for reading
+ * temperature, water level and motor current from the ADC peripheral (hadc1).
+ * The process includes:
+ * - Configuring every member of the scan group from a const channel table and
+ *   running hadc1 in continuous scan mode, so one trigger converts the whole
+ *   channel list as a single hardware sequence.
+ * - DMA1 Channel 1 copying every result into a circular buffer of interleaved
+ *   sequences (no CPU work per conversion).
+ * - Oversampling every conversion 16x in hardware (ADC_OVERSAMPLE_BITS extra
+ *   bits), then running each channel through the filter stage in the DMA
+ *   half/full-transfer callbacks: mean of the half buffer, median-of-N spike
+ *   rejection and an integer IIR low-pass (see filter.h).
+ * - Publishing the results, then raising the "sample set ready" flag and
+ *   invoking the registered callback.
+ * - ADC_GetLatest() reading a channel's newest conversion straight from the
+ *   DMA buffer, found from the DMA counter, for consumers that need every
+ *   scan sequence rather than the filtered value of each half buffer.
+ * - ADC_Process() (sensor task) consuming the ready flag and caching the
+ *   converted temperature and water level, so Read_Temperature() and
+ *   Read_WaterLevel() are plain loads.
+ * - Restarting the conversion stream from the error callback if the ADC or
+ *   DMA faults (e.g. overrun), so readers never wait on the hardware.
+ * - Converting the latest raw temperature value into 0.1 °C with a const
+ *   calibration table and integer linear interpolation (no floating point,
+ *   no division: table points are spaced 2^TEMP_CAL_SHIFT raw counts apart).
  *
- * The current conversion assumes a 12-bit ADC resolution (0-4095 range) 
- * and maps the value proportionally to a 0-100°C temperature scale.
- * Adjust the conversion formula based on the actual sensor characteristics.
+ * The default table assumes a 12-bit ADC resolution (0-4095 range) and
+ * maps the value proportionally to a 0-100°C temperature scale.
+ * Boards with a different sensor or divider supply their own table through
+ * ADC_SetTemperatureCalibration().
  *
  * Dependencies:
- * - adc.h (for function prototype and external ADC handle)
- * - stm32c0xx_hal.h (for HAL ADC functions)
+ * - adc.h (for function prototypes, channel definitions and external ADC handle)
+ * - filter.h (for the median and IIR filter stages)
+ * - main.h (for `Error_Handler()` and the button pins the scan pins must avoid)
+ * - stm32c0xx_hal.h (for HAL ADC and DMA functions)
+ * - profile.h (for the `PROFILE_ISR_ADC` interrupt probe)
+ * - ramfunc.h (for the SRAM placement of the DMA interrupt path)
  *
  * Usage:
- * Call Read_Temperature() to get the current temperature reading as a float.
+ * Call ADC_Init() once at startup, and ADC_Start() once the rest of the safe
+ * state is set up; the first readings follow one half buffer later.
+ * Call ADC_GetRaw() for any scan group member, or Read_Temperature() to get the
+ * current temperature reading in 0.1 °C.
 **/
 
 
 #include "adc.h"
+#include "filter.h"
+#include "main.h"
+#include "profile.h"
+#include "ramfunc.h"
 
-// Function to read temperature from ADC
-float Read_Temperature(void) {
-    HAL_ADC_Start(&hadc1);
-    HAL_ADC_PollForConversion(&hadc1, HAL_MAX_DELAY);
-    uint32_t adcValue = HAL_ADC_GetValue(&hadc1);
-    HAL_ADC_Stop(&hadc1);
+// One entry per scan group member, indexed by ADC_ScanChannel
+typedef struct {
+    uint32_t channel;
+    uint32_t rank;
+    GPIO_TypeDef *port;
+    uint16_t pin;
+} ADC_ScanEntry;
 
-    // Convert ADC value to temperature (example linear conversion)
-    float temperature = (adcValue / 4095.0) * 100.0; // Adjust as needed
-    return temperature;
+static const ADC_ScanEntry adcScanTable[ADC_SCAN_CHANNEL_COUNT] = {
+    [ADC_CH_TEMPERATURE]   = {TEMP_SENSOR_ADC_CHANNEL,   ADC_REGULAR_RANK_1, TEMP_SENSOR_PORT,   TEMP_SENSOR_PIN},
+    [ADC_CH_WATER_LEVEL]   = {WATER_LEVEL_ADC_CHANNEL,   ADC_REGULAR_RANK_2, WATER_LEVEL_PORT,   WATER_LEVEL_PIN},
+    [ADC_CH_MOTOR_CURRENT] = {MOTOR_CURRENT_ADC_CHANNEL, ADC_REGULAR_RANK_3, MOTOR_CURRENT_PORT, MOTOR_CURRENT_PIN},
+};
+
+// ADC_Init() switches the scan pins to analog, which would take a button's pull-up and
+// EXTI line with it. Pin numbers are compared regardless of port, which errs on the safe side.
+_Static_assert(((TEMP_SENSOR_PIN | WATER_LEVEL_PIN | MOTOR_CURRENT_PIN) &
+                (BUTTON_START_PIN | BUTTON_STOP_PIN | BUTTON_UP_PIN | BUTTON_DOWN_PIN)) == 0,
+               "adc.c: an ADC scan pin is also a button pin");
+
+ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
+
+// Circular DMA destination of interleaved sequences; each half is filtered while the other is filled
+static uint16_t adcDmaBuffer[ADC_DMA_BUFFER_LEN];
+static volatile uint16_t adcFiltered[ADC_SCAN_CHANNEL_COUNT];
+static MedianFilter adcMedian[ADC_SCAN_CHANNEL_COUNT];
+static IirFilter adcIir[ADC_SCAN_CHANNEL_COUNT];
+static volatile uint8_t adcScanReady = 0;
+static volatile uint8_t adcHasSamples = 0;
+static ADC_ScanCallback adcScanCallback = NULL;
+
+// Default calibration: linear 0-100 °C across the 12-bit range
+static const TempCalibration tempCalDefault = {
+    .deci = {
+           0,   63,  125,  188,  250,  313,  375,  438,  500,
+         563,  625,  688,  750,  813,  875,  938, 1000
+    }
+};
+static const TempCalibration *tempCal = &tempCalDefault;
+static int16_t temperatureDeci = 0;
+static uint8_t waterLevelPercent = 0;
+
+// Percent per raw count above empty, Q16, so the level is a multiply and a shift
+#define WATER_LEVEL_PERCENT_Q16  ((100UL << 16) / (WATER_LEVEL_FULL_RAW - WATER_LEVEL_EMPTY_RAW))
+
+// Filter one half of the DMA buffer per channel and publish the sample set
+RAMFUNC static void ADC_FilterHalf(const uint16_t *samples) {
+    for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+        uint16_t mean = Filter_Decimate(&samples[ch], ADC_SCAN_DEPTH_LOG2 - 1, ADC_SCAN_CHANNEL_COUNT);
+        uint16_t median = Filter_Median(&adcMedian[ch], mean);
+        adcFiltered[ch] = Filter_Iir(&adcIir[ch], median);
+    }
+
+    adcScanReady = 1;
+    adcHasSamples = 1;
+    if (adcScanCallback != NULL) {
+        adcScanCallback();
+    }
+}
+
+// Function to configure the ADC scan group and its DMA channel
+void ADC_Init(void) {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    ADC_ChannelConfTypeDef sConfig = {0};
+
+    for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+        Filter_MedianInit(&adcMedian[ch]);
+        Filter_IirInit(&adcIir[ch], ADC_FILTER_DEFAULT_SHIFT);
+    }
+
+    __HAL_RCC_ADC_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+        GPIO_InitStruct.Pin = adcScanTable[ch].pin;
+        HAL_GPIO_Init(adcScanTable[ch].port, &GPIO_InitStruct);
+    }
+
+    hdma_adc1.Instance = DMA1_Channel1;
+    hdma_adc1.Init.Request = DMA_REQUEST_ADC1;
+    hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) {
+        Error_Handler();
+    }
+    __HAL_LINKDMA(&hadc1, DMA_Handle, hdma_adc1);
+
+    hadc1.Instance = ADC1;
+    hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV2;  // 6 MHz from the fixed 12 MHz PCLK (power.h)
+    hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc1.Init.LowPowerAutoWait = DISABLE;
+    hadc1.Init.LowPowerAutoPowerOff = DISABLE;
+    hadc1.Init.ContinuousConvMode = ENABLE;
+    hadc1.Init.NbrOfConversion = ADC_SCAN_CHANNEL_COUNT;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+    hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+    hadc1.Init.SamplingTimeCommon1 = ADC_SAMPLETIME_79CYCLES_5;
+    hadc1.Init.OversamplingMode = ENABLE;
+    hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_16;
+    hadc1.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_2;
+    hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    hadc1.Init.TriggerFrequencyMode = ADC_TRIGGER_FREQ_LOW;
+    if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+        Error_Handler();
+    }
+
+    sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+    for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+        sConfig.Channel = adcScanTable[ch].channel;
+        sConfig.Rank = adcScanTable[ch].rank;
+        if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+            Error_Handler();
+        }
+    }
+
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
+// Calibrate (the ADC is still disabled) and start the circular scan
+void ADC_Start(void) {
+    HAL_ADCEx_Calibration_Start(&hadc1);
+    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *)adcDmaBuffer, ADC_DMA_BUFFER_LEN) != HAL_OK) {
+        Error_Handler();
+    }
+}
+
+uint8_t ADC_HasSamples(void) {
+    return adcHasSamples;
+}
+
+// DMA has filled the first half of the buffer
+RAMFUNC void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+    if (hadc->Instance == ADC1) {
+        ADC_FilterHalf(&adcDmaBuffer[0]);
+    }
+}
+
+// DMA has filled the second half of the buffer
+RAMFUNC void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+    if (hadc->Instance == ADC1) {
+        ADC_FilterHalf(&adcDmaBuffer[ADC_DMA_BUFFER_LEN / 2]);
+    }
+}
+
+// Restart the conversion stream instead of leaving readers on a stale value
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc) {
+    if (hadc->Instance == ADC1) {
+        HAL_ADC_Stop_DMA(&hadc1);
+        HAL_ADC_Start_DMA(&hadc1, (uint32_t *)adcDmaBuffer, ADC_DMA_BUFFER_LEN);
+    }
+}
+
+RAMFUNC void DMA1_Channel1_IRQHandler(void) {
+    PROFILE_BEGIN();
+    HAL_DMA_IRQHandler(&hdma_adc1);
+    PROFILE_END(PROFILE_ISR_ADC);
+}
+
+// Latest filtered sample for one channel, updated in the background by DMA
+uint16_t ADC_GetFiltered(ADC_ScanChannel channel) {
+    if (channel >= ADC_SCAN_CHANNEL_COUNT) {
+        return 0;
+    }
+    return adcFiltered[channel];
+}
+
+// Same value reduced to the native 12-bit range
+uint16_t ADC_GetRaw(ADC_ScanChannel channel) {
+    return (uint16_t)(ADC_GetFiltered(channel) >> ADC_OVERSAMPLE_BITS);
+}
+
+// Newest conversion of one channel in the DMA buffer: elements below the counter's
+// position are complete this lap, otherwise the previous lap's last sequence holds it
+RAMFUNC uint16_t ADC_GetLatest(ADC_ScanChannel channel) {
+    uint32_t written;
+    uint32_t index = channel;
+
+    if (channel >= ADC_SCAN_CHANNEL_COUNT) {
+        return 0;
+    }
+    written = ADC_DMA_BUFFER_LEN - __HAL_DMA_GET_COUNTER(&hdma_adc1);
+    while (index + ADC_SCAN_CHANNEL_COUNT < written) {
+        index += ADC_SCAN_CHANNEL_COUNT;
+    }
+    if (index >= written) {
+        index += ADC_DMA_BUFFER_LEN - ADC_SCAN_CHANNEL_COUNT;
+    }
+    return adcDmaBuffer[index];
+}
+
+void ADC_SetFilterTimeConstant(ADC_ScanChannel channel, uint8_t shift) {
+    if (channel < ADC_SCAN_CHANNEL_COUNT) {
+        Filter_IirSetShift(&adcIir[channel], shift);
+    }
+}
+
+// Test-and-clear the "new sample set ready" flag; masked so a set published
+// between the read and the clear is not lost
+uint8_t ADC_ScanReady(void) {
+    uint8_t ready;
+
+    __disable_irq();
+    ready = adcScanReady;
+    adcScanReady = 0;
+    __enable_irq();
+    return ready;
+}
+
+void ADC_SetScanCallback(ADC_ScanCallback callback) {
+    adcScanCallback = callback;
+}
+
+void ADC_SetTemperatureCalibration(const TempCalibration *calibration) {
+    if (calibration != NULL) {
+        tempCal = calibration;
+    }
+}
+
+// Interpolate the temperature from the latest filtered sample
+static int16_t ADC_ConvertTemperature(void) {
+    const uint32_t shift = TEMP_CAL_SHIFT + ADC_OVERSAMPLE_BITS;
+    uint32_t adcValue = ADC_GetFiltered(ADC_CH_TEMPERATURE);
+    uint32_t index = adcValue >> shift;
+    int32_t frac = (int32_t)(adcValue & ((1u << shift) - 1u));
+    int32_t t0 = tempCal->deci[index];
+    int32_t t1 = tempCal->deci[index + 1];
+
+    // Interpolate between the two surrounding calibration points
+    return (int16_t)(t0 + (((t1 - t0) * frac) >> shift));
+}
+
+// Scale the latest filtered level sample to 0-100 %
+static uint8_t ADC_ConvertWaterLevel(void) {
+    uint32_t raw = ADC_GetRaw(ADC_CH_WATER_LEVEL);
+    uint32_t percent;
+
+    if (raw <= WATER_LEVEL_EMPTY_RAW) {
+        return 0;
+    }
+    percent = ((raw - WATER_LEVEL_EMPTY_RAW) * WATER_LEVEL_PERCENT_Q16) >> 16;
+    return (uint8_t)(percent > 100U ? 100U : percent);
+}
+
+// Sensor task: convert once per new sample set
+void ADC_Process(void) {
+    if (ADC_ScanReady()) {
+        temperatureDeci = ADC_ConvertTemperature();
+        waterLevelPercent = ADC_ConvertWaterLevel();
+    }
+}
+
+// Function to read temperature from ADC, in 0.1 °C (as of the last ADC_Process())
+int16_t Read_Temperature(void) {
+    return temperatureDeci;
+}
+
+// Water level in percent of capacity (as of the last ADC_Process())
+uint8_t Read_WaterLevel(void) {
+    return waterLevelPercent;
 }
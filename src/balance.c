@@ -0,0 +1,185 @@
+/**
+ * @file balance.c
+ * @brief Once-per-revolution ripple measurement for unbalance detection.
+ *
+ * This source file implements the detector declared in balance.h.
+ *
+ * Details:
+ * - Each tach pulse is one sixteenth of a revolution. `Balance_Pulse()` adds the
+ *   pulse period and the latest motor current sample into a running single-bin
+ *   DFT: sums of x * cos and x * sin at the revolution frequency, from a
+ *   16-entry Q7 table. That is four multiply-adds per pulse and no stored samples.
+ * - The drum accelerates during the measurement, which adds a linear trend to
+ *   both signals. The trend's contribution to the bin is known from the table
+ *   (`trendCos`, `trendSin`), so it is removed using the first sample of the
+ *   next revolution instead of a buffer.
+ * - The bin magnitude is approximated as 15/16 max + 15/32 min of |cos| and
+ *   |sin| parts (no square root, within ~6 %) and divided by the revolution's
+ *   sum, giving the ripple as a share of the mean in 0.1 %: two divisions per
+ *   revolution.
+ * - Results are smoothed over revolutions with a short IIR, so a verdict follows
+ *   a change in the load within a few revolutions.
+ * - The current sample is the newest conversion in the ADC's DMA buffer
+ *   (`ADC_GetLatest()`), not the filtered value, which changes once per half
+ *   buffer (5.9 ms) and is smoothed for the other readers. The scan group takes
+ *   0.74 ms (3 channels, 16 oversampled conversions of 92 cycles at 6 MHz), so
+ *   every tach pulse sees a new sample while its period is longer, i.e. up to
+ *   about 5000 rpm. The current term is therefore valid over the whole measured
+ *   range, `BALANCE_MIN_RPM` to `MOTOR_MAX_RPM`. A sample is up to one sequence
+ *   old, which turns the bin's phase but not its magnitude.
+ *
+ * Dependencies:
+ * - balance.h (for the thresholds and prototypes)
+ * - speed.h (for `TACH_PULSES_PER_REV`)
+ * - adc.h (for the motor current sample)
+ */
+
+
+
+ #include "balance.h"
+ #include "speed.h"
+ #include "adc.h"
+
+ #if TACH_PULSES_PER_REV != 16U
+ #error "balance.c: the harmonic table assumes 16 tach pulses per revolution"
+ #endif
+
+ // Revolution time at BALANCE_MIN_RPM
+ #define BALANCE_MAX_REV_US    (60000000U / BALANCE_MIN_RPM)
+
+ // Ripple IIR over revolutions, in powers of two
+ #define BALANCE_SMOOTH_SHIFT  1
+
+ // Smoothed ripple is kept in Q4
+ #define BALANCE_PERMILLE(pct) ((uint32_t)(pct) * 10U << 4)
+
+ // One running DFT bin at the revolution frequency
+ typedef struct {
+     int32_t re;
+     int32_t im;
+     uint32_t sum;
+     uint32_t first;    // Sample at pulse 0, for the trend correction
+ } BalanceHarmonic;
+
+ // cos(2 pi k / 16) in Q7; sin is the same table four entries later
+ static const int8_t harmonicTable[16] = {
+     127, 117, 90, 49, 0, -49, -90, -117, -127, -117, -90, -49, 0, 49, 90, 117,
+ };
+
+ // sum(k * cos) and sum(k * sin) over one revolution: the bin of a unit ramp
+ static int32_t trendCos = 0;
+ static int32_t trendSin = 0;
+
+ static BalanceHarmonic speedBin;
+ static BalanceHarmonic currentBin;
+ static uint8_t pulseIndex = 0;
+
+ static volatile uint8_t revolutions = 0;
+ static volatile int32_t speedRipple = 0;    // 0.1 %, Q4
+ static volatile int32_t currentRipple = 0;  // 0.1 %, Q4
+
+ static void Balance_Add(BalanceHarmonic *bin, uint8_t k, uint32_t sample) {
+     if (k == 0) {
+         bin->re = 0;
+         bin->im = 0;
+         bin->sum = 0;
+         bin->first = sample;
+     }
+     bin->re += (int32_t)sample * harmonicTable[k];
+     bin->im += (int32_t)sample * harmonicTable[(k + 12U) & 15U];
+     bin->sum += sample;
+ }
+
+ // Ripple of a completed revolution in 0.1 % of its mean; `next` is pulse 16
+ static uint32_t Balance_Finish(const BalanceHarmonic *bin, uint32_t next) {
+     int32_t slope = (int32_t)(next - bin->first);
+     int32_t re = bin->re - (slope * trendCos) / 16;
+     int32_t im = bin->im - (slope * trendSin) / 16;
+     uint32_t a = (uint32_t)(re < 0 ? -re : re);
+     uint32_t b = (uint32_t)(im < 0 ? -im : im);
+     uint32_t hi = a > b ? a : b;
+     uint32_t lo = a > b ? b : a;
+     uint32_t magnitude = hi - (hi >> 4) + (lo >> 1) - (lo >> 5);
+     // Amplitude / mean = 16 * magnitude / (1016 * sum); 1016 = 8 * 127 is the bin gain
+     uint32_t scale = (bin->sum * 127U) / 2000U;
+
+     if (scale == 0) {
+         return 0;
+     }
+     magnitude /= scale;
+     return magnitude > 1000U ? 1000U : magnitude;
+ }
+
+ static void Balance_Smooth(volatile int32_t *ripple, uint32_t permille) {
+     int32_t value = (int32_t)(permille << 4);
+
+     if (revolutions == 0) {
+         *ripple = value;
+     } else {
+         *ripple += (value - *ripple) >> BALANCE_SMOOTH_SHIFT;
+     }
+ }
+
+ void Balance_Init(void) {
+     trendCos = 0;
+     trendSin = 0;
+     for (uint8_t k = 0; k < 16U; k++) {
+         trendCos += (int32_t)k * harmonicTable[k];
+         trendSin += (int32_t)k * harmonicTable[(k + 12U) & 15U];
+     }
+     Balance_Reset();
+ }
+
+ void Balance_Reset(void) {
+     __disable_irq();
+     pulseIndex = 0;
+     revolutions = 0;
+     speedRipple = 0;
+     currentRipple = 0;
+     __enable_irq();
+ }
+
+ RAMFUNC void Balance_Pulse(uint32_t periodUs) {
+     uint32_t current = ADC_GetLatest(ADC_CH_MOTOR_CURRENT);
+
+     if (pulseIndex == TACH_PULSES_PER_REV) {
+         // Skip slow revolutions: the load is still tumbling, not pinned to the drum
+         if (speedBin.sum <= BALANCE_MAX_REV_US) {
+             Balance_Smooth(&speedRipple, Balance_Finish(&speedBin, periodUs));
+             Balance_Smooth(&currentRipple, Balance_Finish(&currentBin, current));
+             if (revolutions < UINT8_MAX) {
+                 revolutions++;
+             }
+         }
+         pulseIndex = 0;
+     }
+     Balance_Add(&speedBin, pulseIndex, periodUs);
+     Balance_Add(&currentBin, pulseIndex, current);
+     pulseIndex++;
+ }
+
+ BalanceVerdict Balance_GetVerdict(void) {
+     int32_t speed = speedRipple;
+     int32_t current = currentRipple;
+
+     if (revolutions < BALANCE_MIN_REVS) {
+         return BALANCE_MEASURING;
+     }
+     if (speed >= (int32_t)BALANCE_PERMILLE(BALANCE_SPEED_REDISTRIBUTE_PCT) ||
+         current >= (int32_t)BALANCE_PERMILLE(BALANCE_CURRENT_REDISTRIBUTE_PCT)) {
+         return BALANCE_REDISTRIBUTE;
+     }
+     if (speed >= (int32_t)BALANCE_PERMILLE(BALANCE_SPEED_HOLD_PCT) ||
+         current >= (int32_t)BALANCE_PERMILLE(BALANCE_CURRENT_HOLD_PCT)) {
+         return BALANCE_HOLD;
+     }
+     return BALANCE_OK;
+ }
+
+ uint16_t Balance_GetSpeedRipple(void) {
+     return (uint16_t)(speedRipple >> 4);
+ }
+
+ uint16_t Balance_GetCurrentRipple(void) {
+     return (uint16_t)(currentRipple >> 4);
+ }
@@ -0,0 +1,327 @@
+/**
+ * @file bench.c
+ * @brief Benchmark runner: times the panel, sensor and clock paths and prints the results.
+ *
+ * This source file implements the benchmark image declared in bench.h.
+ *
+ * Details:
+ * - SPI: one full panel (`DISPLAY_PAGES` regions of `DISPLAY_PANEL_COLUMNS` bytes)
+ *   `BENCH_SPI_FRAMES` times per prescaler, through the blocking `SPI_WriteRegion()`
+ *   and through `SPI_QueueRegion()` with a wait until the queue drains. One op is one
+ *   region; bytes/s counts column data only, so the address commands and CS edges
+ *   show up as the gap to the raw bit rate. SPI1 is re-initialised for each
+ *   prescaler and put back to its `SPI_Init()` setting afterwards.
+ * - Rendering: `SPI_WriteString()` straight to the panel (one op per glyph),
+ *   `Display_DrawString()` into the framebuffer (two texts in turn, so every glyph
+ *   really changes), and `Display_Flush()` of a fully dirty frame: the queueing
+ *   call alone (`flush-queue`), until the last byte is out (`flush-full`), and
+ *   with nothing dirty (`flush-clean`).
+ * - RTC: `HAL_RTC_GetTime()` plus `HAL_RTC_GetDate()` (the date read unlocks the
+ *   shadow registers), against the cached `RTC_GetClock()`.
+ * - The boot stages (boot.h) are run to completion first, so the RTC is set up, the
+ *   ADC is sampling and the panel is cleared before anything is timed.
+ * - ADC: the DMA path runs first, as started by `ADC_Start()`: the time between scan
+ *   callbacks over `BENCH_ADC_SCANS` half-buffers, per conversion. Then the DMA is
+ *   stopped and hadc1 re-initialised for single software-started sequences, and
+ *   `HAL_ADC_Start()` to the last `HAL_ADC_GetValue()` is timed per conversion.
+ *   Sampling time and oversampling are left as configured, so both paths convert
+ *   the same way; the ADC stays in polled mode afterwards.
+ * - The scan callback only counts; the main loop stamps the count change, so no
+ *   timestamp is taken inside an interrupt that SysTick could not preempt.
+ * - Each line is printed right after its benchmark, outside the timed region.
+ *
+ * Dependencies:
+ * - bench.h (for the flag, repeat counts and prototype)
+ * - main.h (for `Error_Handler()`)
+ * - spi.h, display.h, font.h (for the panel paths and their sizes)
+ * - adc.h, rtc.h (for hadc1, the scan callback and the RTC reads)
+ * - console.h (for USART2 and the line formatters)
+ * - boot.h (for finishing the boot stages and the SysTick cycle count)
+ */
+
+
+
+ #include "bench.h"
+ #include "main.h"
+
+ #if BENCH_IMAGE
+
+ #include "spi.h"
+ #include "display.h"
+ #include "font.h"
+ #include "adc.h"
+ #include "rtc.h"
+ #include "console.h"
+ #include "boot.h"
+
+ // Longest line: name, 4 fields of up to 10 digits, separators, CRLF
+ #define BENCH_LINE_SIZE         64
+ #define BENCH_UART_TIMEOUT_MS   100U
+ #define BENCH_ADC_TIMEOUT_MS    10U
+
+ // Glyphs in one panel-wide line, the length of both bench texts
+ #define BENCH_LINE_GLYPHS       (DISPLAY_WIDTH / DISPLAY_CHAR_WIDTH)
+
+ typedef struct {
+     uint32_t prescaler;
+     const char *blockName;
+     const char *dmaName;
+ } BenchPrescaler;
+
+ typedef struct {
+     uint32_t channel;
+     uint32_t rank;
+ } BenchAdcEntry;
+
+ static const BenchPrescaler benchPrescalers[] = {
+     {SPI_BAUDRATEPRESCALER_2,  "spi-block/2",  "spi-dma/2"},
+     {SPI_BAUDRATEPRESCALER_4,  "spi-block/4",  "spi-dma/4"},
+     {SPI_BAUDRATEPRESCALER_8,  "spi-block/8",  "spi-dma/8"},
+     {SPI_BAUDRATEPRESCALER_16, "spi-block/16", "spi-dma/16"},
+ };
+
+ // Same sequence as the DMA scan group in adc.c
+ static const BenchAdcEntry benchAdcTable[ADC_SCAN_CHANNEL_COUNT] = {
+     [ADC_CH_TEMPERATURE]   = {TEMP_SENSOR_ADC_CHANNEL,   ADC_REGULAR_RANK_1},
+     [ADC_CH_WATER_LEVEL]   = {WATER_LEVEL_ADC_CHANNEL,   ADC_REGULAR_RANK_2},
+     [ADC_CH_MOTOR_CURRENT] = {MOTOR_CURRENT_ADC_CHANNEL, ADC_REGULAR_RANK_3},
+ };
+
+ static const char *const benchText[2] = {
+     "0123456789ABCDEFGHIJK",
+     "LMNOPQRSTUVWXYZ012345",
+ };
+
+ static const char benchHeader[] = "bench ops cycles/op ns/op bytes/s\r\n";
+
+ static char benchLine[BENCH_LINE_SIZE];
+ static uint8_t benchColumns[DISPLAY_PANEL_COLUMNS];
+ static volatile uint32_t benchScans;
+ static volatile uint32_t benchSink;  // Keeps the read results alive
+
+ static void Bench_Print(const char *text, uint16_t length) {
+     HAL_UART_Transmit(&huart2, (const uint8_t *)text, length, BENCH_UART_TIMEOUT_MS);
+ }
+
+ // One result line; bytes 0 prints "-" for the rate
+ static void Bench_Report(const char *name, uint32_t ops, uint32_t cycles, uint32_t bytes) {
+     char *out = benchLine;
+
+     if (ops == 0) {
+         return;
+     }
+     out = Console_Append(out, name);
+     out = Console_AppendNumber(out, ops);
+     out = Console_AppendNumber(out, cycles / ops);
+     out = Console_AppendNumber(out, (uint32_t)((uint64_t)cycles * 1000000000ULL / SystemCoreClock / ops));
+     if (bytes > 0 && cycles > 0) {
+         out = Console_AppendNumber(out, (uint32_t)((uint64_t)bytes * SystemCoreClock / cycles));
+     } else {
+         out = Console_Append(out, " -");
+     }
+     out = Console_Append(out, "\r\n");
+     Bench_Print(benchLine, (uint16_t)(out - benchLine));
+ }
+
+ static void Bench_SetPrescaler(uint32_t prescaler) {
+     while (SPI_IsBusy()) {
+     }
+     hspi1.Init.BaudRatePrescaler = prescaler;
+     if (HAL_SPI_Init(&hspi1) != HAL_OK) {
+         Error_Handler();
+     }
+ }
+
+ // Full frames through the blocking and the DMA path at one prescaler
+ static void Bench_Spi(const BenchPrescaler *setting) {
+     uint32_t regions = BENCH_SPI_FRAMES * DISPLAY_PAGES;
+     uint32_t bytes = regions * DISPLAY_PANEL_COLUMNS;
+     uint32_t start;
+
+     Bench_SetPrescaler(setting->prescaler);
+
+     start = Boot_Cycles();
+     for (uint32_t frame = 0; frame < BENCH_SPI_FRAMES; frame++) {
+         for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+             SPI_WriteRegion(page, 0, benchColumns, DISPLAY_PANEL_COLUMNS);
+         }
+     }
+     Bench_Report(setting->blockName, regions, Boot_Cycles() - start, bytes);
+
+     // The queue holds one frame, so each frame is queued whole and then drained
+     start = Boot_Cycles();
+     for (uint32_t frame = 0; frame < BENCH_SPI_FRAMES; frame++) {
+         for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+             SPI_QueueRegion(page, 0, benchColumns, DISPLAY_PANEL_COLUMNS);
+         }
+         while (SPI_IsBusy()) {
+         }
+     }
+     Bench_Report(setting->dmaName, regions, Boot_Cycles() - start, bytes);
+ }
+
+ static void Bench_Glyphs(void) {
+     uint32_t glyphs = 0;
+     uint32_t start = Boot_Cycles();
+
+     for (uint32_t round = 0; round < BENCH_RENDER_ROUNDS; round++) {
+         for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+             glyphs += SPI_WriteString(page, 0, benchText[round & 1U]);
+         }
+     }
+     Bench_Report("glyph-spi", glyphs, Boot_Cycles() - start, glyphs * (FONT_GLYPH_WIDTH + 1U));
+ }
+
+ static void Bench_Framebuffer(void) {
+     uint32_t frameBytes = DISPLAY_PAGES * DISPLAY_WIDTH;
+     uint32_t queueCycles = 0;
+     uint32_t fullCycles = 0;
+     uint32_t start;
+
+     start = Boot_Cycles();
+     for (uint32_t round = 0; round < BENCH_RENDER_ROUNDS; round++) {
+         for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+             Display_DrawString(page, 0, benchText[round & 1U], 0);
+         }
+     }
+     Bench_Report("glyph-fb", BENCH_RENDER_ROUNDS * DISPLAY_PAGES * BENCH_LINE_GLYPHS,
+                  Boot_Cycles() - start, 0);
+
+     for (uint32_t round = 0; round < BENCH_RENDER_ROUNDS; round++) {
+         uint32_t queued;
+
+         Display_Init();
+         start = Boot_Cycles();
+         Display_Flush();
+         queued = Boot_Cycles();
+         while (SPI_IsBusy()) {
+         }
+         fullCycles += Boot_Cycles() - start;
+         queueCycles += queued - start;
+     }
+     Bench_Report("flush-queue", BENCH_RENDER_ROUNDS, queueCycles, 0);
+     Bench_Report("flush-full", BENCH_RENDER_ROUNDS, fullCycles, BENCH_RENDER_ROUNDS * frameBytes);
+
+     start = Boot_Cycles();
+     for (uint32_t round = 0; round < BENCH_RENDER_ROUNDS; round++) {
+         Display_Flush();
+     }
+     Bench_Report("flush-clean", BENCH_RENDER_ROUNDS, Boot_Cycles() - start, 0);
+ }
+
+ static void Bench_Rtc(void) {
+     RTC_TimeTypeDef time;
+     RTC_DateTypeDef date;
+     uint32_t start;
+
+     start = Boot_Cycles();
+     for (uint32_t i = 0; i < BENCH_RTC_READS; i++) {
+         HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+         HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+     }
+     Bench_Report("rtc-hal", BENCH_RTC_READS, Boot_Cycles() - start, 0);
+
+     start = Boot_Cycles();
+     for (uint32_t i = 0; i < BENCH_RTC_READS; i++) {
+         benchSink += RTC_GetClock();
+     }
+     Bench_Report("rtc-clock", BENCH_RTC_READS, Boot_Cycles() - start, 0);
+ }
+
+ static void Bench_AdcScan(void) {
+     benchScans++;
+ }
+
+ // Scan callback interval of the running DMA stream
+ static void Bench_AdcDma(void) {
+     uint32_t first;
+     uint32_t start;
+
+     ADC_SetScanCallback(Bench_AdcScan);
+
+     // Start on a scan boundary
+     first = benchScans;
+     while (benchScans == first) {
+     }
+     start = Boot_Cycles();
+     first = benchScans;
+     while (benchScans - first < BENCH_ADC_SCANS) {
+     }
+     Bench_Report("adc-dma", BENCH_ADC_SCANS * (ADC_DMA_BUFFER_LEN / 2U), Boot_Cycles() - start, 0);
+
+     ADC_SetScanCallback(NULL);
+ }
+
+ // Single software-started sequences, read one conversion at a time
+ static void Bench_AdcPolled(void) {
+     ADC_ChannelConfTypeDef sConfig = {0};
+     uint32_t cycles = 0;
+
+     HAL_ADC_Stop_DMA(&hadc1);
+     hadc1.Init.ContinuousConvMode = DISABLE;
+     hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+     hadc1.Init.DMAContinuousRequests = DISABLE;
+     if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+         Error_Handler();
+     }
+     sConfig.SamplingTime = ADC_SAMPLINGTIME_COMMON_1;
+     for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+         sConfig.Channel = benchAdcTable[ch].channel;
+         sConfig.Rank = benchAdcTable[ch].rank;
+         if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+             Error_Handler();
+         }
+     }
+
+     for (uint32_t scan = 0; scan < BENCH_ADC_SCANS; scan++) {
+         uint32_t start = Boot_Cycles();
+
+         HAL_ADC_Start(&hadc1);
+         for (uint32_t ch = 0; ch < ADC_SCAN_CHANNEL_COUNT; ch++) {
+             if (HAL_ADC_PollForConversion(&hadc1, BENCH_ADC_TIMEOUT_MS) != HAL_OK) {
+                 Error_Handler();
+             }
+             benchSink += HAL_ADC_GetValue(&hadc1);
+         }
+         cycles += Boot_Cycles() - start;
+     }
+     Bench_Report("adc-poll", BENCH_ADC_SCANS * ADC_SCAN_CHANNEL_COUNT, cycles, 0);
+ }
+
+ void Bench_Run(void) {
+     uint32_t prescaler = hspi1.Init.BaudRatePrescaler;
+     char *out = benchLine;
+
+     while (!Boot_IsDone()) {
+         Boot_Service();
+     }
+
+     for (uint8_t col = 0; col < DISPLAY_PANEL_COLUMNS; col++) {
+         benchColumns[col] = (uint8_t)(col ^ 0x55U);
+     }
+
+     Console_Init();
+     out = Console_Append(out, "clock");
+     out = Console_AppendNumber(out, SystemCoreClock);
+     out = Console_Append(out, "\r\n");
+     Bench_Print(benchLine, (uint16_t)(out - benchLine));
+     Bench_Print(benchHeader, sizeof(benchHeader) - 1);
+
+     for (uint8_t i = 0; i < sizeof(benchPrescalers) / sizeof(benchPrescalers[0]); i++) {
+         Bench_Spi(&benchPrescalers[i]);
+     }
+     Bench_SetPrescaler(prescaler);
+
+     Bench_Glyphs();
+     Bench_Framebuffer();
+     Bench_Rtc();
+     Bench_AdcDma();
+     Bench_AdcPolled();
+
+     Bench_Print("done\r\n", 6);
+     while (1) {
+         __WFI();
+     }
+ }
+
+ #endif // BENCH_IMAGE
@@ -0,0 +1,139 @@
+/**
+ * @file boot.c
+ * @brief Boot stage table and its non-blocking sequencer.
+ *
+ * This source file implements the staged boot declared in boot.h.
+ *
+ * Details:
+ * - Each stage is a const table entry: a start function that only kicks the
+ *   hardware, a poll function that finishes the stage once the hardware is
+ *   ready, and a timeout. All stages start together in `Boot_Start()`; every
+ *   `Boot_Service()` call polls each unfinished one once.
+ * - Time since boot comes from SysTick, milliseconds plus the part of the
+ *   current one, so it is valid from `HAL_Init()` on, before TIM1 (the
+ *   profiler's clock) runs.
+ *
+ * Dependencies:
+ * - boot.h (for the stage identifiers and prototypes)
+ * - main.h (for `Error_Handler()`)
+ * - adc.h, rtc.h, spi.h (for the stage functions)
+ * - profile.h (for the boot time probes)
+ */
+
+
+
+ #include "boot.h"
+ #include "main.h"
+ #include "adc.h"
+ #include "rtc.h"
+ #include "spi.h"
+ #include "profile.h"
+
+ typedef struct {
+     void (*start)(void);
+     uint8_t (*poll)(uint32_t elapsedMs);  // 1 once the stage has finished
+     uint32_t timeoutMs;                   // 0 = the poll ends the stage itself
+ } BootStageEntry;
+
+ static uint8_t Boot_PollRtc(uint32_t elapsedMs);
+ static uint8_t Boot_PollAdc(uint32_t elapsedMs);
+ static void Boot_StartPanel(void);
+ static uint8_t Boot_PollPanel(uint32_t elapsedMs);
+
+ static const BootStageEntry bootStages[BOOT_STAGE_COUNT] = {
+     [BOOT_STAGE_RTC]   = {RTC_StartClock,  Boot_PollRtc,   BOOT_RTC_TIMEOUT_MS},
+     [BOOT_STAGE_ADC]   = {ADC_Start,       Boot_PollAdc,   BOOT_ADC_TIMEOUT_MS},
+     [BOOT_STAGE_PANEL] = {Boot_StartPanel, Boot_PollPanel, 0},
+ };
+
+ static uint32_t bootStartMs = 0;
+ static uint8_t bootPending = (uint8_t)((1U << BOOT_STAGE_COUNT) - 1U);  // One bit per unfinished stage
+
+ // Microseconds since HAL_Init(), saturated to the profiler's 16 bits
+ static uint16_t Boot_Micros(void) {
+     uint32_t reload = SysTick->LOAD + 1U;
+     uint32_t cycles = Boot_Cycles();
+     uint32_t us = (cycles / reload) * 1000U + ((cycles % reload) * 1000U) / reload;
+
+     return (us > UINT16_MAX) ? UINT16_MAX : (uint16_t)us;
+ }
+
+ // LSI running: the calendar and the second alarm can be set up
+ static uint8_t Boot_PollRtc(uint32_t elapsedMs) {
+     (void)elapsedMs;
+     if (!RTC_ClockReady()) {
+         return 0;
+     }
+     MX_RTC_Init();
+     return 1;
+ }
+
+ // First sample set filtered: convert it now rather than at the next sensor task
+ static uint8_t Boot_PollAdc(uint32_t elapsedMs) {
+     (void)elapsedMs;
+     if (!ADC_HasSamples()) {
+         return 0;
+     }
+     ADC_Process();
+     return 1;
+ }
+
+ static void Boot_StartPanel(void) {
+     SPI_SendCommand(DISPLAY_CMD_CLEAR);
+ }
+
+ // More than DISPLAY_CLEAR_MS ticks apart, so at least that long has passed
+ static uint8_t Boot_PollPanel(uint32_t elapsedMs) {
+     return elapsedMs > DISPLAY_CLEAR_MS;
+ }
+
+ void Boot_Start(void) {
+     Profile_RecordUs(PROFILE_BOOT_SAFE, Boot_Micros());
+     bootStartMs = HAL_GetTick();
+     bootPending = (uint8_t)((1U << BOOT_STAGE_COUNT) - 1U);
+     for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+         bootStages[i].start();
+     }
+ }
+
+ uint8_t Boot_Service(void) {
+     uint32_t elapsedMs = HAL_GetTick() - bootStartMs;
+
+     if (bootPending == 0) {
+         return 0;
+     }
+     for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+         const BootStageEntry *stage = &bootStages[i];
+
+         if (!(bootPending & (1U << i))) {
+             continue;
+         }
+         if (stage->poll(elapsedMs)) {
+             bootPending &= (uint8_t)~(1U << i);
+         } else if (stage->timeoutMs != 0 && elapsedMs > stage->timeoutMs) {
+             Error_Handler();
+         }
+     }
+     if (bootPending != 0) {
+         return 0;
+     }
+     Profile_RecordUs(PROFILE_BOOT_READY, Boot_Micros());
+     return 1;
+ }
+
+ uint32_t Boot_Cycles(void) {
+     uint32_t reload = SysTick->LOAD + 1U;
+     uint32_t tick;
+     uint32_t count;
+
+     // Read again if the millisecond interrupt ran in between
+     do {
+         tick = HAL_GetTick();
+         count = SysTick->VAL;
+     } while (tick != HAL_GetTick());
+     return tick * reload + (reload - 1U - count);
+ }
+
+ uint8_t Boot_IsDone(void) {
+     return bootPending == 0;
+ }
@@ -0,0 +1,124 @@
+/**
+ * @file button.c
+ * @brief Vertical-counter button debouncer sampled from TIM17.
+ *
+ * This source file implements the debouncer declared in button.h.
+ *
+ * Details:
+ * - Each scan reads all buttons with one IDR access (active-low, GPIOA pins 0..3).
+ * - `vcount0`/`vcount1` form a 2-bit counter per bit position: a bit of the
+ *   debounced state only toggles after the raw input has differed from it on
+ *   4 consecutive scans. Any bounce resets that bit's counter.
+ * - One shared hold counter covers the held set; it restarts whenever the
+ *   debounced state changes, and drives long-press and auto-repeat events.
+ * - TIM17 only runs while a button is pressed or settling. `Button_Wake()`
+ *   starts it from the EXTI edge, and `Button_Scan()` stops it when idle, so
+ *   the debouncer costs nothing while the panel is untouched.
+ *
+ * Dependencies:
+ * - button.h (for button identifiers, timing and prototypes)
+ * - event.h (events are posted for the main loop)
+ * - main.h (for button pin definitions and Error_Handler)
+ * - profile.h (for the `PROFILE_ISR_BUTTON` interrupt probe)
+ * - power.h (for the timer clock)
+ */
+
+
+
+ #include "button.h"
+ #include "event.h"
+ #include "main.h"
+ #include "profile.h"
+ #include "power.h"
+
+ TIM_HandleTypeDef htim17;
+
+ static uint8_t debounced = 0;  // 1 = pressed
+ static uint8_t vcount0 = 0;
+ static uint8_t vcount1 = 0;
+ static uint8_t holdTicks = 0;    // Saturates at 255 scans
+ static uint8_t repeatTicks = 0;  // Scans until the next auto-repeat
+ static volatile uint8_t scanning = 0;
+
+ // Post one action for every button set in mask
+ static void Button_PostEach(uint8_t mask, ButtonAction action) {
+     for (uint8_t button = 0; mask != 0; button++, mask >>= 1) {
+         if (mask & 1u) {
+             Event_Post(EVENT_BUTTON, BUTTON_EVENT_PARAM(button, action));
+         }
+     }
+ }
+
+ void Button_Init(void) {
+     __HAL_RCC_TIM17_CLK_ENABLE();
+
+     // 10 kHz count clock, update every BUTTON_SCAN_MS
+     htim17.Instance = TIM17;
+     htim17.Init.Prescaler = (POWER_TIMER_HZ / 10000U) - 1U;
+     htim17.Init.CounterMode = TIM_COUNTERMODE_UP;
+     htim17.Init.Period = (BUTTON_SCAN_MS * 10U) - 1U;
+     htim17.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+     htim17.Init.RepetitionCounter = 0;
+     htim17.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+     if (HAL_TIM_Base_Init(&htim17) != HAL_OK) {
+         Error_Handler();
+     }
+
+     // Same priority as the button EXTI lines, so Wake and Scan never preempt each other
+     HAL_NVIC_SetPriority(TIM17_IRQn, 2, 0);
+     HAL_NVIC_EnableIRQ(TIM17_IRQn);
+ }
+
+ void Button_Wake(void) {
+     if (!scanning) {
+         scanning = 1;
+         __HAL_TIM_SET_COUNTER(&htim17, 0);
+         HAL_TIM_Base_Start_IT(&htim17);
+     }
+ }
+
+ RAMFUNC void Button_Scan(void) {
+     uint8_t sample = (uint8_t)(~BUTTON_GPIO_PORT->IDR) & BUTTON_MASK;
+     uint8_t delta = sample ^ debounced;
+     uint8_t toggle;
+
+     // Count consecutive differing samples per bit, reset on agreement
+     vcount1 = (vcount1 ^ vcount0) & delta;
+     vcount0 = (uint8_t)~vcount0 & delta;
+     toggle = delta & (uint8_t)~(vcount0 | vcount1);
+     debounced ^= toggle;
+
+     if (toggle) {
+         holdTicks = 0;
+         repeatTicks = BUTTON_REPEAT_DELAY_MS / BUTTON_SCAN_MS;
+         Button_PostEach(toggle & debounced, BUTTON_PRESSED);
+         Button_PostEach(toggle & (uint8_t)~debounced, BUTTON_RELEASED);
+     } else if (debounced) {
+         if (holdTicks < UINT8_MAX) {
+             holdTicks++;
+         }
+         if (holdTicks == BUTTON_LONG_MS / BUTTON_SCAN_MS) {
+             Button_PostEach(debounced, BUTTON_LONG_PRESS);
+         }
+         if (--repeatTicks == 0) {
+             repeatTicks = BUTTON_REPEAT_MS / BUTTON_SCAN_MS;
+             Button_PostEach(debounced, BUTTON_REPEAT);
+         }
+     }
+
+     // Nothing held and nothing settling: stop until the next EXTI edge
+     if (debounced == 0 && delta == 0) {
+         HAL_TIM_Base_Stop_IT(&htim17);
+         scanning = 0;
+     }
+ }
+
+ uint8_t Button_IsScanning(void) {
+     return scanning;
+ }
+
+ RAMFUNC void TIM17_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_TIM_IRQHandler(&htim17);
+     PROFILE_END(PROFILE_ISR_BUTTON);
+ }
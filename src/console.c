@@ -0,0 +1,90 @@
+/**
+ * @file console.c
+ * @brief USART2 transmit setup and the shared line formatters.
+ *
+ * This source file implements the console declared in console.h.
+ *
+ * Details:
+ * - USART2 is configured on the first `Console_Init()` call, with its interrupt
+ *   at the lowest priority so an interrupt-driven transmit never delays the
+ *   control interrupts. Blocking transmits leave the interrupt idle.
+ * - Numbers are formatted with one division by 10 per digit (no printf, no
+ *   lookup table).
+ *
+ * Dependencies:
+ * - console.h (for the pin, baud rate and prototypes)
+ * - main.h (for `Error_Handler()`)
+ */
+
+
+
+ #include "console.h"
+ #include "main.h"
+
+ #if CONSOLE_ENABLE
+
+ UART_HandleTypeDef huart2;
+
+ static uint8_t consoleReady = 0;
+
+ void Console_Init(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+     if (consoleReady) {
+         return;
+     }
+
+     __HAL_RCC_USART2_CLK_ENABLE();
+     __HAL_RCC_GPIOA_CLK_ENABLE();
+
+     GPIO_InitStruct.Pin = CONSOLE_TX_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+     GPIO_InitStruct.Pull = GPIO_NOPULL;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     GPIO_InitStruct.Alternate = GPIO_AF1_USART2;
+     HAL_GPIO_Init(CONSOLE_GPIO_PORT, &GPIO_InitStruct);
+
+     huart2.Instance = USART2;
+     huart2.Init.BaudRate = CONSOLE_BAUD;
+     huart2.Init.WordLength = UART_WORDLENGTH_8B;
+     huart2.Init.StopBits = UART_STOPBITS_1;
+     huart2.Init.Parity = UART_PARITY_NONE;
+     huart2.Init.Mode = UART_MODE_TX;
+     huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+     huart2.Init.OverSampling = UART_OVERSAMPLING_16;
+     if (HAL_UART_Init(&huart2) != HAL_OK) {
+         Error_Handler();
+     }
+
+     HAL_NVIC_SetPriority(USART2_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(USART2_IRQn);
+     consoleReady = 1;
+ }
+
+ char *Console_Append(char *out, const char *text) {
+     while (*text != '\0') {
+         *out++ = *text++;
+     }
+     return out;
+ }
+
+ char *Console_AppendNumber(char *out, uint32_t value) {
+     char digits[10];
+     uint8_t n = 0;
+
+     *out++ = ' ';
+     do {
+         digits[n++] = (char)('0' + value % 10U);
+         value /= 10U;
+     } while (value != 0);
+     while (n > 0) {
+         *out++ = digits[--n];
+     }
+     return out;
+ }
+
+ void USART2_IRQHandler(void) {
+     HAL_UART_IRQHandler(&huart2);
+ }
+
+ #endif // CONSOLE_ENABLE
@@ -1,155 +1,232 @@
 /**
- * @file washer.c
- * @brief Washer control logic with temperature-based water control and real-time clock display.
+ * @file display.c
+ * @brief Framebuffer display driver with dirty-region tracking.
  *
- * This source file implements the washer control state machine and extends the functionality
- * by incorporating temperature-based decision making and real-time clock updates.
+ * This source file implements the display layer declared in display.h. The
+ * washer code draws into a RAM copy of the panel memory; `Display_Flush()`
+ * later sends only what changed.
  *
  * Main Features:
- * - Initialization of the washer state machine and display.
- * - Reading temperature data from the ADC to determine hot/cold water valve control during the FILL_WATER phase.
- * - Step-by-step state machine progression through FILL_WATER → WASH → RINSE → SPIN → IDLE.
- * - Handling user button inputs for starting, stopping, and selecting wash programs.
- * - Reading and displaying the 24-hour clock time from the RTC module.
+ * - A `DISPLAY_PAGES` x `DISPLAY_WIDTH` byte framebuffer in the controller's
+ *   native page/column layout, so a flush is a straight copy with no conversion.
+ * - Per-page dirty column ranges (`dirtyStart`/`dirtyEnd`), widened only when a
+ *   written byte differs from what the framebuffer already holds.
+ * - `Display_Flush()` queues each dirty range with `SPI_QueueRegion()` and returns
+ *   at once; DMA sends each as one chip select assertion, three address commands
+ *   and the changed column bytes, while the CPU goes back to control work.
+ * - Drawing may continue while a flush is in flight: a byte changed after its page
+ *   was queued marks the page dirty again and goes out with the next flush.
+ * - Text drawing from the 5x8 font table, page aligned, one spacing column per
+ *   character; `minChars` pads with spaces so shorter text erases longer text.
+ * - Glyph blitting: the font is stored in the panel's column-major page format,
+ *   so each character cell is one 6-byte compare and, only if it differs, one
+ *   6-byte copy plus a single dirty range update. No per-pixel or per-column work.
+ * - Washer status helpers (state line, program line, clock line).
  *
  * Main Functions:
- * - Washer_Init(WasherControl *washer): Initializes washer control structure and updates display.
- * - Read_Temperature(void): Reads ADC value and converts it to a float temperature (°C).
- * - Washer_Update(WasherControl *washer): Advances washer through its states, uses temperature to control valves.
- * - Washer_HandleButtonPress(WasherControl *washer, int button): Responds to button input to start, stop, or select a program.
- * - Display_UpdateTime(void): Fetches current time from RTC and updates it on the display.
+ * - Display_Init(void): Clears the framebuffer and marks the whole panel dirty.
+ * - Display_DrawString(page, col, text, minChars): Draws text into the framebuffer.
+ * - Display_Flush(void): Sends dirty regions to the panel.
+ * - Display_UpdateWasherState(state, programIndex): Status line, e.g. "RINSE   P05".
+ * - Display_ShowSelectedProgram(programIndex): Program line, e.g. "PROGRAM 05".
+ * - Display_UpdateTime(void): Redraws the clock digits that changed since the last call.
  *
  * Dependencies:
- * - washer.h (WasherControl structure and state definitions)
- * - display.h (functions for updating display)
- * - main.h (button definitions, GPIO pin definitions)
- * - rtc.h (for accessing RTC time and date)
- * - adc.h (for reading temperature from ADC)
+ * - display.h (layout constants and prototypes)
+ * - spi.h (for `SPI_QueueRegion()`)
+ * - font.h (5x8 glyph table)
+ * - rtc.h (for `RTC_GetClock()`)
+ * - ramfunc.h (for the SRAM placement of the blitter)
  *
  * Notes:
- * - Temperature reading assumes a 0–100°C mapping based on a 12-bit ADC.
- * - Hot and cold water control is based on simple threshold comparison:
- *     - Below 25°C → use hot water
- *     - Above 35°C → use cold water
- *     - Between 25°C and 35°C → mix hot and cold
- * - Time is displayed in HH:MM:SS format and refreshed frequently.
+ * - Programs are shown 1-based (01-30) while `programIndex` is 0-based.
+ * - Time is displayed in HH:MM:SS format. `Display_UpdateTime()` runs on each
+ *   `EVENT_CLOCK` from the RTC interrupt and draws only the changed digit cells,
+ *   normally just the seconds; the RTC is never read from this module.
+ * - Number formatting is hand written (subtraction, no division or printf), as
+ *   the Cortex-M0+ has no hardware divider.
  */
 
 
 
- #include "washer.h"
  #include "display.h"
- #include "main.h"
+ #include "spi.h"
+ #include "font.h"
  #include "rtc.h"
- #include "adc.h"
- 
- #define TEMP_SENSOR_ADC_CHANNEL ADC_CHANNEL_0
- #define TEMP_SENSOR_PORT GPIOA
- #define TEMP_SENSOR_PIN GPIO_PIN_0
- 
- // Initialize washer state
- void Washer_Init(WasherControl *washer) {
-     washer->state = IDLE;
-     washer->programIndex = 0;
-     washer->stepIndex = 0;
-     washer->timer = 0;
-     washer->direction = FORWARD;
-     Display_UpdateWasherState(washer->state, washer->programIndex);
-     Display_UpdateTime();
+ #include "ramfunc.h"
+ #include <string.h>
+
+ static uint8_t framebuffer[DISPLAY_PAGES][DISPLAY_WIDTH];
+ static uint8_t dirtyStart[DISPLAY_PAGES]; // First dirty column
+ static uint8_t dirtyEnd[DISPLAY_PAGES];   // One past the last dirty column (start >= end: clean)
+
+ // Clock line as currently drawn ("HH:MM:SS"), '\0' cells force a redraw
+ static char clockShown[8];
+
+ static const char *const stateNames[] = {
+     [IDLE]         = "IDLE",
+     [FILL_WATER]   = "FILL",
+     [WASH]         = "WASH",
+     [RINSE]        = "RINSE",
+     [SPIN]         = "SPIN",
+     [DONE]         = "DONE",
+     [WASHER_ERROR] = "ERROR",
+ };
+
+ // Widen a page's dirty range to cover columns [start, end)
+ RAMFUNC static void Display_MarkDirty(uint8_t page, uint8_t start, uint8_t end) {
+     if (start < dirtyStart[page]) {
+         dirtyStart[page] = start;
+     }
+     if (end > dirtyEnd[page]) {
+         dirtyEnd[page] = end;
+     }
+ }
+
+ // Store one column byte, extending the dirty range only if it changed
+ static void Display_PutColumn(uint8_t page, uint8_t col, uint8_t bits) {
+     if (framebuffer[page][col] == bits) {
+         return;
+     }
+     framebuffer[page][col] = bits;
+     Display_MarkDirty(page, col, col + 1);
+ }
+
+ // Copy one character cell (glyph + spacing column), caller checks it fits
+ RAMFUNC static void Display_BlitGlyph(uint8_t page, uint8_t col, const uint8_t *glyph) {
+     uint8_t cell[DISPLAY_CHAR_WIDTH];
+     uint8_t *dst = &framebuffer[page][col];
+
+     memcpy(cell, glyph, FONT_GLYPH_WIDTH);
+     cell[FONT_GLYPH_WIDTH] = 0;
+     if (memcmp(dst, cell, DISPLAY_CHAR_WIDTH) == 0) {
+         return;
+     }
+     memcpy(dst, cell, DISPLAY_CHAR_WIDTH);
+     Display_MarkDirty(page, col, col + DISPLAY_CHAR_WIDTH);
+ }
+
+ // Two decimal digits without printf
+ static void Display_FormatTwoDigits(char *out, int value) {
+     if (value < 0) {
+         value = 0;
+     } else if (value > 99) {
+         value = 99;
+     }
+     out[0] = '0';
+     while (value >= 10) {
+         value -= 10;
+         out[0]++;
+     }
+     out[1] = (char)('0' + value);
+ }
+
+ // Forget what the clock line shows so the next update redraws all of it
+ static void Display_InvalidateClock(void) {
+     for (uint8_t i = 0; i < sizeof(clockShown); i++) {
+         clockShown[i] = '\0';
+     }
+ }
+
+ // Mark one page clean
+ static void Display_ResetDirty(uint8_t page) {
+     dirtyStart[page] = DISPLAY_WIDTH;
+     dirtyEnd[page] = 0;
+ }
+
+ void Display_Init(void) {
+     for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+         for (uint8_t col = 0; col < DISPLAY_WIDTH; col++) {
+             framebuffer[page][col] = 0;
+         }
+         // Panel contents are unknown after reset: send everything once
+         dirtyStart[page] = 0;
+         dirtyEnd[page] = DISPLAY_WIDTH;
+     }
+     Display_InvalidateClock();
  }
- 
- // Read temperature from ADC
- float Read_Temperature(void) {
-     HAL_ADC_Start(&hadc1);
-     HAL_ADC_PollForConversion(&hadc1, HAL_MAX_DELAY);
-     uint32_t adcValue = HAL_ADC_GetValue(&hadc1);
-     HAL_ADC_Stop(&hadc1);
- 
-     // Convert ADC value to temperature (simple linear approximation)
-     float temperature = (adcValue / 4095.0) * 100.0; // Example conversion
-     return temperature;
+
+ void Display_Clear(void) {
+     for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+         for (uint8_t col = 0; col < DISPLAY_WIDTH; col++) {
+             Display_PutColumn(page, col, 0);
+         }
+     }
+     Display_InvalidateClock();
  }
- 
- // Update washer state machine
- void Washer_Update(WasherControl *washer) {
-     float temperature = Read_Temperature();
-     switch (washer->state) {
-         case IDLE:
-             // Wait for start button press
-             break;
-         case FILL_WATER:
-             Display_UpdateWasherState(FILL_WATER, washer->programIndex);
-             // Handle fill water logic based on temperature
-             if (temperature < 25.0) {
-                 HAL_GPIO_WritePin(HOT_WATER_PORT, HOT_WATER_PIN, GPIO_PIN_SET);
-                 HAL_GPIO_WritePin(COLD_WATER_PORT, COLD_WATER_PIN, GPIO_PIN_RESET);
-             } else if (temperature > 35.0) {
-                 HAL_GPIO_WritePin(HOT_WATER_PORT, HOT_WATER_PIN, GPIO_PIN_RESET);
-                 HAL_GPIO_WritePin(COLD_WATER_PORT, COLD_WATER_PIN, GPIO_PIN_SET);
-             } else {
-                 HAL_GPIO_WritePin(HOT_WATER_PORT, HOT_WATER_PIN, GPIO_PIN_SET);
-                 HAL_GPIO_WritePin(COLD_WATER_PORT, COLD_WATER_PIN, GPIO_PIN_SET);
-             }
-             washer->state = WASH;
-             break;
-         case WASH:
-             Display_UpdateWasherState(WASH, washer->programIndex);
-             // Handle washing logic
-             washer->state = RINSE;
-             break;
-         case RINSE:
-             Display_UpdateWasherState(RINSE, washer->programIndex);
-             // Handle rinsing logic
-             washer->state = SPIN;
-             break;
-         case SPIN:
-             Display_UpdateWasherState(SPIN, washer->programIndex);
-             // Handle spinning logic
-             washer->state = IDLE;
-             break;
-         case ERROR:
-             Display_UpdateWasherState(ERROR, washer->programIndex);
-             // Handle error condition
-             break;
-         default:
-             Display_UpdateWasherState(ERROR, washer->programIndex);
-             break;
+
+ void Display_DrawString(uint8_t page, uint8_t col, const char *text, uint8_t minChars) {
+     uint8_t count = 0;
+
+     if (page >= DISPLAY_PAGES) {
+         return;
+     }
+     while ((*text != '\0' || count < minChars) && col + DISPLAY_CHAR_WIDTH <= DISPLAY_WIDTH) {
+         char c = (*text != '\0') ? *text++ : ' ';
+
+         Display_BlitGlyph(page, col, FONT_GLYPH(c));
+         col += DISPLAY_CHAR_WIDTH;
+         count++;
      }
-     Display_UpdateTime(); // Refresh time display
  }
- 
- // Handle button inputs
- void Washer_HandleButtonPress(WasherControl *washer, int button) {
-     if (button == BUTTON_START && washer->state == IDLE) {
-         washer->state = FILL_WATER;
-         Display_UpdateWasherState(washer->state, washer->programIndex);
-     } else if (button == BUTTON_STOP) {
-         washer->state = IDLE;
-         Display_UpdateWasherState(washer->state, washer->programIndex);
-     } else if (button == BUTTON_UP && washer->state == IDLE) {
-         if (washer->programIndex < 29) {
-             washer->programIndex++;
-             Display_ShowSelectedProgram(washer->programIndex);
+
+ void Display_Flush(void) {
+     for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+         uint8_t start = dirtyStart[page];
+         uint8_t end = dirtyEnd[page];
+
+         // A full queue leaves the page dirty for the next flush
+         if (start < end && SPI_QueueRegion(page, start, &framebuffer[page][start], end - start)) {
+             Display_ResetDirty(page);
          }
-     } else if (button == BUTTON_DOWN && washer->state == IDLE) {
-         if (washer->programIndex > 0) {
-             washer->programIndex--;
-             Display_ShowSelectedProgram(washer->programIndex);
+     }
+ }
+
+ uint8_t Display_IsDirty(void) {
+     for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+         if (dirtyStart[page] < dirtyEnd[page]) {
+             return 1;
          }
      }
-     Display_UpdateTime(); // Ensure time updates when buttons are pressed
+     return 0;
  }
- 
- // Function to update the 24-hour clock on the display
+
+ // Status line: state name and active program
+ void Display_UpdateWasherState(WasherState state, int programIndex) {
+     char program[4] = {'P', '0', '0', '\0'};
+     const char *name = "?";
+
+     if ((unsigned)state < sizeof(stateNames) / sizeof(stateNames[0]) && stateNames[state] != NULL) {
+         name = stateNames[state];
+     }
+     Display_FormatTwoDigits(&program[1], programIndex + 1);
+     Display_DrawString(DISPLAY_PAGE_STATUS, 0, name, 8);
+     Display_DrawString(DISPLAY_PAGE_STATUS, 8 * DISPLAY_CHAR_WIDTH, program, 3);
+ }
+
+ // Program selection line
+ void Display_ShowSelectedProgram(int programIndex) {
+     char text[11] = "PROGRAM 00";
+
+     Display_FormatTwoDigits(&text[8], programIndex + 1);
+     Display_DrawString(DISPLAY_PAGE_PROGRAM, 0, text, 10);
+ }
+
+ // Update the 24-hour clock, redrawing only the character cells that changed
  void Display_UpdateTime(void) {
-     RTC_TimeTypeDef sTime;
-     RTC_DateTypeDef sDate;
-     char timeString[10];
- 
-     HAL_RTC_GetTime(&hrtc, &sTime, RTC_FORMAT_BIN);
-     HAL_RTC_GetDate(&hrtc, &sDate, RTC_FORMAT_BIN);
- 
-     sprintf(timeString, "%02d:%02d:%02d", sTime.Hours, sTime.Minutes, sTime.Seconds);
-     Display_ShowTime(timeString);
+     uint32_t clock = RTC_GetClock();
+     char text[8] = {'0', '0', ':', '0', '0', ':', '0', '0'};
+     char cell[2] = {'\0', '\0'};
+
+     Display_FormatTwoDigits(&text[0], RTC_CLOCK_HOURS(clock));
+     Display_FormatTwoDigits(&text[3], RTC_CLOCK_MINUTES(clock));
+     Display_FormatTwoDigits(&text[6], RTC_CLOCK_SECONDS(clock));
+
+     for (uint8_t i = 0; i < sizeof(text); i++) {
+         if (text[i] != clockShown[i]) {
+             cell[0] = text[i];
+             Display_DrawString(DISPLAY_PAGE_CLOCK, i * DISPLAY_CHAR_WIDTH, cell, 1);
+             clockShown[i] = text[i];
+         }
+     }
  }
- 
\ No newline at end of file
@@ -0,0 +1,85 @@
+/**
+ * @file event.c
+ * @brief Per-source SPSC event rings shared by interrupt handlers and the main loop.
+ *
+ * This source file implements the queue declared in event.h as one ring per
+ * event type, each indexed by free-running head/tail counters (masked with
+ * EVENT_RING_SIZE - 1).
+ *
+ * Details:
+ * - A ring has one producer (the interrupt that posts its type) and one
+ *   consumer (the main loop). Only the producer writes `head` and only the
+ *   consumer writes `tail`, so single byte loads and stores are enough: the
+ *   Cortex-M0+ has no LDREX/STREX and needs no critical section for this.
+ * - The producer fills the slot before publishing it by advancing `head`; the
+ *   consumer reads the slot before releasing it by advancing `tail`. `__DMB()`
+ *   keeps the compiler (and the bus) from reordering across those stores.
+ * - The type is implied by the ring, so a slot is just the one-byte parameter.
+ *
+ * Dependencies:
+ * - event.h (for the event types and prototypes)
+ * - stm32c0xx_hal.h (for the CMSIS barrier intrinsic)
+ */
+
+
+
+ #include "event.h"
+ #include "stm32c0xx_hal.h"
+
+ #define EVENT_RING_COUNT  (EVENT_TYPE_COUNT - 1)
+ #define EVENT_RING_MASK   (EVENT_RING_SIZE - 1)
+
+ typedef struct {
+     uint8_t param[EVENT_RING_SIZE];
+     volatile uint8_t head;  // Next slot to write (producer only)
+     volatile uint8_t tail;  // Next slot to read (consumer only)
+ } EventRing;
+
+ // Ring i carries events of type i + 1
+ static EventRing eventRings[EVENT_RING_COUNT];
+
+ // Append an event to its ring, returns 0 if it was full
+ RAMFUNC uint8_t Event_Post(EventType type, uint8_t param) {
+     EventRing *ring;
+     uint8_t head;
+
+     if (type == EVENT_NONE || type >= EVENT_TYPE_COUNT) {
+         return 0;
+     }
+     ring = &eventRings[type - 1];
+     head = ring->head;
+     if ((uint8_t)(head - ring->tail) >= EVENT_RING_SIZE) {
+         return 0;
+     }
+     ring->param[head & EVENT_RING_MASK] = param;
+     __DMB();  // Slot written before it is published
+     ring->head = (uint8_t)(head + 1);
+     return 1;
+ }
+
+ // Remove the oldest event of the first non-empty ring, returns 0 if all were empty
+ RAMFUNC uint8_t Event_Get(Event *event) {
+     for (uint8_t i = 0; i < EVENT_RING_COUNT; i++) {
+         EventRing *ring = &eventRings[i];
+         uint8_t tail = ring->tail;
+
+         if (ring->head != tail) {
+             __DMB();  // Slot read only after its head was seen
+             event->type = (EventType)(i + 1);
+             event->param = ring->param[tail & EVENT_RING_MASK];
+             __DMB();  // Slot read before it is released
+             ring->tail = (uint8_t)(tail + 1);
+             return 1;
+         }
+     }
+     return 0;
+ }
+
+ uint8_t Event_Pending(void) {
+     for (uint8_t i = 0; i < EVENT_RING_COUNT; i++) {
+         if (eventRings[i].head != eventRings[i].tail) {
+             return 1;
+         }
+     }
+     return 0;
+ }
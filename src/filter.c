@@ -0,0 +1,94 @@
+/**
+ * @file filter.c
+ * @brief Integer median, IIR and decimation filters for sensor samples.
+ *
+ * This source file implements the filters declared in filter.h. They are
+ * written for interrupt context on a Cortex-M0+: no floating point, no
+ * division and a fixed, small amount of work per sample.
+ *
+ * Details:
+ * - Filter_Median() keeps a ring of the last FILTER_MEDIAN_LEN samples and
+ *   returns the middle value of a sorted copy (insertion sort, N is tiny).
+ *   The first sample seeds the whole window.
+ * - Filter_Iir() implements `y += (x - y) >> shift` on a state scaled by
+ *   2^FILTER_IIR_FRAC_BITS, then rounds the state back to sample units.
+ * - Filter_Decimate() sums a power-of-two run of samples and shifts, which
+ *   is the software equivalent of the ADC's hardware oversampler.
+ *
+ * Dependencies:
+ * - filter.h (for filter types and prototypes)
+ */
+
+
+
+ #include "filter.h"
+
+ void Filter_MedianInit(MedianFilter *filter) {
+     for (uint8_t i = 0; i < FILTER_MEDIAN_LEN; i++) {
+         filter->window[i] = 0;
+     }
+     filter->pos = 0;
+     filter->primed = 0;
+ }
+
+ RAMFUNC uint16_t Filter_Median(MedianFilter *filter, uint16_t sample) {
+     uint16_t sorted[FILTER_MEDIAN_LEN];
+
+     // First sample fills the whole window so start-up needs no special case
+     if (!filter->primed) {
+         for (uint8_t i = 0; i < FILTER_MEDIAN_LEN; i++) {
+             filter->window[i] = sample;
+         }
+         filter->primed = 1;
+     }
+
+     filter->window[filter->pos] = sample;
+     if (++filter->pos >= FILTER_MEDIAN_LEN) {
+         filter->pos = 0;
+     }
+
+     // Insertion sort of the window copy
+     for (uint8_t i = 0; i < FILTER_MEDIAN_LEN; i++) {
+         uint16_t value = filter->window[i];
+         uint8_t j = i;
+         while (j > 0 && sorted[j - 1] > value) {
+             sorted[j] = sorted[j - 1];
+             j--;
+         }
+         sorted[j] = value;
+     }
+     return sorted[FILTER_MEDIAN_LEN / 2];
+ }
+
+ void Filter_IirInit(IirFilter *filter, uint8_t shift) {
+     filter->state = 0;
+     filter->shift = shift;
+     filter->primed = 0;
+ }
+
+ void Filter_IirSetShift(IirFilter *filter, uint8_t shift) {
+     filter->shift = shift;
+ }
+
+ RAMFUNC uint16_t Filter_Iir(IirFilter *filter, uint16_t sample) {
+     int32_t input = (int32_t)sample << FILTER_IIR_FRAC_BITS;
+
+     if (!filter->primed) {
+         filter->state = input;
+         filter->primed = 1;
+     } else {
+         filter->state += (input - filter->state) >> filter->shift;
+     }
+     return (uint16_t)((filter->state + (1 << (FILTER_IIR_FRAC_BITS - 1))) >> FILTER_IIR_FRAC_BITS);
+ }
+
+ RAMFUNC uint16_t Filter_Decimate(const uint16_t *samples, uint8_t log2Count, uint8_t stride) {
+     uint32_t sum = 0;
+     uint32_t count = 1u << log2Count;
+
+     for (uint32_t i = 0; i < count; i++) {
+         sum += *samples;
+         samples += stride;
+     }
+     return (uint16_t)(sum >> log2Count);
+ }
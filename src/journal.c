@@ -0,0 +1,236 @@
+/**
+ * @file journal.c
+ * @brief Append-only wash cycle journal over two flash pages.
+ *
+ * This source file implements the journal declared in journal.h.
+ *
+ * Details:
+ * - Record layout (one double word): sequence [15:0], program [23:16] (0xFF in
+ *   an end record), step [31:24], elapsed seconds [47:32], format tag [55:48],
+ *   CRC-8 of the lower seven bytes [63:56]. An erased slot reads all ones and
+ *   never passes the tag check.
+ * - Boot: per page, a binary search for the first blank slot, then a walk back
+ *   over any torn records to the newest valid one; the page whose newest record
+ *   has the higher sequence (serial comparison) is current. Eight reads per page
+ *   in the normal case.
+ * - Append: into the first blank slot of the current page. A full page (or a
+ *   failed program) moves on to the other page if it is already erased; if not,
+ *   the record is dropped and the newest one on the full page stands.
+ * - Spare page: checked blank at boot, otherwise erased by `Journal_Prepare()`
+ *   between cycles once the current page took its first record. That loses
+ *   nothing, since the current page already holds the newest record.
+ * - Boot refuses to start (Error_Handler()) when the flash image, code plus the
+ *   .data load image, reaches into the journal pages.
+ * - Only the record contents are compared against the newest record, so a
+ *   repeated boundary, such as the one written when a resumed step restarts,
+ *   costs no flash write.
+ *
+ * Dependencies:
+ * - journal.h (for the entry type and the reserved pages)
+ * - main.h (for Error_Handler)
+ */
+
+
+
+ #include "journal.h"
+ #include "main.h"
+
+ #if JOURNAL_ENABLE
+
+ // First address past the flash image, from the linker script's .data load symbols
+ #ifndef JOURNAL_IMAGE_END
+ extern const uint8_t _sidata[], _sdata[], _edata[];
+ #define JOURNAL_IMAGE_END  ((uintptr_t)_sidata + (uintptr_t)(_edata - _sdata))
+ #endif
+
+ #define JOURNAL_SLOTS      (FLASH_PAGE_SIZE / sizeof(uint64_t))
+ #define JOURNAL_BLANK      0xFFFFFFFFFFFFFFFFULL
+ #define JOURNAL_TAG        0x5AU
+ #define JOURNAL_NO_CYCLE   0xFFU
+ #define JOURNAL_CRC_POLY   0x07U
+
+ #define JOURNAL_SEQUENCE(record)  ((uint16_t)(record))
+ #define JOURNAL_PROGRAM(record)   ((uint8_t)((record) >> 16))
+ #define JOURNAL_STEP(record)      ((uint8_t)((record) >> 24))
+ #define JOURNAL_ELAPSED(record)   ((uint16_t)((record) >> 32))
+
+ static uint8_t currentPage = 0;
+ static uint16_t nextSlot = 0;      // First blank slot in currentPage, JOURNAL_SLOTS when full
+ static uint64_t newestRecord = 0;  // Last record written or found at boot
+ static uint8_t spareErased = 0;    // The other page is blank and ready to take over
+
+ static uint32_t Journal_Address(uint8_t page, uint16_t slot) {
+     return FLASH_BASE + (JOURNAL_FIRST_PAGE + page) * FLASH_PAGE_SIZE + slot * sizeof(uint64_t);
+ }
+
+ static uint64_t Journal_Read(uint8_t page, uint16_t slot) {
+     return *(const volatile uint64_t *)(uintptr_t)Journal_Address(page, slot);
+ }
+
+ // CRC-8 (x^8 + x^2 + x + 1) over the seven payload bytes, low byte first
+ static uint8_t Journal_Crc(uint64_t record) {
+     uint8_t crc = 0;
+
+     for (uint8_t i = 0; i < 7; i++) {
+         crc ^= (uint8_t)(record >> (8 * i));
+         for (uint8_t bit = 0; bit < 8; bit++) {
+             crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ JOURNAL_CRC_POLY) : (uint8_t)(crc << 1);
+         }
+     }
+     return crc;
+ }
+
+ static uint64_t Journal_Encode(uint16_t sequence, uint8_t program, uint8_t step, uint16_t elapsed) {
+     uint64_t record = (uint64_t)sequence | ((uint64_t)program << 16) | ((uint64_t)step << 24) |
+                       ((uint64_t)elapsed << 32) | ((uint64_t)JOURNAL_TAG << 48);
+
+     return record | ((uint64_t)Journal_Crc(record) << 56);
+ }
+
+ static uint8_t Journal_IsValid(uint64_t record) {
+     return (uint8_t)(record >> 48) == JOURNAL_TAG && (uint8_t)(record >> 56) == Journal_Crc(record);
+ }
+
+ // Slots fill in order, so everything from the first blank slot on is blank
+ static uint16_t Journal_FirstBlank(uint8_t page) {
+     uint16_t low = 0;
+     uint16_t high = JOURNAL_SLOTS;
+
+     while (low < high) {
+         uint16_t middle = (uint16_t)((low + high) / 2U);
+
+         if (Journal_Read(page, middle) == JOURNAL_BLANK) {
+             high = middle;
+         } else {
+             low = (uint16_t)(middle + 1U);
+         }
+     }
+     return low;
+ }
+
+ // Newest valid record before `blank`, skipping records torn by a power cut
+ static uint8_t Journal_FindNewest(uint8_t page, uint16_t blank, uint64_t *record) {
+     while (blank > 0) {
+         uint64_t candidate = Journal_Read(page, --blank);
+
+         if (Journal_IsValid(candidate)) {
+             *record = candidate;
+             return 1;
+         }
+     }
+     return 0;
+ }
+
+ static uint8_t Journal_IsBlank(uint8_t page) {
+     for (uint16_t slot = 0; slot < JOURNAL_SLOTS; slot++) {
+         if (Journal_Read(page, slot) != JOURNAL_BLANK) {
+             return 0;
+         }
+     }
+     return 1;
+ }
+
+ static HAL_StatusTypeDef Journal_ErasePage(uint8_t page) {
+     FLASH_EraseInitTypeDef erase = {0};
+     uint32_t pageError;
+
+     erase.TypeErase = FLASH_TYPEERASE_PAGES;
+     erase.Page = JOURNAL_FIRST_PAGE + page;
+     erase.NbPages = 1;
+     return HAL_FLASHEx_Erase(&erase, &pageError);
+ }
+
+ static void Journal_Append(uint8_t program, uint8_t step, uint16_t elapsed) {
+     uint64_t record = Journal_Encode((uint16_t)(JOURNAL_SEQUENCE(newestRecord) + 1U), program, step, elapsed);
+     HAL_StatusTypeDef status;
+
+     if (nextSlot >= JOURNAL_SLOTS) {
+         // No erase here, it could land mid-spin; without a spare the record is lost
+         if (!spareErased) {
+             return;
+         }
+         currentPage = (uint8_t)((currentPage + 1U) % JOURNAL_PAGES);
+         nextSlot = 0;
+         spareErased = 0;
+     }
+     status = HAL_FLASH_Unlock();
+     if (status == HAL_OK) {
+         status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, Journal_Address(currentPage, nextSlot), record);
+     }
+     HAL_FLASH_Lock();
+
+     if (status == HAL_OK) {
+         newestRecord = record;
+         nextSlot++;
+     } else {
+         // Unusable slot or page: the next record starts the other page
+         nextSlot = JOURNAL_SLOTS;
+     }
+ }
+
+ uint8_t Journal_Init(JournalEntry *entry) {
+     uint8_t found = 0;
+
+     if (JOURNAL_IMAGE_END > Journal_Address(0, 0)) {
+         // Erasing a journal page would erase code
+         Error_Handler();
+     }
+
+     for (uint8_t page = 0; page < JOURNAL_PAGES; page++) {
+         uint16_t blank = Journal_FirstBlank(page);
+         uint64_t record;
+
+         if (Journal_FindNewest(page, blank, &record) &&
+             (!found || (int16_t)(JOURNAL_SEQUENCE(record) - JOURNAL_SEQUENCE(newestRecord)) > 0)) {
+             found = 1;
+             newestRecord = record;
+             currentPage = page;
+             nextSlot = blank;
+         }
+     }
+     if (!found) {
+         // Blank journal: behave as if the last cycle had ended
+         newestRecord = Journal_Encode(0, JOURNAL_NO_CYCLE, 0, 0);
+         currentPage = 0;
+         nextSlot = Journal_FirstBlank(0);
+     }
+     spareErased = Journal_IsBlank((uint8_t)((currentPage + 1U) % JOURNAL_PAGES));
+     if (!found) {
+         return 0;
+     }
+     if (JOURNAL_PROGRAM(newestRecord) == JOURNAL_NO_CYCLE) {
+         return 0;
+     }
+     entry->programIndex = JOURNAL_PROGRAM(newestRecord);
+     entry->stepIndex = JOURNAL_STEP(newestRecord);
+     entry->elapsedSeconds = JOURNAL_ELAPSED(newestRecord);
+     return 1;
+ }
+
+ void Journal_Prepare(void) {
+     uint8_t spare = (uint8_t)((currentPage + 1U) % JOURNAL_PAGES);
+
+     // Until the current page holds a record the spare may still hold the newest one
+     if (spareErased || nextSlot == 0) {
+         return;
+     }
+     if (HAL_FLASH_Unlock() == HAL_OK && Journal_ErasePage(spare) == HAL_OK) {
+         spareErased = 1;
+     }
+     HAL_FLASH_Lock();
+ }
+
+ void Journal_Record(const JournalEntry *entry) {
+     if (entry->programIndex != JOURNAL_PROGRAM(newestRecord) || entry->stepIndex != JOURNAL_STEP(newestRecord) ||
+         entry->elapsedSeconds != JOURNAL_ELAPSED(newestRecord)) {
+         Journal_Append(entry->programIndex, entry->stepIndex, entry->elapsedSeconds);
+     }
+ }
+
+ void Journal_Clear(void) {
+     if (JOURNAL_PROGRAM(newestRecord) != JOURNAL_NO_CYCLE) {
+         Journal_Append(JOURNAL_NO_CYCLE, 0, 0);
+     }
+ }
+
+ #endif // JOURNAL_ENABLE
@@ -7,35 +7,81 @@
  * 
  * Functionality:
  * - Initializes the HAL library, system clock, GPIO, ADC, RTC, SPI display, and washer control.
- * - Monitors button inputs for Start, Stop, Up, and Down buttons.
- * - Manages program selection and controls washer state transitions based on user input.
- * - Periodically updates the washer operation state through `Washer_Update()`.
+ * - Boots in stages (boot.h): outputs forced off and buttons armed first, then the ADC
+ *   calibration, the RTC clock start and the panel clear run side by side in the
+ *   background, advanced from the main loop by `Boot_Service()`. When the last one
+ *   finishes, `Washer_Resume()` picks up a cycle cut by a power loss.
+ * - Configures the Start, Stop, Up and Down buttons as EXTI falling-edge interrupts that wake
+ *   the debouncer in button.c, which scans them from TIM17 and posts clean button events.
+ * - Runs the periodic work from a static task table through the cooperative scheduler
+ *   (scheduler.c), ticked by TIM16. Each task has its own period and deadline; table
+ *   order is priority. Speed, control, sensors and mixer are critical; display, flush
+ *   and profile are sheddable and wait while a critical task is due (scheduler.h):
+ *   - Speed (`SPEED_PERIOD_MS`): `Speed_Control()`, the spin PI loop (fixed rate, first).
+ *   - Control (`CONTROL_PERIOD_MS`): `Washer_Update()`.
+ *   - Sensors (`SENSOR_PERIOD_MS`): `ADC_Process()`.
+ *   - Mixer (`MIXER_PERIOD_MS`): `Mixer_Update()`, hot/cold valve time-proportioning.
+ *   - Display (`DISPLAY_PERIOD_MS`): `Display_UpdateWasherState()` into the framebuffer.
+ *   - Flush (`FLUSH_PERIOD_MS`): `Display_Flush()`, which sends only changed regions, so
+ *     button feedback appears quickly and an unchanged screen costs no SPI traffic.
  * 
  * Global Variables:
- * - `selectedProgram`: Tracks the currently selected washing program (0-29).
  * - `washer`: Structure holding the current washer state, program index, step index, timer, and motor direction.
+ *   Static, and only touched from the main loop (event handlers and tasks); interrupts
+ *   reach it through the event rings, so it needs no locking. Other readers (the
+ *   display task) use the `Washer_GetStatus()` snapshot.
+ * - `htim16`: Scheduler tick timer, one update interrupt every `SCHEDULER_TICK_MS`.
+ * - `taskTable`: Const task table (period and priority of each task).
  * 
  * Main Loop Tasks:
- * - Detects button presses:
- *   - Start: Begins the fill water process if the washer is idle.
- *   - Stop: Returns washer to idle state.
- *   - Up: Increments the selected program index (if below maximum).
- *   - Down: Decrements the selected program index (if above zero).
- * - Calls `Washer_Update()` to advance the washer's state machine as needed.
- * - Introduces a 100ms delay between iterations for simple button debouncing and pacing.
+ * - Drains the event rings (one per interrupt source, event.h):
+ *   - `EVENT_BUTTON`: Button + action (press, release, long press, repeat) passed to
+ *     `Washer_HandleButtonPress()` (start, stop, program up/down).
+ *   - `EVENT_CLOCK`: Posted by the RTC once per second; `Display_UpdateTime()` redraws
+ *     the changed clock digits into the framebuffer once `Scheduler_HasRoom()` allows
+ *     `CLOCK_BUDGET_MS`. A deferred redraw waits for a later wakeup; it reads the RTC
+ *     when it runs, so a late one still shows the right time.
+ *   - `EVENT_STEP_TIMER`: TIM14 fill / step deadline, passed to `Washer_HandleStepTimer()`.
+ * - Runs the highest-priority ready task, then checks for events again.
+ * - Profiles every event handler, task and interrupt, plus each wakeup-to-sleep pass
+ *   (profile.h); a long press of Stop dumps the table, with the scheduler's deadline
+ *   miss and shed counts, over USART2.
+ * - Enters sleep (WFI) with interrupts masked once nothing is pending, so a button press is
+ *   handled within one interrupt latency instead of up to one 100ms polling period.
+ *   While the washer is IDLE the sleep is Stop mode instead, woken by the RTC second
+ *   alarm, a button edge or a Modbus start bit (power.h).
+ * - Answers the site controller's Modbus RTU status polls on RS-485 (modbus.h),
+ *   entirely in the USART1 interrupt; the loop and the tasks never see the bus.
+ * - Runs the core at 48 MHz while spinning or while the display has a refresh pending,
+ *   at 24 MHz otherwise (`Power_Update()`).
  * 
  * Functions:
  * - `main(void)`: Initializes the system and enters the infinite control loop.
- * - `SystemClock_Config(void)`: Configures the system clock to use HSE (external oscillator) without PLL.
- * - `Error_Handler(void)`: Blinks an LED on GPIOB pin 0 at 500ms intervals when a critical error occurs.
+ * - `SystemClock_Config(void)`: Starts the system clock on HSI48 at the fast level (`Power_Init()`).
+ * - `GPIO_Init(void)`: Configures outputs (forced off) and button EXTI lines; `Motor_Init()`
+ *   later hands the motor pins to TIM3.
+ * - `Timer_Init(void)`: Starts the TIM16 scheduler tick.
+ * - `Error_Handler(void)`: Masks interrupts, forces the motor and valves off (TIM3 stopped at
+ *   0%, ramp and ADC DMA aborted, PB0-PB3 back to GPIO low) and lights the status LED; never returns.
  * 
  * Dependencies:
- * - `main.h`, `spi.h`, `washer.h`, `font.h`, `display.h`, `gpio.h`, `adc.h`, `rtc.h`
+ * - `main.h`, `spi.h`, `washer.h`, `display.h`, `event.h`, `button.h`, `scheduler.h`, `adc.h`, `rtc.h`, `steptimer.h`, `motor.h`, `speed.h`, `balance.h`, `mixer.h`, `profile.h`, `bench.h`, `ramfunc.h`, `power.h`, `boot.h`, `modbus.h`
  * 
  * Notes:
- * - Button inputs are active-low (pressed state reads as `GPIO_PIN_RESET`).
- * - System initialization sequence is critical before entering the main loop.
- * - `Error_Handler` provides basic fault indication via an LED blink pattern.
+ * - Button inputs are active-low (pressed state reads as `GPIO_PIN_RESET`), hence falling-edge EXTI.
+ *   Debouncing, long press and auto-repeat timing all live in button.c.
+ * - System initialization sequence is critical before entering the main loop. Nothing
+ *   before `Boot_Start()` waits on hardware, which bounds the time to safe outputs;
+ *   the profiler records it as `boot-safe`, and the end of the boot as `boot-ready`.
+ * - Until the boot has finished the display is not flushed (the panel is still
+ *   clearing), button events are not passed to the washer, and the core does not
+ *   enter Stop mode (SysTick times the boot stages and the ADC DMA must keep running).
+ * - SysTick keeps running for `HAL_GetTick()`, so the core also wakes briefly every millisecond,
+ *   except in Stop mode, where it is suspended and `HAL_GetTick()` stands still.
+ * - `Error_Handler` puts every actuator in its safe state first and only then signals the
+ *   fault on `STATUS_LED_PIN`, which drives no actuator.
+ * - Built with `BENCH_IMAGE` 1, the firmware stops after the display setup and runs the
+ *   benchmarks in bench.c instead of the washer.
  */
 
 
@@ -43,87 +89,316 @@
  #include "main.h"
  #include "spi.h"
  #include "washer.h"
- #include "font.h"
  #include "display.h"
- #include "gpio.h"
+ #include "event.h"
+ #include "button.h"
+ #include "scheduler.h"
  #include "adc.h"
  #include "rtc.h"
+ #include "steptimer.h"
+ #include "motor.h"
+ #include "speed.h"
+ #include "balance.h"
+ #include "mixer.h"
+ #include "profile.h"
+ #include "bench.h"
+ #include "ramfunc.h"
+ #include "power.h"
+ #include "boot.h"
+ #include "modbus.h"
  
  // Global variables
- int selectedProgram = 0;
- WasherControl washer = {IDLE, 0, 0, 0, 0};
+ static WasherControl washer = {IDLE, 0, 0, 0, FORWARD, 0, 0, 0, 0, 0, 0, 0, WASHER_FAULT_NONE};
+ static uint8_t clockPending = 0;  // EVENT_CLOCK seen, redraw deferred
+ TIM_HandleTypeDef htim16;
+ 
+ static void Task_Speed(void) {
+     Speed_Control();
+ }
+ 
+ static void Task_Control(void) {
+     Washer_Update(&washer);
+ }
+ 
+ static void Task_Sensors(void) {
+     ADC_Process();
+ }
+ 
+ static void Task_Mixer(void) {
+     Mixer_Update();
+ }
+ 
+ static void Task_Display(void) {
+     WasherStatus status;
+ 
+     Washer_GetStatus(&status);
+     Display_UpdateWasherState(status.state, status.programIndex);
+ }
+ 
+ static void Task_DisplayFlush(void) {
+     // The panel accepts data once its clear command has run
+     if (Boot_IsDone()) {
+         Display_Flush();
+     }
+ }
+ 
+ static void Task_Profile(void) {
+     Profile_Service();
+ }
+ 
+ // Task table, highest priority first
+ static const SchedulerTask taskTable[] = {
+     {Task_Speed,        SCHEDULER_MS(SPEED_PERIOD_MS),   SCHEDULER_MS(SPEED_DEADLINE_MS),
+      SCHEDULER_CRITICAL,  0,                              "speed"},
+     {Task_Control,      SCHEDULER_MS(CONTROL_PERIOD_MS), SCHEDULER_MS(CONTROL_DEADLINE_MS),
+      SCHEDULER_CRITICAL,  0,                              "control"},
+     {Task_Sensors,      SCHEDULER_MS(SENSOR_PERIOD_MS),  SCHEDULER_MS(SENSOR_DEADLINE_MS),
+      SCHEDULER_CRITICAL,  0,                              "sensors"},
+     {Task_Mixer,        SCHEDULER_MS(MIXER_PERIOD_MS),   SCHEDULER_MS(MIXER_DEADLINE_MS),
+      SCHEDULER_CRITICAL,  0,                              "mixer"},
+     {Task_Display,      SCHEDULER_MS(DISPLAY_PERIOD_MS), SCHEDULER_MS(DISPLAY_DEADLINE_MS),
+      SCHEDULER_SHEDDABLE, SCHEDULER_MS(DISPLAY_BUDGET_MS), "display"},
+     {Task_DisplayFlush, SCHEDULER_MS(FLUSH_PERIOD_MS),   SCHEDULER_MS(FLUSH_DEADLINE_MS),
+      SCHEDULER_SHEDDABLE, SCHEDULER_MS(FLUSH_BUDGET_MS),   "flush"},
+     {Task_Profile,      SCHEDULER_MS(PROFILE_PERIOD_MS), SCHEDULER_MS(PROFILE_DEADLINE_MS),
+      SCHEDULER_SHEDDABLE, SCHEDULER_MS(PROFILE_BUDGET_MS), "profile"},
+ };
  
  int main(void) {
-     // Initialize the system
+     uint16_t awake;
+ 
+     // Safe state first: outputs off, buttons live, no waiting on hardware
      HAL_Init();
+     Profile_Init();
      SystemClock_Config();
      GPIO_Init();
+     Button_Init();
      ADC_Init();
-     RTC_Init();
+     SPI_Init();
+     Display_Init();
+ 
+     // ADC calibration, RTC clock and panel clear finish in the background (boot.h)
+     Boot_Start();
  
-     // Initialize the display
-     SPI_InitDisplay();
-     SPI_DisplayClear();
-     SPI_WriteCharacter('A');
+     // Benchmark image only: measure, print and stop here (bench.h)
+     Bench_Run();
  
      // Initialize washer
+     Motor_Init();
+     Speed_Init();
+     Balance_Init();
+     StepTimer_Init();
      Washer_Init(&washer);
  
+     // Fleet telemetry, answered from the washer's published status
+     Modbus_Init();
+ 
+     // Start the scheduler tick once everything it drives is ready
+     Scheduler_Init(taskTable, sizeof(taskTable) / sizeof(taskTable[0]));
+     Timer_Init();
+     awake = Profile_Now();
+ 
      while (1) {
-         // Handle button presses
-         if (HAL_GPIO_ReadPin(GPIOA, BUTTON_START_PIN) == GPIO_PIN_RESET) {
-             if (washer.state == IDLE) {
-                 washer.state = FILL_WATER;
-             }
-         }
+         Event event;
  
-         if (HAL_GPIO_ReadPin(GPIOA, BUTTON_STOP_PIN) == GPIO_PIN_RESET) {
-             washer.state = IDLE;
+         // Last boot stage done: the readings are real, a cut cycle can resume
+         if (Boot_Service()) {
+             Washer_Resume(&washer);
          }
  
-         if (HAL_GPIO_ReadPin(GPIOA, BUTTON_UP_PIN) == GPIO_PIN_RESET) {
-             if (selectedProgram < 29) {
-                 selectedProgram++;
+         // Full speed for spin control and display refreshes, half speed otherwise
+         Power_Update(washer.state == SPIN);
+ 
+         // Handle everything the interrupts queued since the last wakeup
+         while (Event_Get(&event)) {
+             PROFILE_BEGIN();
+             switch (event.type) {
+                 case EVENT_BUTTON:
+                     // Long press of Stop: dump the profiler table
+                     if (BUTTON_EVENT_ID(event.param) == BUTTON_STOP &&
+                         BUTTON_EVENT_ACTION(event.param) == BUTTON_LONG_PRESS) {
+                         Profile_RequestDump();
+                     }
+                     // Nothing can be started before the sensors read true
+                     if (Boot_IsDone()) {
+                         Washer_HandleButtonPress(&washer, BUTTON_EVENT_ID(event.param),
+                                                  BUTTON_EVENT_ACTION(event.param));
+                     }
+                     break;
+                 case EVENT_CLOCK:
+                     clockPending = 1;
+                     break;
+                 case EVENT_STEP_TIMER:
+                     Washer_HandleStepTimer(&washer, event.param);
+                     break;
+                 default:
+                     break;
+             }
+             // The clock redraw is recorded where it actually runs, below
+             if (event.type != EVENT_CLOCK) {
+                 PROFILE_END(PROFILE_EVENT(event.type));
              }
          }
  
-         if (HAL_GPIO_ReadPin(GPIOA, BUTTON_DOWN_PIN) == GPIO_PIN_RESET) {
-             if (selectedProgram > 0) {
-                 selectedProgram--;
-             }
+         // Clock redraw is cosmetic: only when no critical task is due within its budget
+         if (clockPending && Scheduler_HasRoom(SCHEDULER_MS(CLOCK_BUDGET_MS))) {
+             PROFILE_BEGIN();
+             clockPending = 0;
+             Display_UpdateTime();
+             PROFILE_END(PROFILE_EVENT(EVENT_CLOCK));
          }
- 99-4589676
-         // Call washer update function
-         Washer_Update(&washer);
  
-         HAL_Delay(100);
+         // One task per pass, so new button events are seen between tasks
+         if (Scheduler_RunNext()) {
+             continue;
+         }
+ 
+         // Sleep until the next interrupt; masking closes the check-then-sleep race,
+         // a pending interrupt still wakes WFI (or Stop) and runs as soon as it is unmasked
+         __disable_irq();
+         if (!Event_Pending() && !Scheduler_Pending()) {
+             Profile_Record(PROFILE_LOOP, awake);
+             Power_Sleep(washer.state == IDLE && Boot_IsDone());
+             awake = Profile_Now();
+         }
+         __enable_irq();
      }
  }
  
  void SystemClock_Config(void) {
-     RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-     RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+     // HSI48, no PLL; the run level changes later at run time (power.h)
+     Power_Init();
+ }
  
-     RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
-     RCC_OscInitStruct.HSEState = RCC_HSE_ON;
-     RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+ void GPIO_Init(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
  
-     if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK) {
+     __HAL_RCC_GPIOA_CLK_ENABLE();
+     __HAL_RCC_GPIOB_CLK_ENABLE();
+ 
+     // Motor and valve outputs, driven low (off) before the pins become outputs
+     HAL_GPIO_WritePin(OUTPUT_GPIO_PORT, MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN | WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
+     GPIO_InitStruct.Pin = MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN | WATER_HOT_PIN | WATER_COLD_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+     GPIO_InitStruct.Pull = GPIO_NOPULL;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     HAL_GPIO_Init(OUTPUT_GPIO_PORT, &GPIO_InitStruct);
+ 
+     // Active-low buttons, interrupt on the press (falling) edge
+     GPIO_InitStruct.Pin = BUTTON_START_PIN | BUTTON_STOP_PIN | BUTTON_UP_PIN | BUTTON_DOWN_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+     GPIO_InitStruct.Pull = GPIO_PULLUP;
+     HAL_GPIO_Init(BUTTON_GPIO_PORT, &GPIO_InitStruct);
+ 
+     HAL_NVIC_SetPriority(EXTI0_1_IRQn, 2, 0);
+     HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
+     HAL_NVIC_SetPriority(EXTI2_3_IRQn, 2, 0);
+     HAL_NVIC_EnableIRQ(EXTI2_3_IRQn);
+ }
+ 
+ void Timer_Init(void) {
+     __HAL_RCC_TIM16_CLK_ENABLE();
+ 
+     // 10 kHz count clock, update every SCHEDULER_TICK_MS
+     htim16.Instance = TIM16;
+     htim16.Init.Prescaler = (POWER_TIMER_HZ / 10000U) - 1U;
+     htim16.Init.CounterMode = TIM_COUNTERMODE_UP;
+     htim16.Init.Period = (SCHEDULER_TICK_MS * 10U) - 1U;
+     htim16.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+     htim16.Init.RepetitionCounter = 0;
+     htim16.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+     if (HAL_TIM_Base_Init(&htim16) != HAL_OK) {
          Error_Handler();
      }
  
-     RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK;
-     RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSE;
- 
-     if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK) {
+     HAL_NVIC_SetPriority(TIM16_IRQn, 2, 0);
+     HAL_NVIC_EnableIRQ(TIM16_IRQn);
+     if (HAL_TIM_Base_Start_IT(&htim16) != HAL_OK) {
          Error_Handler();
      }
  }
  
+ // Any button edge starts the debouncer scan; it posts the button events itself
+ void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin) {
+     if (GPIO_Pin & (BUTTON_START_PIN | BUTTON_STOP_PIN | BUTTON_UP_PIN | BUTTON_DOWN_PIN)) {
+         Button_Wake();
+     }
+ }
+ 
+ RAMFUNC void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+     if (htim->Instance == TIM16) {
+         Scheduler_Tick();
+     } else if (htim->Instance == TIM14) {
+         StepTimer_Elapsed();
+     } else if (htim->Instance == TIM1) {
+         Speed_Overflow();
+     } else if (htim->Instance == TIM17) {
+         Button_Scan();
+     }
+ }
+ 
+ RAMFUNC void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) {
+     if (htim->Instance == TIM1 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_4) {
+         Speed_Capture();
+     }
+ }
+ 
+ void EXTI0_1_IRQHandler(void) {
+     HAL_GPIO_EXTI_IRQHandler(BUTTON_START_PIN);
+     HAL_GPIO_EXTI_IRQHandler(BUTTON_STOP_PIN);
+ }
+ 
+ void EXTI2_3_IRQHandler(void) {
+     HAL_GPIO_EXTI_IRQHandler(BUTTON_UP_PIN);
+     HAL_GPIO_EXTI_IRQHandler(BUTTON_DOWN_PIN);
+ }
+ 
+ // DMA channel 2 (display SPI) and channel 3 (motor ramps) share one vector
+ RAMFUNC void DMA1_Channel2_3_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_DMA_IRQHandler(&hdma_spi1_tx);
+     HAL_DMA_IRQHandler(&hdma_tim3_up);
+     PROFILE_END(PROFILE_ISR_DMA2_3);
+ }
+ 
+ RAMFUNC void TIM16_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_TIM_IRQHandler(&htim16);
+     PROFILE_END(PROFILE_ISR_TICK);
+ }
+ 
+ // Also reached before GPIO_Init() or Motor_Init() (clock setup), so nothing here
+ // assumes a peripheral is running; registers of an unclocked TIM3 ignore writes
  void Error_Handler(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+     // No task, ramp or ISR may drive an output again
+     __disable_irq();
+
+     // Motor: stop TIM3 at 0% (HAL's disable waits for the channels to be off) and
+     // cancel any ramp, then take the pins back from the timer
+     TIM3->CR1 &= ~TIM_CR1_CEN;
+     TIM3->CCR3 = 0;
+     TIM3->CCR4 = 0;
+     if (hdma_tim3_up.State == HAL_DMA_STATE_BUSY) {
+         HAL_DMA_Abort(&hdma_tim3_up);
+     }
+     if (hdma_adc1.State == HAL_DMA_STATE_BUSY) {
+         HAL_DMA_Abort(&hdma_adc1);
+     }
+
+     __HAL_RCC_GPIOB_CLK_ENABLE();
+     HAL_GPIO_WritePin(OUTPUT_GPIO_PORT, MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN | WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
+     HAL_GPIO_WritePin(STATUS_LED_GPIO_PORT, STATUS_LED_PIN, GPIO_PIN_SET);
+     GPIO_InitStruct.Pin = MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN | WATER_HOT_PIN | WATER_COLD_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+     GPIO_InitStruct.Pull = GPIO_NOPULL;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     HAL_GPIO_Init(OUTPUT_GPIO_PORT, &GPIO_InitStruct);
+     GPIO_InitStruct.Pin = STATUS_LED_PIN;
+     HAL_GPIO_Init(STATUS_LED_GPIO_PORT, &GPIO_InitStruct);
+
+     // SysTick is masked with everything else, so the LED stays lit instead of blinking
      while (1) {
-         HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_0);
-         HAL_Delay(500);
      }
  }
- 
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file mixer.c
+ * @brief PI hot/cold valve time-proportioning for the fill phase.
+ *
+ * This source file implements the mixer declared in mixer.h.
+ *
+ * Details:
+ * - The first `hotShare / 256` of every window has the hot valve open, the rest
+ *   the cold valve, so the inflow rate stays constant and only its temperature
+ *   changes. The valve pattern is resolved to the mixer task period.
+ * - At each window boundary the PI computes the next share:
+ *   share = Kp * error + integral, with error = target - measured in 0.1 °C.
+ *   The integral is Q12 so small errors still accumulate, and it only grows
+ *   while the share is not saturated in the error's direction (anti-windup).
+ * - The integral starts at `MIXER_START_SHARE_Q8`, so the first window is a
+ *   plain mix rather than a burst of one valve.
+ * - Valve writes happen with interrupts masked and only while the step timer's
+ *   fill deadline is running, so the deadline interrupt always has the last word.
+ *
+ * Dependencies:
+ * - mixer.h (for the gains and prototypes)
+ * - main.h (for the valve pins)
+ * - adc.h (for `Read_Temperature()`)
+ * - program.h (for `PROGRAM_TEMP_COLD`)
+ * - steptimer.h (for `StepTimer_Running()`)
+ */
+
+
+
+ #include "mixer.h"
+ #include "main.h"
+ #include "adc.h"
+ #include "program.h"
+ #include "steptimer.h"
+
+ #define MIXER_SHARE_MAX     256
+ #define MIXER_INTEGRAL_MAX  (MIXER_SHARE_MAX << 4)  // Q12
+
+ static uint8_t active = 0;
+ static int16_t target = PROGRAM_TEMP_COLD;
+ static uint32_t windowStart = 0;
+ static int32_t hotShare = 0;    // Q8 of the window
+ static int32_t integral = 0;    // Q12
+
+ static void Mixer_SetValves(GPIO_PinState hot, GPIO_PinState cold) {
+     HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN, hot);
+     HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_COLD_PIN, cold);
+ }
+
+ // One PI iteration at the start of a window
+ static void Mixer_Control(void) {
+     int32_t error = (int32_t)target - Read_Temperature();
+     int32_t share;
+
+     if (target == PROGRAM_TEMP_COLD) {
+         hotShare = 0;
+         return;
+     }
+
+     share = MIXER_KP_Q8 * error + (integral >> 4);
+     if (!((share >= MIXER_SHARE_MAX && error > 0) || (share <= 0 && error < 0))) {
+         integral += MIXER_KI_Q12 * error;
+         if (integral > MIXER_INTEGRAL_MAX) {
+             integral = MIXER_INTEGRAL_MAX;
+         } else if (integral < 0) {
+             integral = 0;
+         }
+     }
+
+     if (share > MIXER_SHARE_MAX) {
+         share = MIXER_SHARE_MAX;
+     } else if (share < 0) {
+         share = 0;
+     }
+     hotShare = share;
+ }
+
+ void Mixer_Start(int16_t temperature) {
+     target = temperature;
+     integral = (int32_t)MIXER_START_SHARE_Q8 << 4;
+     windowStart = HAL_GetTick();
+     Mixer_Control();
+     active = 1;
+     Mixer_Update();
+ }
+
+ void Mixer_Stop(void) {
+     active = 0;
+     Mixer_SetValves(GPIO_PIN_RESET, GPIO_PIN_RESET);
+ }
+
+ void Mixer_Update(void) {
+     uint32_t now = HAL_GetTick();
+     uint32_t hotMs;
+     GPIO_PinState hot;
+
+     if (!active) {
+         return;
+     }
+     if (now - windowStart >= MIXER_WINDOW_MS) {
+         windowStart = now;
+         Mixer_Control();
+     }
+
+     // Hot for the first part of the window, cold for the rest
+     hotMs = ((uint32_t)hotShare * MIXER_WINDOW_MS) >> 8;
+     hot = (now - windowStart < hotMs) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+
+     __disable_irq();
+     if (active && StepTimer_Running()) {
+         Mixer_SetValves(hot, hot == GPIO_PIN_SET ? GPIO_PIN_RESET : GPIO_PIN_SET);
+     }
+     __enable_irq();
+ }
+
+ uint16_t Mixer_GetHotShare(void) {
+     return (uint16_t)hotShare;
+ }
@@ -0,0 +1,287 @@
+/**
+ * @file modbus.c
+ * @brief Interrupt-driven Modbus RTU slave: idle-line framing, read requests, replies.
+ *
+ * This source file implements the Modbus interface declared in modbus.h.
+ *
+ * Details:
+ * - USART1 receives each frame straight into the frame buffer, one byte per
+ *   receive interrupt (`HAL_UARTEx_ReceiveToIdle_IT()`); the idle line ends the
+ *   frame and reception restarts in the same interrupt. A frame that fills the
+ *   buffer is dropped along with the rest of it, up to the next idle line;
+ *   every request this slave implements is 8 bytes. A frame of exactly
+ *   `MODBUS_FRAME_SIZE` bytes leaves no rest, so the frame after it is dropped
+ *   instead and the master's retry is answered.
+ * - At the idle event the frame is checked and answered in the same interrupt:
+ *   address byte first (anything for another unit stops there), then the CRC,
+ *   then function and register range. The reply is built from one
+ *   `Washer_GetStatus()` copy, which never waits on the control path, and sent
+ *   with `HAL_UART_Transmit_IT()`. Bad requests get the standard exception
+ *   replies (illegal function, address or value); broadcasts are never answered.
+ * - Bytes that arrive while a reply is going out (the transceiver's own echo,
+ *   if its receiver stays enabled) are dropped with the frame they end up in.
+ * - A parity, framing or noise error drops the frame it hits. An overrun stops
+ *   the reception; the error callback counts it and listens again.
+ * - The start-bit wakeup interrupt is only enabled across Stop mode; in run mode
+ *   it would fire on every character on the bus, other units' included.
+ * - The CRC is computed bit by bit (no table in flash): about 100 cycles per
+ *   byte, some 0.15 ms for a request and a full reply at the slow clock.
+ *
+ * Dependencies:
+ * - modbus.h (for the register map, pins and prototypes)
+ * - main.h (for `Error_Handler()`)
+ * - washer.h (for the status snapshot)
+ * - profile.h (for the USART1 interrupt probe)
+ */
+
+
+
+ #include "modbus.h"
+ #include "main.h"
+
+ #if MODBUS_ENABLE
+
+ #include "washer.h"
+ #include "profile.h"
+
+ #define MODBUS_FRAME_SIZE       32U   // Longest frame kept
+ #define MODBUS_TX_SIZE          (5U + 2U * MODBUS_REG_COUNT)
+ #define MODBUS_DE_TIME          16U   // DE assert / deassert time, in 1/16 bit
+ #define MODBUS_READ_MAX         125U  // Registers per read (protocol limit)
+
+ #define MODBUS_FN_READ_HOLDING  0x03U
+ #define MODBUS_FN_READ_INPUT    0x04U
+ #define MODBUS_EX_FUNCTION      0x01U
+ #define MODBUS_EX_ADDRESS       0x02U
+ #define MODBUS_EX_VALUE         0x03U
+ #define MODBUS_CRC_POLY         0xA001U  // 0x8005, bit reversed
+
+ UART_HandleTypeDef huart1;
+
+ static uint8_t frame[MODBUS_FRAME_SIZE];
+ static uint8_t txBuffer[MODBUS_TX_SIZE];
+ static uint8_t dropFrame = 0;  // The frame being received is answered by no one
+ static volatile uint8_t transmitting = 0;
+ static uint16_t requestCount = 0;
+ static uint16_t errorCount = 0;
+
+ // CRC-16/MODBUS (reflected 0x8005, initial value 0xFFFF)
+ static uint16_t Modbus_Crc(const uint8_t *data, uint16_t length) {
+     uint16_t crc = 0xFFFFU;
+
+     for (uint16_t i = 0; i < length; i++) {
+         crc ^= data[i];
+         for (uint8_t bit = 0; bit < 8; bit++) {
+             crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ MODBUS_CRC_POLY) : (uint16_t)(crc >> 1);
+         }
+     }
+     return crc;
+ }
+
+ // Append the CRC, low byte first; returns the reply length
+ static uint16_t Modbus_Finish(uint16_t length) {
+     uint16_t crc = Modbus_Crc(txBuffer, length);
+
+     txBuffer[length] = (uint8_t)crc;
+     txBuffer[length + 1U] = (uint8_t)(crc >> 8);
+     return (uint16_t)(length + 2U);
+ }
+
+ static uint16_t Modbus_Exception(uint8_t function, uint8_t code) {
+     txBuffer[0] = MODBUS_ADDRESS;
+     txBuffer[1] = (uint8_t)(function | 0x80U);
+     txBuffer[2] = code;
+     return Modbus_Finish(3);
+ }
+
+ static uint16_t Modbus_Register(uint16_t index, const WasherStatus *status) {
+     switch (index) {
+         case MODBUS_REG_STATE:       return (uint16_t)status->state;
+         case MODBUS_REG_PROGRAM:     return (uint16_t)(status->programIndex + 1U);
+         case MODBUS_REG_STEP:        return status->stepIndex;
+         case MODBUS_REG_REMAINING:   return status->remainingSeconds;
+         case MODBUS_REG_TEMPERATURE: return (uint16_t)status->temperature;
+         case MODBUS_REG_RPM:         return status->rpm;
+         case MODBUS_REG_LEVEL:       return status->waterLevel;
+         case MODBUS_REG_FAULT:       return status->fault;
+         case MODBUS_REG_REQUESTS:    return requestCount;
+         case MODBUS_REG_ERRORS:      return errorCount;
+         default:                     return 0;
+     }
+ }
+
+ // Check a received frame; returns the reply length, 0 for no reply
+ static uint16_t Modbus_Reply(uint16_t frameLength) {
+     WasherStatus status;
+     uint16_t crc;
+     uint16_t start;
+     uint16_t count;
+     uint8_t function;
+
+     // Another unit's frame (or a broadcast) is not even checked
+     if (frameLength < 4U || frameLength > MODBUS_FRAME_SIZE || frame[0] != MODBUS_ADDRESS) {
+         return 0;
+     }
+     crc = Modbus_Crc(frame, (uint16_t)(frameLength - 2U));
+     if (frame[frameLength - 2U] != (uint8_t)crc || frame[frameLength - 1U] != (uint8_t)(crc >> 8)) {
+         errorCount++;
+         return 0;
+     }
+     requestCount++;
+
+     function = frame[1];
+     if (function != MODBUS_FN_READ_HOLDING && function != MODBUS_FN_READ_INPUT) {
+         return Modbus_Exception(function, MODBUS_EX_FUNCTION);
+     }
+     start = (uint16_t)((frame[2] << 8) | frame[3]);
+     count = (uint16_t)((frame[4] << 8) | frame[5]);
+     if (frameLength != 8U || count == 0 || count > MODBUS_READ_MAX) {
+         return Modbus_Exception(function, MODBUS_EX_VALUE);
+     }
+     if (start >= MODBUS_REG_COUNT || count > MODBUS_REG_COUNT - start) {
+         return Modbus_Exception(function, MODBUS_EX_ADDRESS);
+     }
+
+     Washer_GetStatus(&status);
+     txBuffer[0] = MODBUS_ADDRESS;
+     txBuffer[1] = function;
+     txBuffer[2] = (uint8_t)(2U * count);
+     for (uint16_t i = 0; i < count; i++) {
+         uint16_t value = Modbus_Register((uint16_t)(start + i), &status);
+
+         txBuffer[3U + 2U * i] = (uint8_t)(value >> 8);
+         txBuffer[4U + 2U * i] = (uint8_t)value;
+     }
+     return Modbus_Finish((uint16_t)(3U + 2U * count));
+ }
+
+ // Bytes of the current frame received so far
+ static uint16_t Modbus_Received(void) {
+     return (uint16_t)(huart1.RxXferSize - huart1.RxXferCount);
+ }
+
+ // (Re)start reception of the next frame
+ static HAL_StatusTypeDef Modbus_Listen(void) {
+     return HAL_UARTEx_ReceiveToIdle_IT(&huart1, frame, MODBUS_FRAME_SIZE);
+ }
+
+ void Modbus_Init(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+     RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+     UART_WakeUpTypeDef wakeUp = {0};
+
+     // HSIKER rather than PCLK: it keeps the receiver clocked in Stop mode
+     PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART1;
+     PeriphClkInit.Usart1ClockSelection = RCC_USART1CLKSOURCE_HSIKER;
+     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK) {
+         Error_Handler();
+     }
+     __HAL_RCC_USART1_CLK_ENABLE();
+     __HAL_RCC_GPIOA_CLK_ENABLE();
+
+     // RX pulled up: a transceiver with its receiver off leaves RO floating
+     GPIO_InitStruct.Pin = MODBUS_TX_PIN | MODBUS_RX_PIN | MODBUS_DE_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+     GPIO_InitStruct.Pull = GPIO_PULLUP;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
+     HAL_GPIO_Init(MODBUS_GPIO_PORT, &GPIO_InitStruct);
+
+     // 8 data bits plus even parity make a 9-bit word
+     huart1.Instance = USART1;
+     huart1.Init.BaudRate = MODBUS_BAUD;
+     huart1.Init.WordLength = UART_WORDLENGTH_9B;
+     huart1.Init.StopBits = UART_STOPBITS_1;
+     huart1.Init.Parity = UART_PARITY_EVEN;
+     huart1.Init.Mode = UART_MODE_TX_RX;
+     huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+     huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+     if (HAL_RS485Ex_Init(&huart1, UART_DE_POLARITY_HIGH, MODBUS_DE_TIME, MODBUS_DE_TIME) != HAL_OK) {
+         Error_Handler();
+     }
+
+     // A start bit wakes the core from Stop mode (armed by Modbus_SetWakeup()) in
+     // time to take the byte in the receive interrupt
+     wakeUp.WakeUpEvent = UART_WAKEUP_ON_STARTBIT;
+     if (HAL_UARTEx_StopModeWakeUpSourceConfig(&huart1, wakeUp) != HAL_OK) {
+         Error_Handler();
+     }
+     HAL_UARTEx_EnableStopMode(&huart1);
+
+     // Lowest priority: a busy bus must never delay the control interrupts
+     HAL_NVIC_SetPriority(USART1_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(USART1_IRQn);
+
+     if (Modbus_Listen() != HAL_OK) {
+         Error_Handler();
+     }
+ }
+
+ // BUSY covers the first character, before the receive interrupt has taken it
+ uint8_t Modbus_IsBusy(void) {
+     return transmitting || Modbus_Received() != 0 || __HAL_UART_GET_FLAG(&huart1, UART_FLAG_BUSY);
+ }
+
+ void Modbus_SetWakeup(uint8_t enable) {
+     if (enable) {
+         // A start bit seen since the last Stop would wake the core at once
+         __HAL_UART_CLEAR_FLAG(&huart1, UART_CLEAR_WUF);
+         __HAL_UART_ENABLE_IT(&huart1, UART_IT_WUF);
+     } else {
+         __HAL_UART_DISABLE_IT(&huart1, UART_IT_WUF);
+     }
+ }
+
+ // Idle line (end of frame) or full buffer (frame too long); reception has stopped
+ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+     uint16_t length = 0;
+
+     if (huart->Instance != USART1) {
+         return;
+     }
+     if (HAL_UARTEx_GetRxEventType(huart) != HAL_UART_RXEVENT_IDLE) {
+         dropFrame = 1;
+     } else {
+         if (!dropFrame && !transmitting) {
+             length = Modbus_Reply(Size);
+         }
+         dropFrame = 0;
+     }
+     Modbus_Listen();
+     if (length > 0 && HAL_UART_Transmit_IT(&huart1, txBuffer, length) == HAL_OK) {
+         transmitting = 1;
+     }
+ }
+
+ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+     if (huart->Instance != USART1) {
+         return;
+     }
+     // Anything received up to the last stop bit was our own echo
+     if (Modbus_Received() != 0) {
+         dropFrame = 1;
+     }
+     transmitting = 0;
+ }
+
+ // An overrun stops the reception; the other errors leave it running mid-frame
+ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+     if (huart->Instance != USART1) {
+         return;
+     }
+     errorCount++;
+     if (huart->RxState == HAL_UART_STATE_READY) {
+         dropFrame = 0;
+         Modbus_Listen();
+     } else {
+         dropFrame = 1;
+     }
+ }
+
+ void USART1_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_UART_IRQHandler(&huart1);
+     PROFILE_END(PROFILE_ISR_MODBUS);
+ }
+
+ #endif // MODBUS_ENABLE
@@ -0,0 +1,386 @@
+/**
+ * @file motor.c
+ * @brief TIM3 PWM motor driver with DMA ramp playback.
+ *
+ * This source file implements the motor driver declared in motor.h.
+ *
+ * Details:
+ * - TIM3 runs at `MOTOR_PWM_HZ` with an auto-reload of `MOTOR_DUTY_MAX - 1`, so a
+ *   compare value equals the duty in 1/255 steps (255 = fully on). CH3 drives the
+ *   forward speed input, CH4 the reverse one; the idle channel is held at 0.
+ * - A ramp is a slice of a const S-curve table in flash. The TIM3 update event
+ *   requests DMA1 channel 3, which copies one byte into the active CCR (zero
+ *   extended to 16 bits) per PWM period; compare preload makes each value take
+ *   effect on a period boundary.
+ * - The slice is found by binary search for the current and target duty in the
+ *   monotonic table, so ramps start from wherever the motor is and end at any duty.
+ * - The DMA completion interrupt writes the exact target duty and starts the
+ *   next pending request (after a ramp to zero, the other direction).
+ * - `Motor_SetDuty()` bypasses the ramps for the speed loop; it also records the
+ *   duty as the request (with the spin profile), so the `Motor_Stop()` that
+ *   ends a spin brakes along the spin ramp from the exact output. It refuses a
+ *   direction change while the other direction is driven or a ramp plays.
+ * - Callers only ever change the requested direction/duty/profile; `Motor_Next()`
+ *   runs with interrupts masked or from the DMA interrupt, never both at once.
+ *
+ * Dependencies:
+ * - motor.h (for the driver constants and prototypes)
+ * - main.h (for the motor pins and `Error_Handler()`)
+ * - ramfunc.h (for the SRAM placement of the ramp completion)
+ * - power.h (for the timer clock)
+ */
+
+
+
+ #include "motor.h"
+ #include "main.h"
+ #include "ramfunc.h"
+ #include "power.h"
+
+ // rpm -> duty scale in Q16, so the conversion is a multiply and a shift
+ #define MOTOR_DUTY_PER_RPM_Q16  ((MOTOR_DUTY_MAX << 16) / MOTOR_MAX_RPM)
+
+ TIM_HandleTypeDef htim3;
+ DMA_HandleTypeDef hdma_tim3_up;
+
+ // Soft start: S-curve 0 -> MOTOR_DUTY_MAX over 128 PWM periods (~0.26 s)
+ static const uint8_t softUp[] = {
+       0,   0,   0,   0,   1,   1,   2,   2,   3,   4,   4,   5,   6,   7,   9,  10,
+      11,  12,  14,  15,  17,  19,  20,  22,  24,  26,  28,  30,  32,  34,  36,  38,
+      40,  43,  45,  47,  50,  52,  55,  57,  60,  63,  65,  68,  71,  73,  76,  79,
+      82,  85,  87,  90,  93,  96,  99, 102, 105, 108, 111, 114, 117, 120, 123, 126,
+     129, 132, 135, 138, 141, 144, 147, 150, 153, 156, 159, 162, 165, 168, 170, 173,
+     176, 179, 182, 184, 187, 190, 192, 195, 198, 200, 203, 205, 208, 210, 212, 215,
+     217, 219, 221, 223, 225, 227, 229, 231, 233, 235, 236, 238, 240, 241, 243, 244,
+     245, 246, 248, 249, 250, 251, 251, 252, 253, 253, 254, 254, 255, 255, 255, 255,
+ };
+
+ // Soft stop: softUp reversed
+ static const uint8_t softDown[] = {
+     255, 255, 255, 255, 254, 254, 253, 253, 252, 251, 251, 250, 249, 248, 246, 245,
+     244, 243, 241, 240, 238, 236, 235, 233, 231, 229, 227, 225, 223, 221, 219, 217,
+     215, 212, 210, 208, 205, 203, 200, 198, 195, 192, 190, 187, 184, 182, 179, 176,
+     173, 170, 168, 165, 162, 159, 156, 153, 150, 147, 144, 141, 138, 135, 132, 129,
+     126, 123, 120, 117, 114, 111, 108, 105, 102,  99,  96,  93,  90,  87,  85,  82,
+      79,  76,  73,  71,  68,  65,  63,  60,  57,  55,  52,  50,  47,  45,  43,  40,
+      38,  36,  34,  32,  30,  28,  26,  24,  22,  20,  19,  17,  15,  14,  12,  11,
+      10,   9,   7,   6,   5,   4,   4,   3,   2,   2,   1,   1,   0,   0,   0,   0,
+ };
+
+ // Spin acceleration: S-curve 0 -> MOTOR_DUTY_MAX over 512 PWM periods (~1 s)
+ static const uint8_t spinUp[] = {
+       0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,
+       1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   3,   3,
+       3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+       6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,   9,  10,  10,  10,  11,
+      11,  11,  12,  12,  12,  13,  13,  13,  14,  14,  14,  15,  15,  16,  16,  16,
+      17,  17,  18,  18,  18,  19,  19,  20,  20,  21,  21,  21,  22,  22,  23,  23,
+      24,  24,  25,  25,  25,  26,  26,  27,  27,  28,  28,  29,  29,  30,  30,  31,
+      31,  32,  32,  33,  33,  34,  35,  35,  36,  36,  37,  37,  38,  38,  39,  39,
+      40,  41,  41,  42,  42,  43,  43,  44,  45,  45,  46,  46,  47,  48,  48,  49,
+      49,  50,  51,  51,  52,  52,  53,  54,  54,  55,  56,  56,  57,  57,  58,  59,
+      59,  60,  61,  61,  62,  63,  63,  64,  65,  65,  66,  67,  67,  68,  69,  69,
+      70,  71,  71,  72,  73,  73,  74,  75,  75,  76,  77,  77,  78,  79,  80,  80,
+      81,  82,  82,  83,  84,  84,  85,  86,  87,  87,  88,  89,  89,  90,  91,  92,
+      92,  93,  94,  95,  95,  96,  97,  97,  98,  99, 100, 100, 101, 102, 103, 103,
+     104, 105, 106, 106, 107, 108, 108, 109, 110, 111, 111, 112, 113, 114, 114, 115,
+     116, 117, 117, 118, 119, 120, 120, 121, 122, 123, 123, 124, 125, 126, 126, 127,
+     128, 129, 129, 130, 131, 132, 132, 133, 134, 135, 135, 136, 137, 138, 138, 139,
+     140, 141, 141, 142, 143, 144, 144, 145, 146, 147, 147, 148, 149, 149, 150, 151,
+     152, 152, 153, 154, 155, 155, 156, 157, 158, 158, 159, 160, 160, 161, 162, 163,
+     163, 164, 165, 166, 166, 167, 168, 168, 169, 170, 171, 171, 172, 173, 173, 174,
+     175, 175, 176, 177, 178, 178, 179, 180, 180, 181, 182, 182, 183, 184, 184, 185,
+     186, 186, 187, 188, 188, 189, 190, 190, 191, 192, 192, 193, 194, 194, 195, 196,
+     196, 197, 198, 198, 199, 199, 200, 201, 201, 202, 203, 203, 204, 204, 205, 206,
+     206, 207, 207, 208, 209, 209, 210, 210, 211, 212, 212, 213, 213, 214, 214, 215,
+     216, 216, 217, 217, 218, 218, 219, 219, 220, 220, 221, 222, 222, 223, 223, 224,
+     224, 225, 225, 226, 226, 227, 227, 228, 228, 229, 229, 230, 230, 230, 231, 231,
+     232, 232, 233, 233, 234, 234, 234, 235, 235, 236, 236, 237, 237, 237, 238, 238,
+     239, 239, 239, 240, 240, 241, 241, 241, 242, 242, 242, 243, 243, 243, 244, 244,
+     244, 245, 245, 245, 246, 246, 246, 246, 247, 247, 247, 248, 248, 248, 248, 249,
+     249, 249, 249, 250, 250, 250, 250, 251, 251, 251, 251, 251, 252, 252, 252, 252,
+     252, 252, 253, 253, 253, 253, 253, 253, 253, 254, 254, 254, 254, 254, 254, 254,
+     254, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+ };
+
+ // Spin braking: spinUp reversed
+ static const uint8_t spinDown[] = {
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 254, 254,
+     254, 254, 254, 254, 254, 254, 254, 253, 253, 253, 253, 253, 253, 253, 252, 252,
+     252, 252, 252, 252, 251, 251, 251, 251, 251, 250, 250, 250, 250, 249, 249, 249,
+     249, 248, 248, 248, 248, 247, 247, 247, 246, 246, 246, 246, 245, 245, 245, 244,
+     244, 244, 243, 243, 243, 242, 242, 242, 241, 241, 241, 240, 240, 239, 239, 239,
+     238, 238, 237, 237, 237, 236, 236, 235, 235, 234, 234, 234, 233, 233, 232, 232,
+     231, 231, 230, 230, 230, 229, 229, 228, 228, 227, 227, 226, 226, 225, 225, 224,
+     224, 223, 223, 222, 222, 221, 220, 220, 219, 219, 218, 218, 217, 217, 216, 216,
+     215, 214, 214, 213, 213, 212, 212, 211, 210, 210, 209, 209, 208, 207, 207, 206,
+     206, 205, 204, 204, 203, 203, 202, 201, 201, 200, 199, 199, 198, 198, 197, 196,
+     196, 195, 194, 194, 193, 192, 192, 191, 190, 190, 189, 188, 188, 187, 186, 186,
+     185, 184, 184, 183, 182, 182, 181, 180, 180, 179, 178, 178, 177, 176, 175, 175,
+     174, 173, 173, 172, 171, 171, 170, 169, 168, 168, 167, 166, 166, 165, 164, 163,
+     163, 162, 161, 160, 160, 159, 158, 158, 157, 156, 155, 155, 154, 153, 152, 152,
+     151, 150, 149, 149, 148, 147, 147, 146, 145, 144, 144, 143, 142, 141, 141, 140,
+     139, 138, 138, 137, 136, 135, 135, 134, 133, 132, 132, 131, 130, 129, 129, 128,
+     127, 126, 126, 125, 124, 123, 123, 122, 121, 120, 120, 119, 118, 117, 117, 116,
+     115, 114, 114, 113, 112, 111, 111, 110, 109, 108, 108, 107, 106, 106, 105, 104,
+     103, 103, 102, 101, 100, 100,  99,  98,  97,  97,  96,  95,  95,  94,  93,  92,
+      92,  91,  90,  89,  89,  88,  87,  87,  86,  85,  84,  84,  83,  82,  82,  81,
+      80,  80,  79,  78,  77,  77,  76,  75,  75,  74,  73,  73,  72,  71,  71,  70,
+      69,  69,  68,  67,  67,  66,  65,  65,  64,  63,  63,  62,  61,  61,  60,  59,
+      59,  58,  57,  57,  56,  56,  55,  54,  54,  53,  52,  52,  51,  51,  50,  49,
+      49,  48,  48,  47,  46,  46,  45,  45,  44,  43,  43,  42,  42,  41,  41,  40,
+      39,  39,  38,  38,  37,  37,  36,  36,  35,  35,  34,  33,  33,  32,  32,  31,
+      31,  30,  30,  29,  29,  28,  28,  27,  27,  26,  26,  25,  25,  25,  24,  24,
+      23,  23,  22,  22,  21,  21,  21,  20,  20,  19,  19,  18,  18,  18,  17,  17,
+      16,  16,  16,  15,  15,  14,  14,  14,  13,  13,  13,  12,  12,  12,  11,  11,
+      11,  10,  10,  10,   9,   9,   9,   9,   8,   8,   8,   7,   7,   7,   7,   6,
+       6,   6,   6,   5,   5,   5,   5,   4,   4,   4,   4,   4,   3,   3,   3,   3,
+       3,   3,   2,   2,   2,   2,   2,   2,   2,   1,   1,   1,   1,   1,   1,   1,
+       1,   1,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+ };
+
+ typedef struct {
+     const uint8_t *up;
+     const uint8_t *down;
+     uint16_t length;
+ } MotorRampTable;
+
+ static const MotorRampTable rampTables[MOTOR_RAMP_COUNT] = {
+     [MOTOR_RAMP_SOFT] = {softUp, softDown, sizeof(softUp)},
+     [MOTOR_RAMP_SPIN] = {spinUp, spinDown, sizeof(spinUp)},
+ };
+
+ static volatile uint8_t duty = 0;               // Settled duty on activeDirection
+ static volatile uint8_t activeDirection = FORWARD;
+ static volatile uint8_t ramping = 0;
+ static uint8_t rampTarget = 0;                  // Duty at the end of the ramp in flight
+
+ // Latest request (written by the main loop with interrupts masked)
+ static uint8_t wantDirection = FORWARD;
+ static uint8_t wantDuty = 0;
+ static uint8_t wantRamp = MOTOR_RAMP_SOFT;
+
+ static volatile uint32_t *Motor_Compare(uint8_t direction) {
+     return (direction == FORWARD) ? &htim3.Instance->CCR3 : &htim3.Instance->CCR4;
+ }
+
+ // First index whose value is at least `value` (ascending table)
+ static uint16_t Motor_FindAscending(const uint8_t *table, uint16_t length, uint8_t value) {
+     uint16_t low = 0;
+     uint16_t high = length - 1;
+
+     while (low < high) {
+         uint16_t mid = (low + high) >> 1;
+         if (table[mid] < value) {
+             low = mid + 1;
+         } else {
+             high = mid;
+         }
+     }
+     return low;
+ }
+
+ // First index whose value is at most `value` (descending table)
+ static uint16_t Motor_FindDescending(const uint8_t *table, uint16_t length, uint8_t value) {
+     uint16_t low = 0;
+     uint16_t high = length - 1;
+
+     while (low < high) {
+         uint16_t mid = (low + high) >> 1;
+         if (table[mid] > value) {
+             low = mid + 1;
+         } else {
+             high = mid;
+         }
+     }
+     return low;
+ }
+
+ uint8_t Motor_RpmToDuty(uint16_t rpm) {
+     if (rpm >= MOTOR_MAX_RPM) {
+         return MOTOR_DUTY_MAX;
+     }
+     return (uint8_t)(((uint32_t)rpm * MOTOR_DUTY_PER_RPM_Q16) >> 16);
+ }
+
+ // Start the ramp that moves the output toward the request (no-op while one runs)
+ static void Motor_Next(void) {
+     const MotorRampTable *ramp = &rampTables[wantRamp];
+     const uint8_t *table;
+     uint16_t first;
+     uint16_t last;
+     uint8_t target = wantDuty;
+
+     if (ramping) {
+         return;
+     }
+     if (duty == 0) {
+         activeDirection = wantDirection;
+     } else if (wantDirection != activeDirection) {
+         target = 0; // Reverse through standstill
+     }
+     if (target == duty) {
+         return;
+     }
+
+     if (target > duty) {
+         table = ramp->up;
+         first = Motor_FindAscending(table, ramp->length, duty + 1);
+         last = Motor_FindAscending(table, ramp->length, target);
+     } else {
+         table = ramp->down;
+         first = Motor_FindDescending(table, ramp->length, duty - 1);
+         last = Motor_FindDescending(table, ramp->length, target);
+     }
+
+     rampTarget = target;
+     ramping = 1;
+     if (HAL_DMA_Start_IT(&hdma_tim3_up, (uint32_t)&table[first], (uint32_t)Motor_Compare(activeDirection),
+                          last - first + 1) != HAL_OK) {
+         ramping = 0;
+         return;
+     }
+     __HAL_TIM_ENABLE_DMA(&htim3, TIM_DMA_UPDATE);
+ }
+
+ // Ramp finished: settle on the exact target, then continue with any newer request
+ RAMFUNC static void Motor_RampComplete(DMA_HandleTypeDef *hdma) {
+     (void)hdma;
+     __HAL_TIM_DISABLE_DMA(&htim3, TIM_DMA_UPDATE);
+     *Motor_Compare(activeDirection) = rampTarget;
+     duty = rampTarget;
+     ramping = 0;
+     Motor_Next();
+ }
+
+ static void Motor_RampError(DMA_HandleTypeDef *hdma) {
+     (void)hdma;
+     Motor_Off();
+ }
+
+ void Motor_Init(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+     TIM_OC_InitTypeDef sConfigOC = {0};
+
+     __HAL_RCC_TIM3_CLK_ENABLE();
+     __HAL_RCC_DMA1_CLK_ENABLE();
+     __HAL_RCC_GPIOB_CLK_ENABLE();
+
+     htim3.Instance = TIM3;
+     htim3.Init.Prescaler = (POWER_TIMER_HZ / (MOTOR_PWM_HZ * MOTOR_DUTY_MAX)) - 1U;
+     htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+     htim3.Init.Period = MOTOR_DUTY_MAX - 1U;
+     htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+     htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+     if (HAL_TIM_PWM_Init(&htim3) != HAL_OK) {
+         Error_Handler();
+     }
+
+     sConfigOC.OCMode = TIM_OCMODE_PWM1;
+     sConfigOC.Pulse = 0;
+     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+     sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+     if (HAL_TIM_PWM_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_3) != HAL_OK ||
+         HAL_TIM_PWM_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_4) != HAL_OK) {
+         Error_Handler();
+     }
+
+     hdma_tim3_up.Instance = DMA1_Channel3;
+     hdma_tim3_up.Init.Request = DMA_REQUEST_TIM3_UP;
+     hdma_tim3_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+     hdma_tim3_up.Init.PeriphInc = DMA_PINC_DISABLE;
+     hdma_tim3_up.Init.MemInc = DMA_MINC_ENABLE;
+     hdma_tim3_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+     hdma_tim3_up.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+     hdma_tim3_up.Init.Mode = DMA_NORMAL;
+     hdma_tim3_up.Init.Priority = DMA_PRIORITY_MEDIUM;
+     if (HAL_DMA_Init(&hdma_tim3_up) != HAL_OK) {
+         Error_Handler();
+     }
+     hdma_tim3_up.XferCpltCallback = Motor_RampComplete;
+     hdma_tim3_up.XferErrorCallback = Motor_RampError;
+
+     // Both outputs start at 0% before the pins are handed from GPIO to TIM3
+     if (HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3) != HAL_OK ||
+         HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4) != HAL_OK) {
+         Error_Handler();
+     }
+     GPIO_InitStruct.Pin = MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+     GPIO_InitStruct.Pull = GPIO_NOPULL;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     GPIO_InitStruct.Alternate = GPIO_AF1_TIM3;
+     HAL_GPIO_Init(MOTOR_GPIO_PORT, &GPIO_InitStruct);
+
+     HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+ }
+
+ void Motor_Run(MotorDirection direction, uint16_t rpm, MotorRamp ramp) {
+     uint8_t target = Motor_RpmToDuty(rpm);
+
+     if (ramp >= MOTOR_RAMP_COUNT) {
+         ramp = MOTOR_RAMP_SOFT;
+     }
+     if (direction == wantDirection && target == wantDuty && ramp == wantRamp) {
+         return;
+     }
+     __disable_irq();
+     wantDirection = direction;
+     wantDuty = target;
+     wantRamp = ramp;
+     Motor_Next();
+     __enable_irq();
+ }
+
+ void Motor_Stop(void) {
+     Motor_Run((MotorDirection)wantDirection, 0, (MotorRamp)wantRamp);
+ }
+
+ void Motor_Off(void) {
+     uint32_t primask = __get_PRIMASK();
+
+     __disable_irq();
+     if (ramping) {
+         __HAL_TIM_DISABLE_DMA(&htim3, TIM_DMA_UPDATE);
+         HAL_DMA_Abort(&hdma_tim3_up);
+         ramping = 0;
+     }
+     htim3.Instance->CCR3 = 0;
+     htim3.Instance->CCR4 = 0;
+     duty = 0;
+     wantDuty = 0;
+     __set_PRIMASK(primask);
+ }
+
+ void Motor_SetDuty(MotorDirection direction, uint8_t value) {
+     __disable_irq();
+     // Reversing at speed would skip the ramp down through zero
+     if (direction != activeDirection && (*Motor_Compare(activeDirection) != 0 || ramping)) {
+         __enable_irq();
+         return;
+     }
+     if (ramping) {
+         __HAL_TIM_DISABLE_DMA(&htim3, TIM_DMA_UPDATE);
+         HAL_DMA_Abort(&hdma_tim3_up);
+         ramping = 0;
+     }
+     if (direction != activeDirection) {
+         *Motor_Compare(activeDirection) = 0;
+         activeDirection = direction;
+     }
+     *Motor_Compare(direction) = value;
+     duty = value;
+     wantDirection = direction;
+     wantDuty = value;
+     wantRamp = MOTOR_RAMP_SPIN;
+     __enable_irq();
+ }
+
+ uint8_t Motor_GetDuty(void) {
+     return (uint8_t)*Motor_Compare(activeDirection);
+ }
+
+ uint8_t Motor_IsRamping(void) {
+     return ramping;
+ }
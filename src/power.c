@@ -0,0 +1,230 @@
+/**
+ * @file power.c
+ * @brief HSI48 run levels, SysTick time base and Stop-mode sleep.
+ *
+ * This source file implements the power manager declared in power.h.
+ *
+ * Details:
+ * - A level is an HSI48 divider, an APB divider and a flash latency. Going up,
+ *   the APB divider and the wait state change first and the HSI divider last;
+ *   going down, the other way round. PCLK only dips in between, and the flash
+ *   always has the wait states the new SYSCLK needs.
+ * - `Power_Update()` switches at most once per call and only when the wanted
+ *   level changes; `POWER_HOLD_MS` of hysteresis keeps a busy screen from
+ *   toggling the clock on every refresh.
+ * - Stop mode is entered only when nothing would notice the clocks stopping:
+ *   no SPI transfer or dirty framebuffer, no button scan, no profiler dump,
+ *   motor off with no ramp, no step deadline armed, and no Modbus frame half
+ *   received or reply being sent. Between frames USART1 wakes the core itself.
+ * - A level switch that the RCC refuses at run time is rolled back and the core stays
+ *   at its current level; the next attempt waits `POWER_HOLD_MS`. Either level runs
+ *   every task, so this only costs energy or display latency. Only the boot-time
+ *   switch in `Power_Init()` and the one after Stop mode (motor off) go to
+ *   `Error_Handler()`.
+ * - Leaving Stop mode the core runs from HSISYS, so the current level is
+ *   applied again before SysTick is resumed.
+ *
+ * Dependencies:
+ * - power.h (for the levels and prototypes)
+ * - main.h (for `Error_Handler()`)
+ * - spi.h, display.h, button.h, motor.h, steptimer.h, profile.h, modbus.h (for the idle checks
+ *   and the USART1 wakeup)
+ */
+
+
+
+ #include "power.h"
+ #include "main.h"
+ #include "spi.h"
+ #include "display.h"
+ #include "button.h"
+ #include "motor.h"
+ #include "steptimer.h"
+ #include "profile.h"
+ #include "modbus.h"
+
+ typedef struct {
+     uint32_t hsiDiv;   // RCC_HSI_DIVn, SYSCLK = HSI48 / n
+     uint32_t apbDiv;   // RCC_APB1_DIVn, brings PCLK back to POWER_PCLK_HZ
+     uint32_t latency;  // FLASH_LATENCY_n
+ } PowerConfig;
+
+ static const PowerConfig powerLevels[POWER_LEVEL_COUNT] = {
+     [POWER_SLOW] = {RCC_HSI_DIV2, RCC_APB1_DIV2, FLASH_LATENCY_0},
+     [POWER_FAST] = {RCC_HSI_DIV1, RCC_APB1_DIV4, FLASH_LATENCY_1},
+ };
+
+ static PowerLevel powerLevel = POWER_FAST;
+ static uint32_t lastDemand = 0;
+ static uint32_t stopCount = 0;
+ static int32_t tickSkewNs = 0;  // SysTick time lost (+) or gained (-) to level switches
+ static uint8_t switchFailed = 0;
+ static uint32_t lastFailure = 0;
+ static uint32_t switchFailures = 0;
+
+ static HAL_StatusTypeDef Power_SetOscillator(const PowerConfig *config) {
+     RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+
+     RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+     RCC_OscInitStruct.HSIState = RCC_HSI_ON;
+     RCC_OscInitStruct.HSIDiv = config->hsiDiv;
+     RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+
+     return HAL_RCC_OscConfig(&RCC_OscInitStruct);
+ }
+
+ static HAL_StatusTypeDef Power_SetBus(const PowerConfig *config) {
+     RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+     RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1;
+     RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+     RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+     RCC_ClkInitStruct.APB1CLKDivider = config->apbDiv;
+
+     return HAL_RCC_ClockConfig(&RCC_ClkInitStruct, config->latency);
+ }
+
+ // Bus divider and wait state before a faster SYSCLK, after a slower one. If the
+ // second step fails the first is undone, so the clocks are left at the old level.
+ static HAL_StatusTypeDef Power_Apply(PowerLevel level, uint8_t faster) {
+     const PowerConfig *config = &powerLevels[level];
+     const PowerConfig *current = &powerLevels[powerLevel];
+
+     if (faster) {
+         if (Power_SetBus(config) != HAL_OK) {
+             return HAL_ERROR;
+         }
+         if (Power_SetOscillator(config) != HAL_OK) {
+             Power_SetBus(current);
+             return HAL_ERROR;
+         }
+     } else {
+         if (Power_SetOscillator(config) != HAL_OK) {
+             return HAL_ERROR;
+         }
+         if (Power_SetBus(config) != HAL_OK) {
+             Power_SetOscillator(current);
+             return HAL_ERROR;
+         }
+     }
+     powerLevel = level;
+     return HAL_OK;
+ }
+
+ // Run-time switch; a failure keeps the current level (the motor may be spinning
+ // under the speed loop) and holds off the next attempt for POWER_HOLD_MS
+ static void Power_Switch(PowerLevel level, uint8_t faster, uint32_t now) {
+     if (switchFailed && (now - lastFailure) < POWER_HOLD_MS) {
+         return;
+     }
+     switchFailed = (Power_Apply(level, faster) != HAL_OK);
+     if (switchFailed) {
+         lastFailure = now;
+         switchFailures++;
+     }
+ }
+
+ // Nothing running that needs a clock through Stop mode
+ static uint8_t Power_CanStop(void) {
+     return !SPI_IsBusy() && !Display_IsDirty() && !Button_IsScanning() && !Profile_IsBusy() &&
+            Motor_GetDuty() == 0 && !Motor_IsRamping() && !StepTimer_Running() && !Modbus_IsBusy();
+ }
+
+ void Power_Init(void) {
+     // Out of reset SYSCLK is HSISYS (HSI48 / 4) with the APB undivided; nothing runs yet
+     if (Power_Apply(POWER_FAST, 1) != HAL_OK) {
+         Error_Handler();
+     }
+     lastDemand = HAL_GetTick();
+ }
+
+ void Power_Update(uint8_t demand) {
+     uint32_t now = HAL_GetTick();
+
+     if (demand || Display_IsDirty() || SPI_IsBusy()) {
+         lastDemand = now;
+         if (powerLevel != POWER_FAST) {
+             Power_Switch(POWER_FAST, 1, now);
+         }
+     } else if (powerLevel != POWER_SLOW && (now - lastDemand) >= POWER_HOLD_MS) {
+         Power_Switch(POWER_SLOW, 0, now);
+     }
+ }
+
+ void Power_Sleep(uint8_t idle) {
+     if (!idle || !Power_CanStop()) {
+         __WFI();
+         return;
+     }
+
+     // SysTick would wake the core every millisecond; the RTC and EXTI wake it instead
+     HAL_SuspendTick();
+     Modbus_SetWakeup(1);
+     HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+     Modbus_SetWakeup(0);
+     // Only reached while IDLE with the motor off: a failure here is a board fault
+     if (Power_Apply(powerLevel, 1) != HAL_OK) {
+         Error_Handler();
+     }
+     HAL_ResumeTick();
+     stopCount++;
+ }
+
+ PowerLevel Power_GetLevel(void) {
+     return powerLevel;
+ }
+
+ uint32_t Power_GetStops(void) {
+     return stopCount;
+ }
+
+ uint32_t Power_GetSwitchFailures(void) {
+     return switchFailures;
+ }
+
+ // The rest of the current SysTick period runs at the new SYSCLK; add up how much
+ // longer that makes it and hand each whole lost millisecond back to uwTick
+ static void Power_CarryTick(uint32_t reload) {
+     uint32_t left = SysTick->VAL;
+     uint32_t oldReload = SysTick->LOAD + 1U;
+     int64_t intendedNs = ((int64_t)left * 1000000) / (int64_t)oldReload;
+     int64_t actualNs = ((int64_t)left * 1000000) / (int64_t)reload;
+     uint32_t primask;
+
+     tickSkewNs += (int32_t)(actualNs - intendedNs);
+     if (tickSkewNs >= 1000000) {
+         primask = __get_PRIMASK();
+         __disable_irq();
+         while (tickSkewNs >= 1000000) {
+             uwTick += (uint32_t)uwTickFreq;
+             tickSkewNs -= 1000000;
+         }
+         __set_PRIMASK(primask);
+     }
+ }
+
+ // Replaces the HAL's weak version, which the HAL calls after every clock change:
+ // that one restarts SysTick and would cut the current millisecond short on each
+ // level switch. Here a running SysTick only gets the new reload, from its next
+ // wrap, and the stretched or shortened rest of the period is carried into uwTick.
+ // A shortened period is only netted against later stretched ones, so the tick
+ // never steps back.
+ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority) {
+     uint32_t reload = SystemCoreClock / (1000U / (uint32_t)uwTickFreq);
+
+     if (reload == 0U || (reload - 1U) > SysTick_LOAD_RELOAD_Msk) {
+         return HAL_ERROR;
+     }
+
+     if ((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0U) {
+         SysTick->LOAD = reload - 1U;
+         SysTick->VAL = 0U;
+         SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+     } else if (SysTick->LOAD != reload - 1U) {
+         Power_CarryTick(reload);
+         SysTick->LOAD = reload - 1U;
+     }
+     HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+     uwTickPrio = TickPriority;
+     return HAL_OK;
+ }
@@ -0,0 +1,185 @@
+/**
+ * @file profile.c
+ * @brief Probe statistics table and its line-by-line text dump.
+ *
+ * This source file implements the profiler declared in profile.h.
+ *
+ * Details:
+ * - `Profile_Record()` is the only code on the measured paths: one subtraction
+ *   of 16-bit timestamps, min/max/total/count updates and a short shift loop
+ *   for the histogram bucket (the M0+ has no CLZ). No division, no masking.
+ * - Histogram counts saturate at 65535; `total` and `count` are 32-bit.
+ * - The dump runs in `Profile_Service()`, a low-priority scheduler task: while
+ *   USART2 is busy it returns at once, otherwise it formats the next line into
+ *   a small buffer and starts one interrupt-driven transmit. Nothing is
+ *   formatted in an interrupt and the table is never copied as a whole.
+ * - Each probe is copied with interrupts masked for the few loads it takes, so
+ *   a dumped line is consistent even while its interrupt keeps recording.
+ * - Line format (microseconds): `name min max mean count h0 .. h7`, after a
+ *   header line; probes that never ran are skipped. Task lines add the
+ *   scheduler's deadline miss and shed counts as two more columns.
+ *
+ * Dependencies:
+ * - profile.h (for the probe identifiers and prototypes)
+ * - scheduler.h (for the task names and deadline counters)
+ * - console.h (for USART2 and the line formatters)
+ */
+
+
+
+ #include "profile.h"
+
+ #if PROFILE_ENABLE
+
+ #include "console.h"
+ #include <string.h>
+
+ // Longest line: name, 4 fields of up to 10 digits, 10 of up to 5, separators, CRLF
+ #define PROFILE_LINE_SIZE  128
+
+ typedef struct {
+     uint16_t min;
+     uint16_t max;
+     uint32_t total;
+     uint32_t count;
+     uint16_t histogram[PROFILE_BUCKETS];
+ } ProfileStats;
+
+ static const char *const probeNames[PROFILE_TASK_FIRST] = {
+     [PROFILE_LOOP]             = "loop",
+     [PROFILE_ISR_TACH]         = "isr-tach",
+     [PROFILE_ISR_ADC]          = "isr-adc",
+     [PROFILE_ISR_DMA2_3]       = "isr-dma23",
+     [PROFILE_ISR_SPI]          = "isr-spi",
+     [PROFILE_ISR_STEP_TIMER]   = "isr-step",
+     [PROFILE_ISR_TICK]         = "isr-tick",
+     [PROFILE_ISR_BUTTON]       = "isr-button",
+     [PROFILE_ISR_RTC]          = "isr-rtc",
+     [PROFILE_ISR_MODBUS]       = "isr-modbus",
+     [PROFILE_BOOT_SAFE]        = "boot-safe",
+     [PROFILE_BOOT_READY]       = "boot-ready",
+     [PROFILE_EVENT_STEP_TIMER] = "ev-step",
+     [PROFILE_EVENT_BUTTON]     = "ev-button",
+     [PROFILE_EVENT_CLOCK]      = "ev-clock",
+ };
+
+ static const char profileHeader[] = "probe min max mean count <8 <16 <32 <64 <128 <256 <512 >=512 misses sheds\r\n";
+
+ static ProfileStats profileTable[PROFILE_PROBE_COUNT];
+ static char lineBuffer[PROFILE_LINE_SIZE];
+ static int16_t dumpProbe = -1;  // -1 idle, PROFILE_PROBE_COUNT = header pending
+
+ // Format one probe; returns the line length, 0 if the probe never ran
+ static uint16_t Profile_FormatProbe(uint8_t probe) {
+     ProfileStats stats;
+     const char *name;
+     uint8_t task = (uint8_t)(probe - PROFILE_TASK_FIRST);
+     char *out = lineBuffer;
+
+     __disable_irq();
+     stats = profileTable[probe];
+     __enable_irq();
+     if (stats.count == 0) {
+         return 0;
+     }
+
+     if (probe < PROFILE_TASK_FIRST) {
+         name = probeNames[probe];
+     } else {
+         name = Scheduler_GetName(task);
+         if (name == NULL) {
+             return 0;
+         }
+     }
+
+     out = Console_Append(out, name);
+     out = Console_AppendNumber(out, stats.min);
+     out = Console_AppendNumber(out, stats.max);
+     out = Console_AppendNumber(out, stats.total / stats.count);
+     out = Console_AppendNumber(out, stats.count);
+     for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+         out = Console_AppendNumber(out, stats.histogram[b]);
+     }
+     if (probe >= PROFILE_TASK_FIRST) {
+         out = Console_AppendNumber(out, Scheduler_GetMisses(task));
+         out = Console_AppendNumber(out, Scheduler_GetSheds(task));
+     }
+     out = Console_Append(out, "\r\n");
+     return (uint16_t)(out - lineBuffer);
+ }
+
+ void Profile_Init(void) {
+     for (uint8_t i = 0; i < PROFILE_PROBE_COUNT; i++) {
+         memset(&profileTable[i], 0, sizeof(profileTable[i]));
+         profileTable[i].min = UINT16_MAX;
+     }
+ }
+
+ RAMFUNC void Profile_Record(ProfileProbe probe, uint16_t start) {
+     Profile_RecordUs(probe, (uint16_t)(Profile_Now() - start));
+ }
+
+ RAMFUNC void Profile_RecordUs(ProfileProbe probe, uint16_t elapsed) {
+     ProfileStats *stats = &profileTable[probe];
+     uint16_t limit = PROFILE_BUCKET0_US;
+     uint8_t bucket = 0;
+
+     if (elapsed < stats->min) {
+         stats->min = elapsed;
+     }
+     if (elapsed > stats->max) {
+         stats->max = elapsed;
+     }
+     stats->total += elapsed;
+     stats->count++;
+
+     while (bucket < PROFILE_BUCKETS - 1 && elapsed >= limit) {
+         bucket++;
+         limit <<= 1;
+     }
+     if (stats->histogram[bucket] != UINT16_MAX) {
+         stats->histogram[bucket]++;
+     }
+ }
+
+ void Profile_RequestDump(void) {
+     if (dumpProbe < 0) {
+         dumpProbe = PROFILE_PROBE_COUNT;
+     }
+ }
+
+ void Profile_Service(void) {
+     uint16_t length = 0;
+
+     if (dumpProbe < 0) {
+         return;
+     }
+     // The first dump request takes PA14 over from the debugger
+     Console_Init();
+     if (huart2.gState != HAL_UART_STATE_READY) {
+         return;
+     }
+
+     if (dumpProbe == PROFILE_PROBE_COUNT) {
+         memcpy(lineBuffer, profileHeader, sizeof(profileHeader) - 1);
+         length = sizeof(profileHeader) - 1;
+         dumpProbe = 0;
+     } else {
+         // Next probe that has data
+         while (dumpProbe < PROFILE_PROBE_COUNT && length == 0) {
+             length = Profile_FormatProbe((uint8_t)dumpProbe++);
+         }
+         if (dumpProbe == PROFILE_PROBE_COUNT) {
+             dumpProbe = -1;
+         }
+     }
+     if (length > 0) {
+         HAL_UART_Transmit_IT(&huart2, (const uint8_t *)lineBuffer, length);
+     }
+ }
+
+ uint8_t Profile_IsBusy(void) {
+     return (dumpProbe >= 0) || (huart2.gState == HAL_UART_STATE_BUSY_TX);
+ }
+
+ #endif // PROFILE_ENABLE
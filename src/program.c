@@ -0,0 +1,289 @@
+/**
+ * @file program.c
+ * @brief Const wash program and agitation tables.
+ *
+ * This source file defines the 30 wash programs declared in program.h.
+ *
+ * Details:
+ * - Each program points at a const step list (10 bytes per step), so the whole
+ *   table costs about 1.5 KB of flash and no RAM.
+ * - `Program_GetStep()` is a bounds check and two indexed loads, whatever the
+ *   program length, so the control task's cost per tick is constant.
+ * - Step durations are in seconds. `WASH_STEP`, `RINSE_STEP` and `SPIN_STEP`
+ *   fill in the fields that do not apply to each kind of step.
+ *
+ * Dependencies:
+ * - program.h (for the table types and prototypes)
+ * - adc.h (for `TEMP_DECI()`)
+ */
+
+
+
+ #include "program.h"
+ #include "adc.h"
+ #include <stddef.h>
+
+ #define WASH_STEP(level, degrees, pattern, seconds) \
+     {WASH, (level), TEMP_DECI(degrees), (pattern), (seconds), 0}
+ #define RINSE_STEP(level, pattern, seconds) \
+     {RINSE, (level), PROGRAM_TEMP_COLD, (pattern), (seconds), 0}
+ #define SPIN_STEP(rpm, seconds) \
+     {SPIN, 0, PROGRAM_TEMP_COLD, AGITATE_NONE, (seconds), (rpm)}
+
+ #define PROGRAM(steps) {(steps), sizeof(steps) / sizeof((steps)[0])}
+
+ static const AgitationTiming agitationTable[AGITATE_PATTERN_COUNT] = {
+     [AGITATE_NONE]   = {0, 0, 0},
+     [AGITATE_GENTLE] = {4, 12, 30},
+     [AGITATE_NORMAL] = {12, 4, 45},
+     [AGITATE_HEAVY]  = {16, 4, 55},
+ };
+
+ // Cotton and heavy loads
+ static const ProgramStep cotton90[] = {
+     WASH_STEP(60, 90, AGITATE_HEAVY, 3600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1200, 600),
+ };
+ static const ProgramStep cotton60[] = {
+     WASH_STEP(60, 60, AGITATE_HEAVY, 3000),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1200, 600),
+ };
+ static const ProgramStep cotton40[] = {
+     WASH_STEP(60, 40, AGITATE_NORMAL, 2700),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1200, 480),
+ };
+ static const ProgramStep cotton30[] = {
+     WASH_STEP(60, 30, AGITATE_NORMAL, 2400),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1000, 480),
+ };
+ static const ProgramStep prewashCotton[] = {
+     WASH_STEP(50, 30, AGITATE_NORMAL, 900),
+     SPIN_STEP(400, 60),
+     WASH_STEP(60, 60, AGITATE_HEAVY, 3000),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1200, 600),
+ };
+ static const ProgramStep intensive[] = {
+     WASH_STEP(70, 60, AGITATE_HEAVY, 4200),
+     RINSE_STEP(80, AGITATE_HEAVY, 600),
+     RINSE_STEP(80, AGITATE_HEAVY, 600),
+     RINSE_STEP(80, AGITATE_HEAVY, 600),
+     RINSE_STEP(80, AGITATE_HEAVY, 600),
+     SPIN_STEP(1400, 600),
+ };
+ static const ProgramStep towels[] = {
+     WASH_STEP(70, 60, AGITATE_HEAVY, 3300),
+     RINSE_STEP(80, AGITATE_NORMAL, 600),
+     RINSE_STEP(80, AGITATE_NORMAL, 600),
+     RINSE_STEP(80, AGITATE_NORMAL, 600),
+     SPIN_STEP(1400, 600),
+ };
+ static const ProgramStep bedding[] = {
+     WASH_STEP(80, 40, AGITATE_NORMAL, 3000),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     SPIN_STEP(800, 480),
+ };
+ static const ProgramStep eco40[] = {
+     WASH_STEP(45, 40, AGITATE_NORMAL, 4800),
+     RINSE_STEP(55, AGITATE_NORMAL, 600),
+     RINSE_STEP(55, AGITATE_NORMAL, 600),
+     SPIN_STEP(1200, 600),
+ };
+
+ // Synthetics and mixed loads
+ static const ProgramStep synthetic60[] = {
+     WASH_STEP(50, 60, AGITATE_NORMAL, 2400),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(800, 300),
+ };
+ static const ProgramStep synthetic40[] = {
+     WASH_STEP(50, 40, AGITATE_NORMAL, 2100),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(800, 300),
+ };
+ static const ProgramStep mixed30[] = {
+     WASH_STEP(50, 30, AGITATE_NORMAL, 1800),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(1000, 360),
+ };
+ static const ProgramStep shirts[] = {
+     WASH_STEP(50, 40, AGITATE_GENTLE, 2100),
+     RINSE_STEP(60, AGITATE_GENTLE, 480),
+     RINSE_STEP(60, AGITATE_GENTLE, 480),
+     SPIN_STEP(600, 180),
+ };
+ static const ProgramStep sportswear[] = {
+     WASH_STEP(50, 30, AGITATE_NORMAL, 1800),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(800, 240),
+ };
+ static const ProgramStep jeans[] = {
+     WASH_STEP(60, 40, AGITATE_HEAVY, 2700),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(900, 360),
+ };
+ static const ProgramStep darks[] = {
+     WASH_STEP(55, 30, AGITATE_GENTLE, 2400),
+     RINSE_STEP(65, AGITATE_GENTLE, 480),
+     RINSE_STEP(65, AGITATE_GENTLE, 480),
+     SPIN_STEP(800, 300),
+ };
+ static const ProgramStep outdoor[] = {
+     WASH_STEP(50, 30, AGITATE_GENTLE, 1800),
+     RINSE_STEP(60, AGITATE_GENTLE, 480),
+     RINSE_STEP(60, AGITATE_GENTLE, 480),
+     RINSE_STEP(60, AGITATE_GENTLE, 480),
+     SPIN_STEP(600, 240),
+ };
+
+ // Delicates
+ static const ProgramStep delicates[] = {
+     WASH_STEP(70, 30, AGITATE_GENTLE, 1500),
+     RINSE_STEP(80, AGITATE_GENTLE, 420),
+     RINSE_STEP(80, AGITATE_GENTLE, 420),
+     SPIN_STEP(500, 180),
+ };
+ static const ProgramStep wool[] = {
+     WASH_STEP(70, 30, AGITATE_GENTLE, 1200),
+     RINSE_STEP(80, AGITATE_GENTLE, 360),
+     RINSE_STEP(80, AGITATE_GENTLE, 360),
+     SPIN_STEP(600, 120),
+ };
+ static const ProgramStep handWash[] = {
+     WASH_STEP(70, 20, AGITATE_GENTLE, 1200),
+     RINSE_STEP(80, AGITATE_GENTLE, 360),
+     RINSE_STEP(80, AGITATE_GENTLE, 360),
+     SPIN_STEP(400, 120),
+ };
+ static const ProgramStep silk[] = {
+     WASH_STEP(80, 0, AGITATE_GENTLE, 900),
+     RINSE_STEP(90, AGITATE_GENTLE, 300),
+     RINSE_STEP(90, AGITATE_GENTLE, 300),
+     SPIN_STEP(400, 60),
+ };
+ static const ProgramStep curtains[] = {
+     WASH_STEP(80, 30, AGITATE_GENTLE, 1800),
+     RINSE_STEP(90, AGITATE_GENTLE, 480),
+     RINSE_STEP(90, AGITATE_GENTLE, 480),
+     SPIN_STEP(400, 120),
+ };
+ static const ProgramStep duvet[] = {
+     WASH_STEP(90, 30, AGITATE_GENTLE, 2400),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     RINSE_STEP(90, AGITATE_GENTLE, 600),
+     SPIN_STEP(800, 360),
+ };
+ static const ProgramStep babyCare[] = {
+     WASH_STEP(60, 60, AGITATE_NORMAL, 3000),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     RINSE_STEP(70, AGITATE_NORMAL, 600),
+     SPIN_STEP(1000, 480),
+ };
+
+ // Short cycles
+ static const ProgramStep quick15[] = {
+     WASH_STEP(40, 20, AGITATE_NORMAL, 480),
+     RINSE_STEP(50, AGITATE_NORMAL, 180),
+     SPIN_STEP(800, 120),
+ };
+ static const ProgramStep quick30[] = {
+     WASH_STEP(45, 30, AGITATE_NORMAL, 1080),
+     RINSE_STEP(55, AGITATE_NORMAL, 300),
+     SPIN_STEP(1000, 180),
+ };
+ static const ProgramStep coldWash[] = {
+     WASH_STEP(50, 0, AGITATE_NORMAL, 1500),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(1000, 300),
+ };
+ static const ProgramStep soak[] = {
+     WASH_STEP(70, 30, AGITATE_GENTLE, 3600),
+     RINSE_STEP(70, AGITATE_GENTLE, 480),
+     SPIN_STEP(600, 180),
+ };
+
+ // Rinse and spin only
+ static const ProgramStep rinseSpin[] = {
+     RINSE_STEP(60, AGITATE_NORMAL, 480),
+     SPIN_STEP(1200, 360),
+ };
+ static const ProgramStep spinOnly[] = {
+     SPIN_STEP(1200, 360),
+ };
+
+ // Selectable programs, in panel order (P01 first)
+ const WashProgram programTable[PROGRAM_COUNT] = {
+     PROGRAM(cotton90),      // P01
+     PROGRAM(cotton60),      // P02
+     PROGRAM(cotton40),      // P03
+     PROGRAM(cotton30),      // P04
+     PROGRAM(eco40),         // P05
+     PROGRAM(prewashCotton), // P06
+     PROGRAM(intensive),     // P07
+     PROGRAM(towels),        // P08
+     PROGRAM(bedding),       // P09
+     PROGRAM(babyCare),      // P10
+     PROGRAM(synthetic60),   // P11
+     PROGRAM(synthetic40),   // P12
+     PROGRAM(mixed30),       // P13
+     PROGRAM(shirts),        // P14
+     PROGRAM(sportswear),    // P15
+     PROGRAM(jeans),         // P16
+     PROGRAM(darks),         // P17
+     PROGRAM(outdoor),       // P18
+     PROGRAM(delicates),     // P19
+     PROGRAM(wool),          // P20
+     PROGRAM(handWash),      // P21
+     PROGRAM(silk),          // P22
+     PROGRAM(curtains),      // P23
+     PROGRAM(duvet),         // P24
+     PROGRAM(quick15),       // P25
+     PROGRAM(quick30),       // P26
+     PROGRAM(coldWash),      // P27
+     PROGRAM(soak),          // P28
+     PROGRAM(rinseSpin),     // P29
+     PROGRAM(spinOnly),      // P30
+ };
+
+ const ProgramStep *Program_GetStep(int programIndex, int stepIndex) {
+     const WashProgram *program;
+
+     if ((unsigned)programIndex >= PROGRAM_COUNT) {
+         return NULL;
+     }
+     program = &programTable[programIndex];
+     if ((unsigned)stepIndex >= program->stepCount) {
+         return NULL;
+     }
+     return &program->steps[stepIndex];
+ }
+
+ const AgitationTiming *Program_GetAgitation(uint8_t pattern) {
+     if (pattern >= AGITATE_PATTERN_COUNT) {
+         pattern = AGITATE_NONE;
+     }
+     return &agitationTable[pattern];
+ }
@@ -0,0 +1,116 @@
+/**
+ * @file rtc.c
+ * @brief RTC setup and the interrupt-driven time of day.
+ *
+ * This source file implements the RTC interface declared in rtc.h.
+ *
+ * Details:
+ * - The RTC runs from the LSI (32 kHz) with the prescalers set for a 1 Hz calendar.
+ *   `RTC_StartClock()` only turns the LSI on; the caller polls `RTC_ClockReady()`
+ *   instead of waiting for its startup time.
+ * - The STM32C0 RTC has no wakeup timer, so Alarm A with every field masked is used
+ *   as the once-per-second interrupt.
+ * - Each alarm interrupt reads the calendar (one `TR` read and a BCD decode) and
+ *   publishes hours/minutes/seconds as a single packed word, so readers never
+ *   wait on shadow register synchronisation and always see a consistent time.
+ *   The clock follows a time set through `hrtc`, and a late or lost alarm costs
+ *   at most one stale second, never a lasting offset.
+ * - Every second `EVENT_CLOCK` is posted, which also wakes the main loop from WFI.
+ *
+ * Dependencies:
+ * - rtc.h (for the RTC handle and prototypes)
+ * - main.h (for `Error_Handler()`)
+ * - event.h (for `Event_Post()`)
+ * - profile.h (for the `PROFILE_ISR_RTC` interrupt probe)
+ */
+
+
+
+ #include "rtc.h"
+ #include "main.h"
+ #include "event.h"
+ #include "profile.h"
+
+ RTC_HandleTypeDef hrtc;
+
+ static volatile uint32_t rtcClock = 0; // Written by the alarm interrupt only (after init)
+
+ // Two BCD digits to binary: the M0+ multiplies in one cycle
+ static uint8_t RTC_FromBcd(uint32_t bcd) {
+     return (uint8_t)((bcd >> 4) * 10U + (bcd & 0x0FU));
+ }
+
+ // Time of day from the calendar; the DR read releases the shadow registers TR locked
+ static uint32_t RTC_ReadClock(void) {
+     uint32_t tr = RTC->TR;
+     uint8_t hours = RTC_FromBcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos);
+     uint8_t minutes = RTC_FromBcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos);
+     uint8_t seconds = RTC_FromBcd((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+
+     (void)RTC->DR;
+     return ((uint32_t)hours << 16) | ((uint32_t)minutes << 8) | seconds;
+ }
+
+ void RTC_StartClock(void) {
+     __HAL_RCC_LSI_ENABLE();
+ }
+
+ uint8_t RTC_ClockReady(void) {
+     return __HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) != RESET;
+ }
+
+ void MX_RTC_Init(void) {
+     RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+     RTC_AlarmTypeDef sAlarm = {0};
+
+     PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+     PeriphClkInit.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
+     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK) {
+         Error_Handler();
+     }
+     __HAL_RCC_RTC_ENABLE();
+     __HAL_RCC_RTCAPB_CLK_ENABLE();
+
+     // 32 kHz / (127 + 1) / (249 + 1) = 1 Hz
+     hrtc.Instance = RTC;
+     hrtc.Init.HourFormat = RTC_HOURFORMAT_24;
+     hrtc.Init.AsynchPrediv = 127;
+     hrtc.Init.SynchPrediv = 249;
+     hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
+     if (HAL_RTC_Init(&hrtc) != HAL_OK) {
+         Error_Handler();
+     }
+
+     // Valid before the first alarm
+     rtcClock = RTC_ReadClock();
+
+     // Alarm A matching on nothing fires at every second boundary
+     sAlarm.AlarmMask = RTC_ALARMMASK_ALL;
+     sAlarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
+     sAlarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+     sAlarm.AlarmDateWeekDay = 1;
+     sAlarm.Alarm = RTC_ALARM_A;
+     if (HAL_RTC_SetAlarm_IT(&hrtc, &sAlarm, RTC_FORMAT_BIN) != HAL_OK) {
+         Error_Handler();
+     }
+
+     HAL_NVIC_SetPriority(RTC_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(RTC_IRQn);
+ }
+
+ uint32_t RTC_GetClock(void) {
+     return rtcClock;
+ }
+
+ // One second elapsed: take the time from the calendar, not by counting alarms, and notify
+ void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *h) {
+     (void)h;
+     rtcClock = RTC_ReadClock();
+     Event_Post(EVENT_CLOCK, 0);
+ }
+
+ void RTC_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_RTC_AlarmIRQHandler(&hrtc);
+     PROFILE_END(PROFILE_ISR_RTC);
+ }
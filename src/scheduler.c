@@ -0,0 +1,154 @@
+/**
+ * @file scheduler.c
+ * @brief Cooperative tick scheduler with table-order priorities.
+ *
+ * This source file implements the scheduler declared in scheduler.h.
+ *
+ * Details:
+ * - `Scheduler_Tick()` (interrupt) counts down each task's period and bumps
+ *   its `released` counter when it expires.
+ * - `Scheduler_RunNext()` (main loop) picks the first task in table order whose
+ *   `released` counter differs from its `completed` counter, records it as
+ *   completed and runs it.
+ * - The tick ISR also stamps each release with the tick count. After a run the
+ *   main loop compares the stamp with the current count against the task's
+ *   deadline and counts a miss when it is exceeded.
+ * - A critical task is "due" while it is released or its countdown is within a
+ *   budget. A sheddable task whose budget would overlap a due critical task is
+ *   deferred (it stays released); once it is past its own deadline the release is
+ *   dropped and counted as shed. Lower sheddable tasks with smaller budgets may
+ *   still run in the gap.
+ * - `Scheduler_Pending()` applies the same rule, so the main loop sleeps instead of
+ *   spinning while only deferred work is left. It only reads: releases are shed
+ *   by `Scheduler_RunNext()`, on the main loop's next pass.
+ * - Every task run is bracketed by a profiler probe (`PROFILE_TASK(index)`, profile.h).
+ * - Each counter has exactly one writer (the tick ISR or the main loop), so the
+ *   hand-over needs no critical section; single-byte loads and stores are atomic.
+ *
+ * Dependencies:
+ * - scheduler.h (for the task table type and prototypes)
+ * - profile.h (for the task probes)
+ */
+
+
+
+ #include "scheduler.h"
+ #include "profile.h"
+ #include <stddef.h>
+
+ static const SchedulerTask *taskTable = NULL;
+ static uint8_t taskCount = 0;
+
+ static uint16_t countdown[SCHEDULER_MAX_TASKS];          // Written by Scheduler_Tick only
+ static volatile uint8_t released[SCHEDULER_MAX_TASKS];   // Written by Scheduler_Tick only
+ static uint8_t completed[SCHEDULER_MAX_TASKS];           // Written by Scheduler_RunNext only
+ static volatile uint16_t releaseTick[SCHEDULER_MAX_TASKS]; // Written by Scheduler_Tick only
+ static uint16_t misses[SCHEDULER_MAX_TASKS];             // Written by Scheduler_RunNext only
+ static uint16_t sheds[SCHEDULER_MAX_TASKS];              // Written by Scheduler_RunNext only
+ static volatile uint16_t tickCount = 0;                  // Written by Scheduler_Tick only
+
+ void Scheduler_Init(const SchedulerTask *table, uint8_t count) {
+     if (count > SCHEDULER_MAX_TASKS) {
+         count = SCHEDULER_MAX_TASKS;
+     }
+     for (uint8_t i = 0; i < count; i++) {
+         countdown[i] = table[i].periodTicks;
+         released[i] = 0;
+         completed[i] = 0;
+         misses[i] = 0;
+         sheds[i] = 0;
+     }
+     taskTable = table;
+     taskCount = count;
+ }
+
+ RAMFUNC void Scheduler_Tick(void) {
+     uint16_t now = ++tickCount;
+
+     for (uint8_t i = 0; i < taskCount; i++) {
+         if (--countdown[i] == 0) {
+             countdown[i] = taskTable[i].periodTicks;
+             releaseTick[i] = now;
+             released[i]++;
+         }
+     }
+ }
+
+ uint8_t Scheduler_HasRoom(uint8_t budgetTicks) {
+     for (uint8_t i = 0; i < taskCount; i++) {
+         if (taskTable[i].loadClass == SCHEDULER_CRITICAL &&
+             (released[i] != completed[i] || countdown[i] <= budgetTicks)) {
+             return 0;
+         }
+     }
+     return 1;
+ }
+
+ // Released and allowed to run now (no side effects)
+ static uint8_t Scheduler_CanRun(uint8_t i) {
+     const SchedulerTask *task = &taskTable[i];
+
+     return released[i] != completed[i] &&
+            (task->loadClass == SCHEDULER_CRITICAL || Scheduler_HasRoom(task->budgetTicks));
+ }
+
+ // As Scheduler_CanRun(), and drops a deferred release that is past its deadline
+ static uint8_t Scheduler_Ready(uint8_t i) {
+     uint8_t release = released[i];
+
+     if (release == completed[i]) {
+         return 0;
+     }
+     if (Scheduler_CanRun(i)) {
+         return 1;
+     }
+     if ((uint16_t)(tickCount - releaseTick[i]) >= taskTable[i].deadlineTicks) {
+         completed[i] = release;
+         sheds[i]++;
+     }
+     return 0;
+ }
+
+ uint8_t Scheduler_RunNext(void) {
+     for (uint8_t i = 0; i < taskCount; i++) {
+         if (Scheduler_Ready(i)) {
+             uint8_t release = released[i];
+             uint16_t releasedAt = releaseTick[i];
+             PROFILE_BEGIN();
+
+             // More than one release pending: the task already overran a period
+             if ((uint8_t)(release - completed[i]) > 1) {
+                 misses[i]++;
+             }
+             completed[i] = release;
+             taskTable[i].run();
+             if ((uint16_t)(tickCount - releasedAt) > taskTable[i].deadlineTicks) {
+                 misses[i]++;
+             }
+             PROFILE_END(PROFILE_TASK(i));
+             return 1;
+         }
+     }
+     return 0;
+ }
+
+ const char *Scheduler_GetName(uint8_t index) {
+     return index < taskCount ? taskTable[index].name : NULL;
+ }
+
+ uint8_t Scheduler_Pending(void) {
+     for (uint8_t i = 0; i < taskCount; i++) {
+         if (Scheduler_CanRun(i)) {
+             return 1;
+         }
+     }
+     return 0;
+ }
+
+ uint16_t Scheduler_GetMisses(uint8_t index) {
+     return index < taskCount ? misses[index] : 0;
+ }
+
+ uint16_t Scheduler_GetSheds(uint8_t index) {
+     return index < taskCount ? sheds[index] : 0;
+ }
@@ -0,0 +1,221 @@
+/**
+ * @file speed.c
+ * @brief Tach period capture on TIM1 and the PI spin speed loop.
+ *
+ * This source file implements the speed module declared in speed.h.
+ *
+ * Details:
+ * - TIM1 counts at 1 MHz over its full 16-bit range. The update interrupt
+ *   counts overflows, so a pulse period is `overflows * 65536 + (now - last)`
+ *   microseconds and slow speeds are measured as accurately as fast ones.
+ * - If a capture and an overflow are pending together, a capture value in the
+ *   lower half of the range means the overflow came first; it is counted
+ *   before the period is computed.
+ * - rpm = (60e6 / TACH_PULSES_PER_REV) / period: one division per tach pulse,
+ *   no floating point. No pulse for `SPEED_TIMEOUT_OVERFLOWS` overflows means
+ *   the drum is stopped.
+ * - `Speed_Control()` slews the setpoint toward the target at
+ *   `SPEED_ACCEL_RPM_PER_S`, then sets the duty to
+ *   feed-forward(setpoint) + Kp * error + integral, clamped to the PWM range.
+ *   The integral stops growing while the output is saturated (anti-windup).
+ *
+ * Dependencies:
+ * - speed.h (for the constants and prototypes)
+ * - motor.h (for `Motor_SetDuty()` and `Motor_RpmToDuty()`)
+ * - main.h (for `SPEED_PERIOD_MS` and `Error_Handler()`)
+ * - balance.h (each tach period also feeds the unbalance detector)
+ * - profile.h (for the `PROFILE_ISR_TACH` interrupt probe)
+ * - power.h (for the timer clock)
+ */
+
+
+
+ #include "speed.h"
+ #include "motor.h"
+ #include "main.h"
+ #include "balance.h"
+ #include "profile.h"
+ #include "power.h"
+
+ #define TACH_TIMER_HZ            1000000U
+ #define TACH_RPM_NUMERATOR       ((60U * TACH_TIMER_HZ) / TACH_PULSES_PER_REV)
+ #define SPEED_TIMEOUT_OVERFLOWS  4U   // ~330 ms without a pulse: drum stopped
+
+ // Setpoint change per control period
+ #define SPEED_STEP_RPM           ((SPEED_ACCEL_RPM_PER_S * SPEED_PERIOD_MS) / 1000U)
+
+ // Integral limit, in Q8 duty units
+ #define SPEED_INTEGRAL_LIMIT     (64 << 8)
+
+ TIM_HandleTypeDef htim1;
+
+ static volatile uint16_t measuredRpm = 0;
+ static uint16_t lastCapture = 0;
+ static uint8_t overflows = 0;
+ static uint8_t haveEdge = 0;     // lastCapture is valid
+
+ static uint16_t targetRpm = 0;
+ static uint16_t setpointRpm = 0;
+ static int32_t integral = 0;     // Q8 duty
+
+ void Speed_Init(void) {
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+     TIM_IC_InitTypeDef sConfigIC = {0};
+
+     __HAL_RCC_TIM1_CLK_ENABLE();
+     __HAL_RCC_GPIOA_CLK_ENABLE();
+
+     GPIO_InitStruct.Pin = TACH_PIN;
+     GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+     GPIO_InitStruct.Pull = GPIO_PULLUP;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+     GPIO_InitStruct.Alternate = GPIO_AF2_TIM1;
+     HAL_GPIO_Init(TACH_GPIO_PORT, &GPIO_InitStruct);
+
+     htim1.Instance = TIM1;
+     htim1.Init.Prescaler = (POWER_TIMER_HZ / TACH_TIMER_HZ) - 1U;
+     htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
+     htim1.Init.Period = 0xFFFF;
+     htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+     htim1.Init.RepetitionCounter = 0;
+     htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+     if (HAL_TIM_IC_Init(&htim1) != HAL_OK) {
+         Error_Handler();
+     }
+
+     // Rising edge, maximum digital filter against commutation noise
+     sConfigIC.ICPolarity = TIM_ICPOLARITY_RISING;
+     sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+     sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+     sConfigIC.ICFilter = 0x0F;
+     if (HAL_TIM_IC_ConfigChannel(&htim1, &sConfigIC, TIM_CHANNEL_4) != HAL_OK) {
+         Error_Handler();
+     }
+
+     HAL_NVIC_SetPriority(TIM1_CC_IRQn, 1, 0);
+     HAL_NVIC_EnableIRQ(TIM1_CC_IRQn);
+     HAL_NVIC_SetPriority(TIM1_BRK_UP_TRG_COM_IRQn, 1, 0);
+     HAL_NVIC_EnableIRQ(TIM1_BRK_UP_TRG_COM_IRQn);
+
+     __HAL_TIM_ENABLE_IT(&htim1, TIM_IT_UPDATE);
+     if (HAL_TIM_IC_Start_IT(&htim1, TIM_CHANNEL_4) != HAL_OK) {
+         Error_Handler();
+     }
+ }
+
+ uint16_t Speed_GetRpm(void) {
+     return measuredRpm;
+ }
+
+ void Speed_SetTarget(uint16_t rpm) {
+     if (rpm == 0) {
+         targetRpm = 0;
+         setpointRpm = 0;
+         integral = 0;
+         return;
+     }
+     // Entering closed loop: start the setpoint from the actual drum speed
+     if (targetRpm == 0) {
+         setpointRpm = measuredRpm;
+         integral = 0;
+     }
+     targetRpm = rpm;
+ }
+
+ void Speed_Hold(void) {
+     if (targetRpm != 0) {
+         targetRpm = setpointRpm;
+     }
+ }
+
+ uint16_t Speed_GetTarget(void) {
+     return targetRpm;
+ }
+
+ uint8_t Speed_AtTarget(void) {
+     int32_t error = (int32_t)targetRpm - measuredRpm;
+
+     return targetRpm != 0 && error <= SPEED_TOLERANCE_RPM && error >= -SPEED_TOLERANCE_RPM;
+ }
+
+ void Speed_Control(void) {
+     int32_t error;
+     int32_t output;
+
+     if (targetRpm == 0) {
+         return;
+     }
+
+     // Slew the setpoint so the drum accelerates at a controlled rate
+     if (setpointRpm + SPEED_STEP_RPM < targetRpm) {
+         setpointRpm += SPEED_STEP_RPM;
+     } else if (setpointRpm > targetRpm + SPEED_STEP_RPM) {
+         setpointRpm -= SPEED_STEP_RPM;
+     } else {
+         setpointRpm = targetRpm;
+     }
+
+     error = (int32_t)setpointRpm - measuredRpm;
+     output = ((int32_t)Motor_RpmToDuty(setpointRpm) << 8) + SPEED_KP_Q8 * error + integral;
+
+     // Integrate only while the output is not saturated in the error's direction
+     if (!((output >= ((int32_t)MOTOR_DUTY_MAX << 8) && error > 0) || (output <= 0 && error < 0))) {
+         integral += SPEED_KI_Q8 * error;
+         if (integral > SPEED_INTEGRAL_LIMIT) {
+             integral = SPEED_INTEGRAL_LIMIT;
+         } else if (integral < -SPEED_INTEGRAL_LIMIT) {
+             integral = -SPEED_INTEGRAL_LIMIT;
+         }
+     }
+
+     output >>= 8;
+     if (output > (int32_t)MOTOR_DUTY_MAX) {
+         output = MOTOR_DUTY_MAX;
+     } else if (output < 0) {
+         output = 0;
+     }
+     Motor_SetDuty(FORWARD, (uint8_t)output);
+ }
+
+ // Tach edge: period since the previous edge -> rpm
+ RAMFUNC void Speed_Capture(void) {
+     uint16_t capture = (uint16_t)HAL_TIM_ReadCapturedValue(&htim1, TIM_CHANNEL_4);
+     uint32_t period;
+
+     // Overflow pending and the capture happened after it wrapped
+     if (__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) && capture < 0x8000U) {
+         __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+         Speed_Overflow();
+     }
+
+     if (haveEdge) {
+         period = ((uint32_t)overflows << 16) + capture - lastCapture;
+         if (period != 0) {
+             measuredRpm = (uint16_t)(TACH_RPM_NUMERATOR / period);
+             Balance_Pulse(period);
+         }
+     }
+     lastCapture = capture;
+     overflows = 0;
+     haveEdge = 1;
+ }
+
+ RAMFUNC void Speed_Overflow(void) {
+     if (overflows < SPEED_TIMEOUT_OVERFLOWS) {
+         overflows++;
+         return;
+     }
+     // No pulse for too long: stopped, and the next edge starts a new period
+     measuredRpm = 0;
+     haveEdge = 0;
+ }
+
+ RAMFUNC void TIM1_CC_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_TIM_IRQHandler(&htim1);
+     PROFILE_END(PROFILE_ISR_TACH);
+ }
+
+ RAMFUNC void TIM1_BRK_UP_TRG_COM_IRQHandler(void) {
+     HAL_TIM_IRQHandler(&htim1);
+ }
@@ -7,35 +7,153 @@
  * transmit functions and high-level display control features.
  *
  * Features:
- * - `SPI_Init()` assumes CubeMX handles peripheral init but is available for extensions.
- * - `SPI_SendCommand()` transmits command bytes with CS toggling.
- * - `SPI_SendData()` transmits data bytes with CS toggling.
- * - `SPI_DisplayClear()` sends a display clear command and waits briefly.
- * - `SPI_WriteString()` sends a formatted string with position data (for debugging or display logic simulation).
+ * - `SPI_Init()` configures SPI1 as a transmit-only master, its TX DMA channel and the CS/D/C pins.
+ * - `SPI_SendCommand()` transmits command bytes with CS toggling (D/C low).
+ * - `SPI_SendData()` transmits data bytes with CS toggling (D/C high).
+ * - `SPI_WriteRegion()` addresses a page/column and streams a run of column bytes with CS held
+ *   for the whole region (blocking).
+ * - `SPI_QueueRegion()` is the non-blocking version used by the framebuffer flush in display.c.
+ *
+ * Asynchronous Transmit:
+ * - Queued regions sit in a ring written only by the main loop (head) and consumed only by
+ *   the DMA completion interrupt (tail).
+ * - Each region is two DMA phases under one CS assertion: the three address commands with
+ *   D/C low (copied into the queue slot), then the caller's column data with D/C high.
+ * - `HAL_SPI_TxCpltCallback()` advances the phase, deasserts CS at the end of a region and
+ *   starts the next queued region, so transfers chain without CPU involvement in between.
+ * - Only the idle-to-busy kick-off in `SPI_QueueRegion()` masks interrupts, for a few cycles.
+ * - A DMA transfer that fails to start is handled like a transfer error: the region is
+ *   dropped (CS released) and the chain carries on with the next one, so a refused start
+ *   never leaves the queue busy with nothing in flight.
+ * - `SPI_DisplayClear()` sends a display clear command and waits for it to execute (the boot
+ *   sequence sends the command itself and does not wait, boot.h).
+ * - `SPI_WriteString()` draws text straight to the panel: the page/column address is sent once,
+ *   then each character's glyph columns go out directly from the font table in flash, followed
+ *   by one blank spacing column. No formatting, no copy, and text is clipped at the panel edge
+ *   rather than truncated to a buffer size.
  * - `SPI_CheckStatus()` transmits a dummy byte to test SPI bus functionality.
  *
  * Note:
- * - Actual display protocol may require adjusting `SPI_WriteString()` formatting or using specific controller commands.
- * - Make sure `DISPLAY_CS_Pin` and `DISPLAY_CS_GPIO_Port` are properly initialized.
- * - Ensure `hspi1` is declared and initialized via CubeMX or manually before use.
+ * - Call `SPI_Init()` before any other function in this file.
+ * - Blocking functions wait for the asynchronous queue to drain before touching the bus.
  */
 
 
 
  #include "spi.h"
  #include "main.h"
- #include <string.h>
+ #include "font.h"
+ #include "profile.h"
+ #include "ramfunc.h"
+ 
+ SPI_HandleTypeDef hspi1;
+ DMA_HandleTypeDef hdma_spi1_tx;
+ 
+ // One queued region: address commands, then column data, under one CS assertion
+ typedef struct {
+     uint8_t address[3];
+     const uint8_t *data;
+     uint16_t len;
+ } SPI_Region;
+ 
+ static SPI_Region spiQueue[SPI_QUEUE_SIZE];
+ static volatile uint8_t spiHead = 0;   // Written by the main loop only
+ static volatile uint8_t spiTail = 0;   // Written by the DMA completion interrupt only
+ static volatile uint8_t spiBusy = 0;
+ static volatile uint8_t spiPhase = 0;  // 0 = address commands, 1 = column data
+ 
+ // Start the address phase of the region at the queue tail (CS asserted); 0 if the
+ // DMA transfer did not start
+ RAMFUNC static uint8_t SPI_StartRegion(void) {
+     SPI_Region *region = &spiQueue[spiTail & (SPI_QUEUE_SIZE - 1)];
+ 
+     spiPhase = 0;
+     HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_RESET);
+     HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_RESET);
+     return HAL_SPI_Transmit_DMA(&hspi1, region->address, sizeof(region->address)) == HAL_OK;
+ }
+ 
+ // Close the region at the queue tail (CS released) and start the next one, dropping
+ // any that will not start; idle once the queue is empty
+ RAMFUNC static void SPI_EndRegion(void) {
+     do {
+         HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_SET);
+         spiTail++;
+         if (spiTail == spiHead) {
+             spiBusy = 0;
+             return;
+         }
+     } while (!SPI_StartRegion());
+ }
  
- extern SPI_HandleTypeDef hspi1; // Assuming SPI1 is used
+ // Wait for queued DMA transfers before a blocking transfer uses the bus
+ static void SPI_WaitIdle(void) {
+     while (spiBusy) {
+     }
+ }
  
  // Function to initialize SPI
  void SPI_Init() {
-     // This function assumes SPI is configured in CubeMX
-     // Any additional low-level configurations can be added here if needed
+     GPIO_InitTypeDef GPIO_InitStruct = {0};
+ 
+     __HAL_RCC_SPI1_CLK_ENABLE();
+     __HAL_RCC_DMA1_CLK_ENABLE();
+     __HAL_RCC_GPIOA_CLK_ENABLE();
+     __HAL_RCC_GPIOB_CLK_ENABLE();
+ 
+     // CS idles high (deselected), D/C idles high (data)
+     HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin | DISPLAY_DC_Pin, GPIO_PIN_SET);
+     GPIO_InitStruct.Pin = DISPLAY_CS_Pin | DISPLAY_DC_Pin;
+     GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+     GPIO_InitStruct.Pull = GPIO_NOPULL;
+     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+     HAL_GPIO_Init(DISPLAY_CS_GPIO_Port, &GPIO_InitStruct);
+ 
+     GPIO_InitStruct.Pin = DISPLAY_SCK_Pin | DISPLAY_MOSI_Pin;
+     GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+     GPIO_InitStruct.Alternate = GPIO_AF0_SPI1;
+     HAL_GPIO_Init(DISPLAY_SPI_GPIO_Port, &GPIO_InitStruct);
+ 
+     hdma_spi1_tx.Instance = DMA1_Channel2;
+     hdma_spi1_tx.Init.Request = DMA_REQUEST_SPI1_TX;
+     hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+     hdma_spi1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+     hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+     hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+     hdma_spi1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+     hdma_spi1_tx.Init.Mode = DMA_NORMAL;
+     hdma_spi1_tx.Init.Priority = DMA_PRIORITY_LOW;
+     if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK) {
+         Error_Handler();
+     }
+     __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+ 
+     hspi1.Instance = SPI1;
+     hspi1.Init.Mode = SPI_MODE_MASTER;
+     hspi1.Init.Direction = SPI_DIRECTION_1LINE;
+     hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
+     hspi1.Init.CLKPolarity = SPI_POLARITY_LOW;
+     hspi1.Init.CLKPhase = SPI_PHASE_1EDGE;
+     hspi1.Init.NSS = SPI_NSS_SOFT;
+     hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;  // 6 MHz SCK from the fixed 12 MHz PCLK (power.h)
+     hspi1.Init.FirstBit = SPI_FIRSTBIT_MSB;
+     hspi1.Init.TIMode = SPI_TIMODE_DISABLE;
+     hspi1.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+     hspi1.Init.NSSPMode = SPI_NSS_PULSE_DISABLE;
+     if (HAL_SPI_Init(&hspi1) != HAL_OK) {
+         Error_Handler();
+     }
+ 
+     HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+     HAL_NVIC_SetPriority(SPI1_IRQn, 3, 0);
+     HAL_NVIC_EnableIRQ(SPI1_IRQn);
  }
  
  // Function to send a command to the display
  void SPI_SendCommand(uint8_t cmd) {
+     SPI_WaitIdle();
+     HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_RESET);
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_RESET);
      HAL_SPI_Transmit(&hspi1, &cmd, 1, HAL_MAX_DELAY);
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_SET);
@@ -43,6 +161,8 @@
  
  // Function to send data to the display
  void SPI_SendData(uint8_t data) {
+     SPI_WaitIdle();
+     HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_SET);
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_RESET);
      HAL_SPI_Transmit(&hspi1, &data, 1, HAL_MAX_DELAY);
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_SET);
@@ -50,23 +170,121 @@
  
  // Function to clear the display
  void SPI_DisplayClear() {
-     SPI_SendCommand(0x01); // Command to clear display (depends on display controller)
-     HAL_Delay(2); // Delay for command execution
+     SPI_SendCommand(DISPLAY_CMD_CLEAR);
+     HAL_Delay(DISPLAY_CLEAR_MS); // Delay for command execution
  }
  
- // Function to write a string to the display at a specific row and column
- void SPI_WriteString(uint8_t row, uint8_t col, const char *text) {
-     char buffer[20];
-     snprintf(buffer, sizeof(buffer), "[%d,%d] %s", row, col, text);
+ // Assert CS, send the page/column address, leave D/C high for column data (blocking)
+ static void SPI_BeginRegion(uint8_t page, uint8_t col) {
+     uint8_t address[3];
+ 
+     address[0] = DISPLAY_CMD_SET_PAGE | (page & 0x07);
+     address[1] = DISPLAY_CMD_SET_COL_HIGH | (col >> 4);
+     address[2] = DISPLAY_CMD_SET_COL_LOW | (col & 0x0F);
  
+     SPI_WaitIdle();
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_RESET);
-     HAL_SPI_Transmit(&hspi1, (uint8_t *)buffer, strlen(buffer), HAL_MAX_DELAY);
+     HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_RESET);
+     HAL_SPI_Transmit(&hspi1, address, sizeof(address), HAL_MAX_DELAY);
+     HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_SET);
+ }
+ 
+ // Function to draw text on the panel at a page and pixel column, returns characters drawn
+ uint8_t SPI_WriteString(uint8_t page, uint8_t col, const char *text) {
+     static const uint8_t spacing = 0x00;
+     uint8_t count = 0;
+ 
+     if (*text == '\0' || col + FONT_GLYPH_WIDTH + 1 > DISPLAY_PANEL_COLUMNS) {
+         return 0;
+     }
+     SPI_BeginRegion(page, col);
+     while (*text != '\0' && col + FONT_GLYPH_WIDTH + 1 <= DISPLAY_PANEL_COLUMNS) {
+         // Glyph columns straight from flash, then the spacing column
+         HAL_SPI_Transmit(&hspi1, (uint8_t *)FONT_GLYPH(*text), FONT_GLYPH_WIDTH, HAL_MAX_DELAY);
+         HAL_SPI_Transmit(&hspi1, (uint8_t *)&spacing, 1, HAL_MAX_DELAY);
+         col += FONT_GLYPH_WIDTH + 1;
+         text++;
+         count++;
+     }
+     HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_SET);
+     return count;
+ }
+ 
+ // Function to write a run of framebuffer columns as one burst
+ void SPI_WriteRegion(uint8_t page, uint8_t col, const uint8_t *data, uint16_t len) {
+     SPI_BeginRegion(page, col);
+     HAL_SPI_Transmit(&hspi1, (uint8_t *)data, len, HAL_MAX_DELAY);
      HAL_GPIO_WritePin(DISPLAY_CS_GPIO_Port, DISPLAY_CS_Pin, GPIO_PIN_SET);
  }
  
  // Function to check SPI communication status
  HAL_StatusTypeDef SPI_CheckStatus() {
      uint8_t dummyData = 0x00;
+     if (spiBusy) {
+         return HAL_BUSY;
+     }
      return HAL_SPI_Transmit(&hspi1, &dummyData, 1, 100);
  }
+ 
+ // Queue a region transfer, returns 0 if the queue is full (try again next flush)
+ uint8_t SPI_QueueRegion(uint8_t page, uint8_t col, const uint8_t *data, uint16_t len) {
+     uint8_t head = spiHead;
+     SPI_Region *region;
+ 
+     if ((uint8_t)(head - spiTail) >= SPI_QUEUE_SIZE) {
+         return 0;
+     }
+     region = &spiQueue[head & (SPI_QUEUE_SIZE - 1)];
+     region->address[0] = DISPLAY_CMD_SET_PAGE | (page & 0x07);
+     region->address[1] = DISPLAY_CMD_SET_COL_HIGH | (col >> 4);
+     region->address[2] = DISPLAY_CMD_SET_COL_LOW | (col & 0x0F);
+     region->data = data;
+     region->len = len;
+     __DMB();  // Region written before it is published
+     spiHead = head + 1;
+ 
+     // Kick off the chain if the DMA side has gone idle
+     __disable_irq();
+     if (!spiBusy) {
+         spiBusy = 1;
+         if (!SPI_StartRegion()) {
+             SPI_EndRegion();
+         }
+     }
+     __enable_irq();
+     return 1;
+ }
+ 
+ uint8_t SPI_IsBusy(void) {
+     return spiBusy;
+ }
+ 
+ // DMA phase finished: send the data phase, or close the region and start the next one
+ RAMFUNC void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+     if (hspi->Instance != SPI1 || !spiBusy) {
+         return;
+     }
+     if (spiPhase == 0) {
+         SPI_Region *region = &spiQueue[spiTail & (SPI_QUEUE_SIZE - 1)];
+         spiPhase = 1;
+         HAL_GPIO_WritePin(DISPLAY_DC_GPIO_Port, DISPLAY_DC_Pin, GPIO_PIN_SET);
+         if (HAL_SPI_Transmit_DMA(&hspi1, (uint8_t *)region->data, region->len) == HAL_OK) {
+             return;
+         }
+         // Data phase refused: drop the region as on a transfer error
+     }
+     SPI_EndRegion();
+ }
+ 
+ // Drop the region in flight and carry on with the rest of the queue
+ void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+     spiPhase = 1;
+     HAL_SPI_TxCpltCallback(hspi);
+ }
+ 
+ RAMFUNC void SPI1_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_SPI_IRQHandler(&hspi1);
+     PROFILE_END(PROFILE_ISR_SPI);
+ }
  
\ No newline at end of file
@@ -0,0 +1,136 @@
+/**
+ * @file steptimer.c
+ * @brief One-pulse TIM14 deadlines for the washer's timed phases.
+ *
+ * This source file implements the step timer declared in steptimer.h.
+ *
+ * Details:
+ * - TIM14 counts at `STEP_TIMER_TICKS_PER_MS` kHz in one-pulse mode: the counter
+ *   stops by itself at the update event, so an armed deadline costs exactly one
+ *   interrupt (plus one per 32.7 s for longer deadlines, which are split).
+ * - Auto-reload preload is off, so a new pulse length takes effect at once.
+ * - A zero deadline runs as a 1 ms pulse rather than expiring in
+ *   `StepTimer_Start()`: the interrupt stays the only producer of
+ *   `EVENT_STEP_TIMER` (event.h).
+ * - Each `StepTimer_Start()` bumps `sequence`; the value travels in the event so
+ *   the washer can drop an event that was queued before a restart or cancel.
+ * - With `STEP_TIMER_CLOSE_VALVES` the interrupt closes both valves before
+ *   posting the event.
+ *
+ * Dependencies:
+ * - steptimer.h (for the flags and prototypes)
+ * - event.h (for `Event_Post()`)
+ * - main.h (for `htim14`, the valve pins and `Error_Handler()`)
+ * - profile.h (for the `PROFILE_ISR_STEP_TIMER` interrupt probe)
+ * - power.h (for the timer clock)
+ */
+
+
+
+ #include "steptimer.h"
+ #include "event.h"
+ #include "main.h"
+ #include "profile.h"
+ #include "power.h"
+
+ // Longest single pulse, in ms (16-bit auto-reload at STEP_TIMER_TICKS_PER_MS)
+ #define STEP_TIMER_MAX_PULSE_MS  (0x10000U / STEP_TIMER_TICKS_PER_MS)
+
+ TIM_HandleTypeDef htim14;
+
+ static volatile uint32_t remainingMs = 0;  // Still to run after the current pulse
+ static volatile uint8_t running = 0;
+ static volatile uint8_t sequence = 0;
+ static uint8_t startFlags = 0;
+
+ // Start the next pulse of the armed deadline
+ RAMFUNC static void StepTimer_Pulse(void) {
+     uint32_t pulseMs = remainingMs;
+
+     if (pulseMs > STEP_TIMER_MAX_PULSE_MS) {
+         pulseMs = STEP_TIMER_MAX_PULSE_MS;
+     }
+     remainingMs -= pulseMs;
+     __HAL_TIM_SET_AUTORELOAD(&htim14, pulseMs * STEP_TIMER_TICKS_PER_MS - 1U);
+     __HAL_TIM_SET_COUNTER(&htim14, 0);
+     __HAL_TIM_CLEAR_FLAG(&htim14, TIM_FLAG_UPDATE);
+     __HAL_TIM_ENABLE(&htim14);
+ }
+
+ // Deadline reached: act on it in the interrupt, then tell the main loop
+ RAMFUNC static void StepTimer_Expire(void) {
+     running = 0;
+     if (startFlags & STEP_TIMER_CLOSE_VALVES) {
+         HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
+     }
+     Event_Post(EVENT_STEP_TIMER, sequence);
+ }
+
+ void StepTimer_Init(void) {
+     __HAL_RCC_TIM14_CLK_ENABLE();
+
+     htim14.Instance = TIM14;
+     htim14.Init.Prescaler = (POWER_TIMER_HZ / (STEP_TIMER_TICKS_PER_MS * 1000U)) - 1U;
+     htim14.Init.CounterMode = TIM_COUNTERMODE_UP;
+     htim14.Init.Period = 0xFFFF;
+     htim14.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+     htim14.Init.RepetitionCounter = 0;
+     htim14.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+     if (HAL_TIM_Base_Init(&htim14) != HAL_OK) {
+         Error_Handler();
+     }
+
+     // One-pulse mode: the counter disables itself at the update event
+     htim14.Instance->CR1 |= TIM_CR1_OPM;
+     __HAL_TIM_CLEAR_FLAG(&htim14, TIM_FLAG_UPDATE);
+     __HAL_TIM_ENABLE_IT(&htim14, TIM_IT_UPDATE);
+
+     HAL_NVIC_SetPriority(TIM14_IRQn, 1, 0);
+     HAL_NVIC_EnableIRQ(TIM14_IRQn);
+ }
+
+ void StepTimer_Start(uint32_t ms, uint8_t flags) {
+     __disable_irq();
+     __HAL_TIM_DISABLE(&htim14);
+     __HAL_TIM_CLEAR_FLAG(&htim14, TIM_FLAG_UPDATE);
+     sequence++;
+     startFlags = flags;
+     remainingMs = (ms != 0U) ? ms : 1U;
+     running = 1;
+     StepTimer_Pulse();
+     __enable_irq();
+ }
+
+ void StepTimer_Cancel(void) {
+     __disable_irq();
+     __HAL_TIM_DISABLE(&htim14);
+     __HAL_TIM_CLEAR_FLAG(&htim14, TIM_FLAG_UPDATE);
+     sequence++;
+     running = 0;
+     __enable_irq();
+ }
+
+ uint8_t StepTimer_Running(void) {
+     return running;
+ }
+
+ uint8_t StepTimer_IsCurrent(uint8_t eventSequence) {
+     return eventSequence == sequence;
+ }
+
+ RAMFUNC void StepTimer_Elapsed(void) {
+     if (!running) {
+         return;
+     }
+     if (remainingMs > 0) {
+         StepTimer_Pulse();
+     } else {
+         StepTimer_Expire();
+     }
+ }
+
+ RAMFUNC void TIM14_IRQHandler(void) {
+     PROFILE_BEGIN();
+     HAL_TIM_IRQHandler(&htim14);
+     PROFILE_END(PROFILE_ISR_STEP_TIMER);
+ }
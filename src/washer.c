@@ -8,12 +8,10 @@
  * =============================
  *        PIN DEFINITIONS
  * =============================
- * Replace the following macros with actual values in main.h or pin configuration file:
- *   - MOTOR_FORWARD_PIN
- *   - MOTOR_REVERSE_PIN
+ * The following macros are defined in main.h:
+ *   - MOTOR_FORWARD_PIN, MOTOR_REVERSE_PIN (TIM3 PWM, driven through motor.h only)
  *   - MOTOR_GPIO_PORT
- *   - WATER_HOT_PIN
- *   - WATER_COLD_PIN
+ *   - WATER_HOT_PIN, WATER_COLD_PIN (driven through mixer.h only)
  *   - WATER_GPIO_PORT
  *
  * =============================
@@ -21,11 +19,55 @@
  * =============================
  * WasherState Enum:
  *   - IDLE        : All outputs off; waiting for Start input.
- *   - FILL_WATER  : Turns on water valves for fixed duration (10s), then transitions to WASH.
- *   - WASH        : (To be implemented) Forward/Reverse motor logic, then transitions to RINSE.
- *   - RINSE       : (To be implemented) Motor rinse logic, then transitions to SPIN.
- *   - SPIN        : Forward spin only, then transitions to IDLE.
- *   - ERROR       : All outputs off, shows error on display.
+ *   - FILL_WATER  : Opens the water valves until the water level (adc.h) reaches the step's
+ *                   `fillLevel`. The valves close as soon as it does; the fill ends once the
+ *                   level has held for 2s, and the valves reopen if it sinks more than 3%
+ *                   below the target meanwhile (absorbed by the load, sloshing). The TIM14
+ *                   step timer is a 4 minute timeout: it closes the valves from its
+ *                   interrupt and the washer goes to WASHER_ERROR.
+ *                   The mixer task (mixer.h) time-proportions the hot and cold valves with
+ *                   a fixed-point PI on the measured temperature (0.1 °C, adc.h) toward
+ *                   the step's target; a cold step opens the cold valve only.
+ *   - WASH        : Agitates (forward, pause, reverse, pause) for the step's duration, with a
+ *                   soft start and stop on every stroke (motor.h).
+ *   - RINSE       : Same as WASH, with the rinse step's pattern and duration.
+ *   - SPIN        : Waits for the drum to stop (a rinse can end mid-stroke in reverse),
+ *                   then spins forward at the step's rpm, held by the tach PI loop (speed.h);
+ *                   braking at the end uses the spin ramp. The unbalance detector
+ *                   (balance.h) steers the ramp: OK keeps accelerating, HOLD holds the
+ *                   current speed (up to 5s) for the load to settle, REDISTRIBUTE (or a
+ *                   hold that does not clear) drops to tumble speed for 6s and ramps
+ *                   again. After 3 redistributions the step finishes at a reduced speed.
+ *                   Retries run inside the step's duration.
+ *   - DONE        : Last step finished; all outputs off until Start or Stop.
+ *   - WASHER_ERROR: All outputs off (motor cut without a ramp), shows error on display.
+ *                   `fault` records why (fill timeout, missing step); it stays set after
+ *                   Stop, so telemetry still shows it, and clears when Start begins a cycle.
+ *
+ * =============================
+ *        PROGRAM ENGINE
+ * =============================
+ * The selected program is a const step list in flash (program.h). `stepIndex` is the
+ * cursor into it: each step fills first if its `fillLevel` is non-zero, then runs in its
+ * state (WASH, RINSE or SPIN) until `durationSeconds` elapse, and the cursor moves on.
+ * The step duration and the fill timeout are TIM14 one-pulse deadlines (steptimer.h): the
+ * timer posts `EVENT_STEP_TIMER` and `Washer_HandleStepTimer()` advances the state, so
+ * phase lengths are exact to the millisecond rather than to the control task period.
+ * Past the last step the washer goes to DONE. Every tick does one table lookup and a
+ * few time comparisons, independent of the program length.
+ *
+ * =============================
+ *        POWER-FAIL RESUME
+ * =============================
+ * Entering a step writes program, step and the step time already run to the flash
+ * journal (journal.h), and a running step adds a checkpoint every
+ * `JOURNAL_CHECKPOINT_MS`. DONE, Stop and WASHER_ERROR close the journal with an end
+ * record. The journal's page erase (`Journal_Prepare()`) only runs in IDLE and DONE,
+ * with the drum still and the Modbus bus quiet, never while a program runs. Once the boot stages are done (boot.h), so the level and temperature readings
+ * are real, `Washer_Resume()` restarts a cycle the journal shows as running at its step: the fill
+ * (if the step has one) runs again, which ends quickly with the water still in the drum,
+ * and the step's deadline is shortened by the recorded time. At most one checkpoint
+ * interval of a step is repeated.
  *
  * =============================
  *        FUNCTIONS
@@ -36,28 +78,35 @@
  *   - Resets state, program index, timer, and motor direction.
  *   - Updates display to reflect washer state.
  *
+ * void Washer_Resume(WasherControl *washer)
+ *   - Resumes the cycle the journal shows as cut by a power loss, if any.
+ *   - Called once, when the boot stages have finished.
+ *
  * void Washer_Update(WasherControl *washer)
- *   - Main logic handler. Called periodically in main loop.
+ *   - Main logic handler. Called periodically by the scheduler's control task.
  *   - Transitions between states and controls outputs based on elapsed time.
- *   - Uses HAL_GetTick() for timing fill duration.
- *   - Motor control logic for WASH/RINSE is currently a placeholder.
+ *   - Uses HAL_GetTick() against `phaseTimer` for the agitation cycle, the spin phases
+ *     and the fill level settle time; step durations and the fill timeout are not
+ *     polled here (see Washer_HandleStepTimer).
+ *   - Does not redraw the display; the scheduler's display task shows the state.
  *
- * void Washer_HandleButtonPress(WasherControl *washer, int button)
- *   - Handles manual button input:
- *       * Start: Begins cycle from IDLE.
- *       * Stop : Forces state to IDLE.
- *       * Up   : Increments program index (max 29).
+ * void Washer_HandleStepTimer(WasherControl *washer, uint8_t sequence)
+ *   - Handles EVENT_STEP_TIMER: a fill timeout moves to WASHER_ERROR, a finished phase
+ *     moves to the next step. Stale deadlines (after Stop/restart) are ignored.
+ *
+ * void Washer_GetStatus(WasherStatus *status)
+ *   - Copies the last published snapshot (state, program, step, remaining time,
+ *     temperature, drum rpm, water level, fault). Every control entry point publishes one
+ *     when it returns. Wait-free for readers that preempt the control path (they
+ *     always find a complete buffer); a reader preempted by a publish retries once.
+ *
+ * void Washer_HandleButtonPress(WasherControl *washer, int button, ButtonAction action)
+ *   - Handles debounced button events (presses; Up/Down also auto-repeat):
+ *       * Start: Begins the selected program at its first step (from IDLE or DONE).
+ *       * Stop : Forces state to IDLE with all outputs off.
+ *       * Up   : Increments program index (max PROGRAM_COUNT - 1).
  *       * Down : Decrements program index (min 0).
  *   - Updates display when program index or state changes.
- *
- * =============================
- *        TODO / FUTURE
- * =============================
- * - Implement timed motor control for WASH and RINSE:
- *     * Forward 16s → Stop 4s → Reverse 16s (repeat or advance step)
- * - Implement spinTimer logic to allow SPIN to run for specific time.
- * - Store/execute multiple steps per program (future enhancement).
- * - Replace placeholder GPIO_PIN_X/Y macros with actual pin assignments.
  */
 
 
@@ -65,10 +114,254 @@
  #include "washer.h"
  #include "display.h"
  #include "main.h"
+ #include "program.h"
+ #include "steptimer.h"
+ #include "motor.h"
+ #include "speed.h"
+ #include "balance.h"
+ #include "mixer.h"
+ #include "adc.h"
+ #include "journal.h"
+ #include "modbus.h"
+ #include <stddef.h>
+ 
+ // Fill timeout (TIM14), level hysteresis in percent, and how long the level must hold
+ #define WASHER_FILL_TIMEOUT_MS    240000U
+ #define WASHER_LEVEL_HYSTERESIS   3U
+ #define WASHER_LEVEL_SETTLE_MS    2000U
+ 
+ // Spin phases (spinPhase)
+ #define WASHER_SPIN_RAMP          0
+ #define WASHER_SPIN_HOLD          1
+ #define WASHER_SPIN_REDISTRIBUTE  2
+ #define WASHER_SPIN_SETTLE        3
+ 
+ // Unbalance handling: hold time, redistribution tumble, retries and fallback speed
+ #define WASHER_BALANCE_HOLD_MS    5000U
+ #define WASHER_REDISTRIBUTE_MS    6000U
+ #define WASHER_TUMBLE_RPM         45U
+ #define WASHER_SPIN_ATTEMPTS      3U
+ #define WASHER_SAFE_SPIN_RPM      400U
+ 
+ // Mixer stopped and valves closed, speed loop released, drum ramped down to standstill
+ static void Washer_AllOff(void) {
+     Speed_SetTarget(0);
+     Motor_Stop();
+     Mixer_Stop();
+ }
+ 
+ // Stop on a fault; WASHER_ERROR cuts the outputs on the next update
+ static void Washer_Fail(WasherControl *washer, WasherFault fault) {
+     washer->state = WASHER_ERROR;
+     washer->fault = fault;
+ }
+ 
+ // Journal the current step with `elapsedMs` of it already run
+ static void Washer_Checkpoint(WasherControl *washer, uint32_t elapsedMs, uint32_t now) {
+     JournalEntry entry;
+
+     entry.programIndex = (uint8_t)washer->programIndex;
+     entry.stepIndex = (uint8_t)washer->stepIndex;
+     entry.elapsedSeconds = (uint16_t)(elapsedMs / 1000U);
+     Journal_Record(&entry);
+     washer->journalTimer = now;
+ }
+ 
+ // Run the step's wash, rinse or spin phase until its deadline, less any time run before a power cut.
+ // A step that had already run its full time ends at once rather than starting over.
+ static void Washer_RunStep(WasherControl *washer, const ProgramStep *step, uint32_t now) {
+     uint32_t durationMs = step->durationSeconds * 1000U;
+     uint32_t elapsedMs = (washer->resumeMs < durationMs) ? washer->resumeMs : durationMs;
+ 
+     washer->resumeMs = 0;
+     washer->state = (WasherState)step->state;
+     washer->timer = now - elapsedMs;
+     washer->journalTimer = now;
+     washer->phaseTimer = now;
+     washer->agitationPhase = 0;
+     washer->spinPhase = (washer->state == SPIN) ? WASHER_SPIN_SETTLE : WASHER_SPIN_RAMP;
+     washer->spinAttempts = 0;
+     StepTimer_Start(durationMs - elapsedMs, 0);
+ }
+ 
+ // Enter the current step: fill first if it asks for water, otherwise run it directly
+ static void Washer_StartStep(WasherControl *washer, uint32_t now) {
+     const ProgramStep *step = Program_GetStep(washer->programIndex, washer->stepIndex);
+ 
+     Washer_AllOff();
+     washer->timer = now;
+     washer->direction = FORWARD;
+     if (step == NULL) {
+         StepTimer_Cancel();
+         washer->state = DONE;
+         Journal_Clear();
+         return;
+     }
+     Washer_Checkpoint(washer, washer->resumeMs, now);
+     if (step->fillLevel > 0) {
+         washer->state = FILL_WATER;
+         washer->levelReached = 0;
+         StepTimer_Start(WASHER_FILL_TIMEOUT_MS, STEP_TIMER_CLOSE_VALVES);
+         Mixer_Start(step->temperature);
+     } else {
+         Washer_RunStep(washer, step, now);
+     }
+ }
+ 
+ // Level comparator with hysteresis; 1 once the level has held at the target long enough
+ static uint8_t Washer_FillComplete(WasherControl *washer, const ProgramStep *step, uint32_t now) {
+     uint8_t level = Read_WaterLevel();
+ 
+     if (level >= step->fillLevel) {
+         if (!washer->levelReached) {
+             // Stop the inflow and let the level settle
+             washer->levelReached = 1;
+             washer->phaseTimer = now;
+             Mixer_Stop();
+         }
+     } else if (washer->levelReached && level + WASHER_LEVEL_HYSTERESIS < step->fillLevel) {
+         // Sank below the band: top up
+         washer->levelReached = 0;
+         Mixer_Start(step->temperature);
+     }
+     return washer->levelReached && now - washer->phaseTimer >= WASHER_LEVEL_SETTLE_MS;
+ }
+ 
+ // Forward, pause, reverse, pause; one phase comparison per tick, ramps run on DMA
+ static void Washer_Agitate(WasherControl *washer, const AgitationTiming *timing, uint32_t now) {
+     uint32_t phaseMs = ((washer->agitationPhase & 1) ? timing->pauseSeconds : timing->runSeconds) * 1000U;
+ 
+     if (timing->runSeconds == 0) {
+         Motor_Stop();
+         return;
+     }
+     if (now - washer->phaseTimer >= phaseMs) {
+         washer->agitationPhase = (washer->agitationPhase + 1) & 3;
+         washer->phaseTimer = now;
+     }
+     switch (washer->agitationPhase) {
+         case 0:
+             washer->direction = FORWARD;
+             Motor_Run(FORWARD, timing->rpm, MOTOR_RAMP_SOFT);
+             break;
+         case 2:
+             washer->direction = REVERSE;
+             Motor_Run(REVERSE, timing->rpm, MOTOR_RAMP_SOFT);
+             break;
+         default:
+             Motor_Stop();
+             break;
+     }
+ }
+ 
+ // Spin ramp steered by the unbalance detector: continue, hold, or redistribute and retry
+ static void Washer_Spin(WasherControl *washer, const ProgramStep *step, uint32_t now) {
+     BalanceVerdict verdict;
+ 
+     washer->direction = FORWARD;
+     if (step->spinRpm == 0) {
+         Washer_AllOff();
+         return;
+     }
+ 
+     // The previous step may end mid-stroke: let that ramp down finish and the drum stop
+     if (washer->spinPhase == WASHER_SPIN_SETTLE) {
+         if (Motor_GetDuty() != 0 || Motor_IsRamping() || Speed_GetRpm() != 0) {
+             return;
+         }
+         Balance_Reset();
+         washer->spinPhase = WASHER_SPIN_RAMP;
+         washer->phaseTimer = now;
+     }
+ 
+     if (washer->spinPhase == WASHER_SPIN_REDISTRIBUTE) {
+         if (now - washer->phaseTimer < WASHER_REDISTRIBUTE_MS) {
+             return;
+         }
+         // Load tumbled back into place: measure again from the start of the ramp
+         Balance_Reset();
+         washer->spinPhase = WASHER_SPIN_RAMP;
+         washer->phaseTimer = now;
+     }
+ 
+     // Out of retries: finish the step at a speed any load tolerates
+     if (washer->spinAttempts >= WASHER_SPIN_ATTEMPTS) {
+         Speed_SetTarget(step->spinRpm < WASHER_SAFE_SPIN_RPM ? step->spinRpm : WASHER_SAFE_SPIN_RPM);
+         return;
+     }
+ 
+     verdict = Balance_GetVerdict();
+     if (verdict == BALANCE_REDISTRIBUTE ||
+         (washer->spinPhase == WASHER_SPIN_HOLD && now - washer->phaseTimer >= WASHER_BALANCE_HOLD_MS)) {
+         washer->spinAttempts++;
+         washer->spinPhase = WASHER_SPIN_REDISTRIBUTE;
+         washer->phaseTimer = now;
+         Speed_SetTarget(0);
+         Motor_Run(FORWARD, WASHER_TUMBLE_RPM, MOTOR_RAMP_SOFT);
+     } else if (verdict == BALANCE_HOLD) {
+         if (washer->spinPhase != WASHER_SPIN_HOLD) {
+             washer->spinPhase = WASHER_SPIN_HOLD;
+             washer->phaseTimer = now;
+             Speed_Hold();
+         }
+     } else if (washer->spinPhase == WASHER_SPIN_HOLD && verdict == BALANCE_OK) {
+         // Settled: carry on up the ramp
+         washer->spinPhase = WASHER_SPIN_RAMP;
+         Speed_SetTarget(step->spinRpm);
+     } else if (washer->spinPhase == WASHER_SPIN_RAMP) {
+         Speed_SetTarget(step->spinRpm);
+     }
+ }
+ 
+ // Published copy for readers outside the control path: two buffers and a sequence.
+ // The writer fills buffer (sequence + 1) & 1 and then bumps the sequence, so the
+ // buffer a reader copies is never the one being written unless the writer
+ // published in the meantime, which the reader notices and retries.
+ static WasherStatus statusBuffer[2];
+ static volatile uint32_t statusSequence = 0;
+ 
+ // Milliseconds left before the running deadline (step duration or fill timeout)
+ static uint32_t Washer_RemainingMs(const WasherControl *washer, uint32_t now) {
+     const ProgramStep *step = Program_GetStep(washer->programIndex, washer->stepIndex);
+     uint32_t total;
+     uint32_t elapsed = now - washer->timer;
  
- #define MOTOR_FORWARD_PIN GPIO_PIN_X  // Replace X with actual pin number
- #define MOTOR_REVERSE_PIN GPIO_PIN_Y  // Replace Y with actual pin number
- #define MOTOR_GPIO_PORT GPIOB         // Adjust as needed
+     if (washer->state == FILL_WATER) {
+         total = WASHER_FILL_TIMEOUT_MS;
+     } else if ((washer->state == WASH || washer->state == RINSE || washer->state == SPIN) && step != NULL) {
+         total = step->durationSeconds * 1000U;
+     } else {
+         return 0;
+     }
+     return elapsed < total ? total - elapsed : 0;
+ }
+ 
+ static void Washer_Publish(const WasherControl *washer) {
+     uint32_t next = statusSequence + 1U;
+     WasherStatus *status = &statusBuffer[next & 1U];
+ 
+     status->state = washer->state;
+     status->programIndex = (uint8_t)washer->programIndex;
+     status->stepIndex = (uint8_t)washer->stepIndex;
+     status->remainingSeconds = (uint16_t)((Washer_RemainingMs(washer, HAL_GetTick()) + 999U) / 1000U);
+     status->temperature = Read_Temperature();
+     status->rpm = Speed_GetRpm();
+     status->waterLevel = Read_WaterLevel();
+     status->fault = (uint8_t)washer->fault;
+     __DMB();  // Buffer complete before it is published
+     statusSequence = next;
+ }
+ 
+ void Washer_GetStatus(WasherStatus *status) {
+     uint32_t sequence;
+ 
+     do {
+         sequence = statusSequence;
+         __DMB();
+         *status = statusBuffer[sequence & 1U];
+         __DMB();
+     } while (sequence != statusSequence);
+ }
  
  // Initialize washer state
  void Washer_Init(WasherControl *washer) {
@@ -77,74 +370,149 @@
      washer->stepIndex = 0;
      washer->timer = 0;
      washer->direction = FORWARD;
+     washer->agitationPhase = 0;
+     washer->phaseTimer = 0;
+     washer->spinPhase = WASHER_SPIN_RAMP;
+     washer->spinAttempts = 0;
+     washer->levelReached = 0;
+     washer->resumeMs = 0;
+     washer->journalTimer = 0;
+     washer->fault = WASHER_FAULT_NONE;
+     Washer_Publish(washer);
+     Display_UpdateWasherState(washer->state, washer->programIndex);
+ }
+ 
+ // A cycle cut by a power loss carries on where the journal left it
+ void Washer_Resume(WasherControl *washer) {
+     JournalEntry entry;
+ 
+     if (Journal_Init(&entry)) {
+         if (Program_GetStep(entry.programIndex, entry.stepIndex) != NULL) {
+             washer->programIndex = entry.programIndex;
+             washer->stepIndex = entry.stepIndex;
+             washer->resumeMs = entry.elapsedSeconds * 1000U;
+             Washer_StartStep(washer, HAL_GetTick());
+         } else {
+             // Not a step of the programs in this firmware
+             Journal_Clear();
+         }
+     }
+     Washer_Publish(washer);
      Display_UpdateWasherState(washer->state, washer->programIndex);
  }
  
  void Washer_Update(WasherControl *washer) {
-     static uint32_t lastTime = 0;
      uint32_t currentTime = HAL_GetTick();
+     const ProgramStep *step = Program_GetStep(washer->programIndex, washer->stepIndex);
  
      switch (washer->state) {
          case IDLE:
+         case DONE:
              // Ensure all outputs are off
-             HAL_GPIO_WritePin(MOTOR_GPIO_PORT, MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN, GPIO_PIN_RESET);
-             HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
+             Washer_AllOff();
+             // The journal's 22 ms erase stalls every interrupt: only with the drum still
+             // and no Modbus frame in flight
+             if (Motor_GetDuty() == 0 && !Motor_IsRamping() && !Modbus_IsBusy()) {
+                 Journal_Prepare();
+             }
+             break;
+ 
+         case WASHER_ERROR:
+             // No ramp on a fault: cut the drive at once, and do not resume after a reset
+             Speed_SetTarget(0);
+             Motor_Off();
+             Mixer_Stop();
+             Journal_Clear();
              break;
  
          case FILL_WATER:
-             Display_UpdateWasherState(FILL_WATER, washer->programIndex);
-             HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN, GPIO_PIN_SET);
-             HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_COLD_PIN, GPIO_PIN_SET);
- 
-             // Simulate a fill duration
-             if (currentTime - lastTime >= 10000) {  // 10s fill time (adjust as needed)
-                 HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
-                 washer->state = WASH;
-                 lastTime = currentTime;
+             // The mixer task drives the valves; the level decides when the fill is done
+             if (step == NULL) {
+                 Washer_Fail(washer, WASHER_FAULT_PROGRAM);
+                 break;
+             }
+             if (Washer_FillComplete(washer, step, currentTime)) {
+                 StepTimer_Cancel();
+                 Mixer_Stop();
+                 Washer_RunStep(washer, step, currentTime);
              }
              break;
  
          case WASH:
-             Display_UpdateWasherState(WASH, washer->programIndex);
-             // Motor control logic remains the same
-             washer->state = RINSE;
+         case RINSE:
+         case SPIN:
+             if (step == NULL) {
+                 Washer_Fail(washer, WASHER_FAULT_PROGRAM);
+                 break;
+             }
+             if (washer->state == SPIN) {
+                 Washer_Spin(washer, step, currentTime);
+             } else {
+                 Washer_Agitate(washer, Program_GetAgitation(step->agitation), currentTime);
+             }
+             if (currentTime - washer->journalTimer >= JOURNAL_CHECKPOINT_MS) {
+                 Washer_Checkpoint(washer, currentTime - washer->timer, currentTime);
+             }
              break;
  
-         case RINSE:
-             Display_UpdateWasherState(RINSE, washer->programIndex);
-             // Motor control logic remains the same
-             washer->state = SPIN;
+         default:
+             Washer_Fail(washer, WASHER_FAULT_PROGRAM);
              break;
+     }
+     Washer_Publish(washer);
+ }
  
-         case SPIN:
-             Display_UpdateWasherState(SPIN, washer->programIndex);
-             HAL_GPIO_WritePin(MOTOR_GPIO_PORT, MOTOR_FORWARD_PIN, GPIO_PIN_SET);
-             HAL_GPIO_WritePin(MOTOR_GPIO_PORT, MOTOR_REVERSE_PIN, GPIO_PIN_RESET);
-             washer->state = IDLE;
+ // Step deadline from TIM14: the fill timed out or the running step has finished
+ void Washer_HandleStepTimer(WasherControl *washer, uint8_t sequence) {
+     uint32_t currentTime = HAL_GetTick();
+ 
+     // Ignore deadlines cancelled or replaced after they were queued
+     if (!StepTimer_IsCurrent(sequence)) {
+         return;
+     }
+     switch (washer->state) {
+         case FILL_WATER:
+             // Fill timeout: valves were already closed by the interrupt
+             Mixer_Stop();
+             Washer_Fail(washer, WASHER_FAULT_FILL_TIMEOUT);
              break;
  
-         case ERROR:
-             Display_UpdateWasherState(ERROR, washer->programIndex);
-             HAL_GPIO_WritePin(MOTOR_GPIO_PORT, MOTOR_FORWARD_PIN | MOTOR_REVERSE_PIN, GPIO_PIN_RESET);
-             HAL_GPIO_WritePin(WATER_GPIO_PORT, WATER_HOT_PIN | WATER_COLD_PIN, GPIO_PIN_RESET);
+         case WASH:
+         case RINSE:
+         case SPIN:
+             washer->stepIndex++;
+             Washer_StartStep(washer, currentTime);
              break;
  
          default:
-             washer->state = ERROR;
              break;
      }
+     Washer_Publish(washer);
  }
  
  // Handle button inputs
- void Washer_HandleButtonPress(WasherControl *washer, int button) {
-     if (button == BUTTON_START && washer->state == IDLE) {
-         washer->state = FILL_WATER;
+ void Washer_HandleButtonPress(WasherControl *washer, int button, ButtonAction action) {
+     // Act on presses; only Up/Down also step on auto-repeat while held
+     if (action != BUTTON_PRESSED &&
+         !(action == BUTTON_REPEAT && (button == BUTTON_UP || button == BUTTON_DOWN))) {
+         return;
+     }
+ 
+     if (button == BUTTON_START && (washer->state == IDLE || washer->state == DONE)) {
+         washer->stepIndex = 0;
+         washer->fault = WASHER_FAULT_NONE;
+         Washer_StartStep(washer, HAL_GetTick());
          Display_UpdateWasherState(washer->state, washer->programIndex);
      } else if (button == BUTTON_STOP) {
+         StepTimer_Cancel();
+         Washer_AllOff();
          washer->state = IDLE;
+         washer->stepIndex = 0;
+         washer->resumeMs = 0;
+         Journal_Clear();
          Display_UpdateWasherState(washer->state, washer->programIndex);
      } else if (button == BUTTON_UP && washer->state == IDLE) {
-         if (washer->programIndex < 29) {
+         if (washer->programIndex < PROGRAM_COUNT - 1) {
              washer->programIndex++;
              Display_ShowSelectedProgram(washer->programIndex);
          }
@@ -154,5 +522,5 @@
              Display_ShowSelectedProgram(washer->programIndex);
          }
      }
+     Washer_Publish(washer);
  }
- 
\ No newline at end of file
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Flash and RAM use per module from a GNU ld map file.
+
+Link the firmware with -Wl,-Map=<image>.map (both build profiles, ramfunc.h),
+then run it on the map; `make -C target map [PROFILE=speed]` does both:
+
+    tools/map_report.py firmware.map
+    tools/map_report.py firmware.map --flash-budget 32768 --ram-budget 6144
+
+Every input section in the memory map is charged to the object it came from
+(archive members are grouped under the archive, e.g. libc_nano.a). An output
+section counts against the memory region holding its address; one loaded from
+another region (.data and the .RamFunc code inside it) counts against both, so
+RAM-resident code and initialised data show up in flash as well.
+
+Without a Memory Configuration (a host link) regions are guessed from the
+section names: .bss and .tbss are RAM, .data is both, other allocated sections
+are flash. `make -C host map` runs it on the simulator's link map.
+
+With LTO the compiled code is charged to the ltrans partitions rather than to
+the source modules; compare per-module numbers in the size profile, and use the
+speed profile's totals.
+
+Exit status is 1 when a budget is given and exceeded.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+HEX = r"0x[0-9a-fA-F]+"
+REGION_RE = re.compile(r"^(\S+)\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+\S+)?\s*$")
+OUTPUT_RE = re.compile(r"^(\.\S+|\S+)\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?\s*$")
+OUTPUT_NAME_RE = re.compile(r"^(\.\S+)\s*$")
+OUTPUT_TAIL_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+INPUT_NAME_RE = re.compile(r"^ (\S+)\s*$")
+INPUT_TAIL_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+FILL_RE = re.compile(r"^ \*fill\*\s+(" + HEX + r")\s+(" + HEX + r")")
+
+IGNORED = (".debug", ".comment", ".note", ".ARM.attributes", ".stab", ".gnu_debug",
+           ".symtab", ".strtab", ".shstrtab", "/DISCARD/")
+RAM_SECTIONS = (".bss", ".tbss", "._user_heap_stack", ".noinit")
+BOTH_SECTIONS = (".data", ".tdata")
+
+
+def module_name(path):
+    """Object file or archive a section came from, without the directory."""
+    path = path.strip()
+    member = re.match(r"^(.*\.a)\((.*)\)$", path)
+    if member:
+        return os.path.basename(member.group(1))
+    return os.path.basename(path)
+
+
+def parse_regions(lines):
+    regions = []
+    in_config = False
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            in_config = True
+            continue
+        if in_config:
+            if line.startswith("Linker script and memory map"):
+                break
+            match = REGION_RE.match(line)
+            if match and match.group(1) not in ("Name", "*default*"):
+                regions.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16)))
+    return regions
+
+
+def region_of(regions, address):
+    for name, origin, length in regions:
+        if origin <= address < origin + length:
+            return name
+    return None
+
+
+def guess_regions(section):
+    if section.startswith(RAM_SECTIONS):
+        return ["RAM"]
+    if section.startswith(BOTH_SECTIONS):
+        return ["FLASH", "RAM"]
+    return ["FLASH"]
+
+
+def parse_map(lines, regions):
+    """Yield (module, [regions], size) for every input section in the memory map."""
+    in_map = False
+    section = None
+    charged = []
+    pending_output = None
+    pending_input = None
+
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            in_map = True
+            continue
+        if not in_map:
+            continue
+
+        # Output sections start in column 0; long names continue on the next line
+        if pending_output is not None:
+            tail = OUTPUT_TAIL_RE.match(line)
+            pending_name = pending_output
+            pending_output = None
+            if tail:
+                section, charged = start_output(regions, pending_name, tail.group(1), tail.group(3))
+                continue
+        if line and not line[0].isspace():
+            named = OUTPUT_NAME_RE.match(line)
+            if named:
+                pending_output = named.group(1)
+                section, charged = None, []
+                continue
+            match = OUTPUT_RE.match(line)
+            if match:
+                section, charged = start_output(regions, match.group(1), match.group(2), match.group(4))
+            else:
+                section, charged = None, []
+            continue
+        if section is None or not charged:
+            continue
+
+        # Input sections are indented by one space; long names wrap the same way
+        if pending_input is not None:
+            tail = INPUT_TAIL_RE.match(line)
+            pending_input = None
+            if tail:
+                yield module_name(tail.group(3)), charged, int(tail.group(2), 16)
+                continue
+        fill = FILL_RE.match(line)
+        if fill:
+            yield "(fill)", charged, int(fill.group(2), 16)
+            continue
+        match = INPUT_RE.match(line)
+        if match and not match.group(4).startswith("0x"):
+            yield module_name(match.group(4)), charged, int(match.group(3), 16)
+            continue
+        if INPUT_NAME_RE.match(line):
+            pending_input = line.strip()
+
+
+def start_output(regions, name, address, load):
+    """Regions an output section is charged to, or [] to skip it."""
+    if name.startswith(IGNORED):
+        return None, []
+    if not regions:
+        return name, guess_regions(name)
+    charged = []
+    vma = region_of(regions, int(address, 16))
+    if vma is not None:
+        charged.append(vma)
+    if load is not None:
+        lma = region_of(regions, int(load, 16))
+        if lma is not None and lma not in charged:
+            charged.append(lma)
+    return name, charged
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", help="GNU ld map file (-Wl,-Map=...)")
+    parser.add_argument("--flash-budget", type=int, help="fail if flash use exceeds this many bytes")
+    parser.add_argument("--ram-budget", type=int, help="fail if RAM use exceeds this many bytes")
+    args = parser.parse_args()
+
+    with open(args.map, encoding="utf-8", errors="replace") as handle:
+        lines = handle.read().splitlines()
+
+    regions = parse_regions(lines)
+    names = [name for name, _, _ in regions] or ["FLASH", "RAM"]
+    flash = next((n for n in names if "FLASH" in n.upper() or "ROM" in n.upper()), names[0])
+    ram = next((n for n in names if "RAM" in n.upper() and n != flash), names[-1])
+
+    usage = {}
+    for module, charged, size in parse_map(lines, regions):
+        if size == 0:
+            continue
+        row = usage.setdefault(module, {})
+        for region in charged:
+            row[region] = row.get(region, 0) + size
+
+    columns = [flash, ram] + [n for n in names if n not in (flash, ram)]
+    width = max([len("module")] + [len(m) for m in usage])
+    print("%-*s %s" % (width, "module", " ".join("%10s" % c for c in columns)))
+    totals = dict.fromkeys(columns, 0)
+    for module in sorted(usage, key=lambda m: (-usage[m].get(flash, 0), m)):
+        row = usage[module]
+        print("%-*s %s" % (width, module, " ".join("%10d" % row.get(c, 0) for c in columns)))
+        for c in columns:
+            totals[c] += row.get(c, 0)
+    print("%-*s %s" % (width, "total", " ".join("%10d" % totals[c] for c in columns)))
+
+    lengths = {name: length for name, _, length in regions}
+    if lengths:
+        print("%-*s %s" % (width, "used %", " ".join(
+            "%10.1f" % (100.0 * totals[c] / lengths[c]) if lengths.get(c) else "%10s" % "-" for c in columns)))
+
+    failed = False
+    for budget, region in ((args.flash_budget, flash), (args.ram_budget, ram)):
+        if budget is not None and totals.get(region, 0) > budget:
+            print("%s: %d bytes over the budget of %d" % (region, totals[region] - budget, budget), file=sys.stderr)
+            failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())